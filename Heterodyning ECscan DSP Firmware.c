@@ -73,6 +73,7 @@ void IRQ_aliveTimer(int sigint)
 	int i;
 	static int onoff=0;
 	static int alive_duty_cycle=0;
+	PROF_ENTER(PROF_ALIVE);
 	// Clears Timer interrupt
 	*pTMSTAT &= TIM1IRQ;
 	
@@ -92,7 +93,7 @@ void IRQ_aliveTimer(int sigint)
 		onoff=0;
 	}
 */
-
+	PROF_EXIT(PROF_ALIVE);
 }
 
 /************************************************************
@@ -113,7 +114,7 @@ void Alive_timer_init (void)
     *pTM1PRD = ALIVE_TIMER_PRD;
     *pTM1W = *pTM1PRD/2;//(CNV_uSEC * TICKS_PER_uSEC-3); // 10% pulse
 	*pTM1STAT = TIM1EN;
-
+	DSP_profileRestart(PROF_ALIVE, ALIVE_TIMER_PRD*CCLK_PER_TIMER_TICK);
 	
     //*pDAI_IRPTL_PRI |= SRU_EXTMISCB0_INT;
     //*pDAI_IRPTL_RE |= SRU_EXTMISCB0_INT;
@@ -160,6 +161,7 @@ void main( void )
 	int j=0;
 	
 	int temp;
+	unsigned int lanes;
 	int timeout;
 	char *aux_ptr;
 	int usbdata,usbdata2,usbdata3,usbdata4;
@@ -230,6 +232,7 @@ void main( void )
 	
 
 	InitPLL();
+	InitSDRAM();
 	InitDDS_IO();
 
 	InitGAIN_IO();
@@ -335,6 +338,7 @@ void main( void )
 			//usbdata = usb_access(0, STATUS);
 		//	usbdata = usbdata& DATA_AVAI;
 //				usb_access(1, j++);
+			USB_txService();
 			if(USB_pollDataAvailable()){
 				if(USB_readStartOfPacket()){
 			//		ADC_StartSampling(1024, CNV_uSEC,adc_continuous_sampling);
@@ -382,6 +386,30 @@ void main( void )
 		}	
 */
 		
+		// Timestamp of the first sample, ahead of any data of the run
+		if(AR_timePending){
+			AR_timePending = FALSE;
+			process_sendTimestamp(TIMESTAMP_START, 0, AR_startTime);
+		}
+		
+		// Block processing mode demodulates the raw samples stored by the ADC interrupt
+		if(DSP_blockSize && AR_continuousSampling){
+			DSP_ProcessFullBuffer();
+		}else if(DSP_blockSize){
+			DSP_ProcessBlocks();
+		}
+		
+		// Continuous acquisition: ships the ring in chunks while sampling goes on,
+		// and what is left once it stops
+		if(AR_continuousSampling && DSP_blockSize == 0 && ADC_spillActive == FALSE){
+			ADC_ringSend();
+		}
+		
+		// Long capture: one SDRAM block to USB per pass
+		if(ADC_spillActive){
+			ADC_spillDrain();
+		}
+		
 		if(AR_finishedFlag){
 	//		SIG_LED1_OFF;
 	/*		DSP_ModeIQ_AmplitudePhase(adc_number_of_samples_to_send,adc_buffer_to_send,
@@ -423,7 +451,23 @@ void main( void )
 			//		printf("cal chA: %f, chB: %f\n",CAL_chA_calibration,CAL_chB_calibration);
 				}else{
 				//	signal_Calibrate(AR_bufferChA,AR_bufferChB,AR_bufferIndex);
-					if (SweepMode == TRUE){
+					if(AR_rawCapture == RAW_CAPTURE_VOLTS){
+						
+						// Deferred conversion of the packed words, then sent as usual
+						signal_ConvertRawCapture(AR_bufferIndex+1);
+					}
+					if(AR_rawCapture == RAW_CAPTURE_HOST){
+						
+						// Packed words, converted by the host. The run ends
+						// on AR_bufferIndex, so it holds AR_bufferIndex+1 words.
+						process_sendRawData(AR_bufferIndex+1);
+					}else if (SweepMode == TRUE && BANK_active){
+						
+						// Demodulation bank: last sample of every lane in one packet.
+						// A run ended before its first output has none.
+						lanes = (AR_bufferIndex+1 >= BANK_lanes) ? BANK_lanes : 0;
+						process_sendSampleData(lanes,(unsigned int*)&AR_bufferChA[AR_bufferIndex+1-lanes],(unsigned int*)&AR_bufferChB[AR_bufferIndex+1-lanes]);
+					}else if (SweepMode == TRUE){
 						
 						// If in sweep mode. Only send last sample of each channel.
 						process_sendSampleData(1,(unsigned int*)&AR_bufferChA[AR_bufferIndex],(unsigned int*)&AR_bufferChB[AR_bufferIndex]);
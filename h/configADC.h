@@ -43,7 +43,7 @@
 #define _CONFIGADC_H
 
 
-#include "..\h\general.h"
+#include "../h/general.h"
 
 
 #define GAIN_CS_H		SRU(HIGH,DAI_PB12_I)
@@ -92,6 +92,51 @@
 
 #define PCG_CLKD_DIVIDER 1
 #define PCG_TICKS_PER_uSEC (PCG_CLKD_DIVIDER)*25	
+#define ADC_FS_DIVIDER	250		// CNV period in PCG ticks at ADC_FS, the rate the filters are designed for
+#define ADC_RATE_MAX	8		// Slowest sample rate is ADC_FS/ADC_RATE_MAX
+
+// DMA receive mode. SPORT3 fills the raw samples ring through a chain of
+// TCBs, one per ADC_DMA_BLOCK samples, with one interrupt per block.
+#define ADC_DMA_BLOCK		256
+#define ADC_DMA_TCBS		(MAXSAMPLES/ADC_DMA_BLOCK)
+#define ADC_DMA_PCI			0x00080000	// Interrupt at the end of each TCB
+#define ADC_DMA_OFFSET		0x00080000
+#define ADC_DMA_FS_DELAY	75			// SPORT3 frame sync after CNV, in PCG ticks (3 us)
+
+// Oversampling in DMA receive mode: the ADC runs ADC_osr times faster and
+// each DMA block is averaged down to the output rate
+#define ADC_OSR_MAX			8			// Power of two, divides ADC_DMA_BLOCK
+#define ADC_FS_DIVIDER_MIN	100			// Fastest CNV period in PCG ticks (4 us)
+// so at ADC_FS_DIVIDER (10 us) the factor is at most 2: 4 needs a 20 us
+// period and 8 a 40 us one
+
+// Channel B of a raw ring word in volts. Oversampled runs store the sum of
+// ADC_osr samples shifted up by ADC_rawShift, with channel A in ADC_osrRingA
+// (ADC_OSR_VOLTS_A); otherwise ADC_rawShift is 16 and A is the low half.
+#define ADC_RAW_VOLTS_B(word)	(((int)((word)>>ADC_rawShift) - ADC_rawZeroB)*ADC_rawScale)
+#define ADC_OSR_VOLTS_A(word)	(((int)((word)>>ADC_rawShift) - ADC_rawZeroA)*ADC_rawScale)
+
+// Continuous acquisition ring between the ADC interrupt and the main loop
+#define ADC_RING_SIZE		2048		// Power of two
+#define ADC_RING_CHUNK		64			// Outputs per USB packet
+#define ADC_RING_SENDS		4			// Chunks queued to the USB at once
+
+// Keeps the ring data on its side of the index that hands it over. On the
+// DSP the producer is an interrupt of the same in-order core and the
+// indices are volatile; the host build runs the producer in a thread.
+#ifdef __ADSP21000__
+#define ADC_RING_FENCE()
+#else
+#define ADC_RING_FENCE()	__sync_synchronize()
+#endif
+
+// Continuous block mode fills sample_buffer_1/2 alternately
+#define ADC_PINGPONG_SIZE	4096		// Raw samples per buffer, up to MAXSAMPLES
+
+// Long capture: raw words staged internally and spilled to SDRAM by the
+// external port DMA, then drained to USB by the main loop
+#define ADC_SPILL_BLOCK		1024		// Raw words per DMA transfer and USB packet
+#define ADC_SPILL_BLOCKS	512			// SDRAM ring size in blocks, power of two (2 MB)
 
 
 
@@ -103,6 +148,26 @@
 // ADC Samples Memory Buffer
 //extern unsigned int SAMPLES_MEMORY[MAXSAMPLES];
 extern unsigned int * SAMPLES_MEMORY;
+extern unsigned int samples_memory_index;
+extern unsigned int ADC_rateFactor;
+extern unsigned int ADC_fsDivider;
+extern bool ADC_dmaMode;
+extern unsigned int ADC_oversampling;
+extern unsigned int ADC_osr;
+extern unsigned int ADC_rawShift;
+extern int ADC_rawZeroA;
+extern int ADC_rawZeroB;
+extern float ADC_rawScale;
+extern unsigned int * ADC_osrRingA;
+extern bool ADC_dmaActive;
+extern volatile bool ADC_sampling;
+extern volatile unsigned int ADC_ringHead;
+extern volatile unsigned int ADC_ringTail;
+extern unsigned int ADC_ringOverruns;
+extern unsigned int ADC_ringHighWater;
+extern bool ADC_spillMode;
+extern bool ADC_spillActive;
+extern unsigned int ADC_spillOverruns;
 
 
 // Global Acquired Samples Buffers
@@ -120,9 +185,13 @@ unsigned int adc_number_of_samples_to_send;
 unsigned char adc_send_continuous_samples; 	// Flag to send continuously acquired data
 
 // ADC Swap Buffer Signals
-unsigned char adc_sample_buffer_full;
+volatile unsigned char adc_sample_buffer_full;	// Set by the ADC interrupt, cleared by the main loop
 unsigned int * adc_sample_buffer_full_ptr;
 unsigned int adc_sample_buffer_full_number_of_samples;
+extern unsigned int adc_sample_buffer_sequence;	// Sequence number of the full buffer
+extern unsigned int ADC_bufferSequence;			// Sequence number of the buffer being filled
+extern unsigned int ADC_buffersDropped;
+extern unsigned long long adc_sample_buffer_time;	// Timestamp of the first sample of the full buffer
 
 
 
@@ -134,12 +203,29 @@ void GAIN_init(void);
 
 void IRQ_ADC_SampleReady(int sig_int);
 void IRQ_ADC_SampleDone(int sig_int);
+void ADC_SampleDone(void);
+void IRQ_ADC_BlockDone(int sig_int);
+void ADC_initDMA(void);
+void ADC_osrSet(unsigned int osr);
+unsigned int ADC_oversampleBlock(unsigned int * raw_buffer);
+void ADC_rawOverrun(void);
+void ADC_setSamplePeriod(unsigned int sample_period);
+void ADC_ringReset(void);
+int ADC_ringPut(float sampleA, float sampleB);
+unsigned int ADC_ringCount(void);
+unsigned int ADC_ringGet(float * bufferA, float * bufferB, unsigned int max_samples);
+int ADC_ringSend(void);
+void ADC_spillReset(void);
+void ADC_spillBlock(void);
+void IRQ_ADC_SpillDone(int sig_int);
+int ADC_spillDrain(void);
 void IRQ_ADC_AssertConversion(int sigint);
 
 
 void InitADC_IO(void);
 void ADC_StopSampling(void);
 void ADC_SwapBuffer(void);
+void ADC_FinishedAR(void);
 void ADC_StartSampling(unsigned int number_samples, unsigned int sample_period, char continuous_sampling);
 
 
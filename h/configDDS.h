@@ -39,7 +39,7 @@
 #define _CONFIGDDS_H
 
 
-#include "..\h\general.h"
+#include "../h/general.h"
 
 
 
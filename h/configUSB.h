@@ -19,7 +19,7 @@
 #define _CONFIGUSB_H
 
 
-#include "..\h\general.h"
+#include "../h/general.h"
 
 
 
@@ -38,6 +38,14 @@
 #define HC7     (BIT_13|BIT_12|BIT_11)
 
 #define USBADDR (int*)(0x08000001)	// USB ADDR, could be any address of external bank 2 
+#ifdef __ADSP21000__
+#define USB_PORT_WRITE(value)	(*USBADDR = (value))
+#define USB_PORT_READ()			(*USBADDR)
+#else
+// Host build: the FT2232H model of host/hostModel.c
+#define USB_PORT_WRITE(value)	HOST_usbWrite(value)
+#define USB_PORT_READ()			HOST_usbRead()
+#endif
 #define STATUS (0x1)		// Read USB STATUS register mask
 #define DATA (0x0)			// Read USB DATA mask
 
@@ -62,6 +70,22 @@
 
 #define USB_READ_TIMEOUT 100
 
+// FIFO write modes (USB_writeMode)
+// The FT2232H is 8 bit: D8-15 belong to channel B. A status poll that
+// shows space only guarantees room for one byte.
+#define USB_WRITE_SINGLE	0		// One status poll and one access per byte
+#define USB_WRITE_BURST		1		// Chip select held for USB_BURST_BYTES, a status read per byte
+#define USB_BURST_BYTES		64		// Bytes per chip select run
+// No external port DMA mode: with a status read per byte it takes an
+// interrupt per byte, more core time than USB_WRITE_BURST
+
+// Transmit queue (USB_txQueue)
+#define USB_TX_DEPTH		16		// Packets, a power of two
+#define USB_TX_HEADER		16		// Bytes of header copied per packet
+#define USB_TX_POLLS		8		// Status polls per USB_txService call
+
+#define USB_AMICTL2	(AMIEN | BW16 | WS20 |PREDIS | IC5 | RHC5 | HC5 | PKDIS | AMIFLSH)
+
 
 
 // USB Error messages
@@ -81,6 +105,24 @@
 #define USB_MSG_OPMODE			8
 #define USB_MSG_STEPPER_EN		9
 #define USB_MSG_ADC_SINGLESAMPLE 10
+#define USB_MSG_DECIMATION		11
+#define USB_MSG_BLOCKSIZE		12
+#define USB_MSG_FIROFFLOAD		13
+#define USB_MSG_DFT				14
+#define USB_MSG_BANK			15
+#define USB_MSG_ADCDMA			16
+#define USB_MSG_RINGSTATUS		17
+#define USB_MSG_RAWCAPTURE		18
+#define USB_MSG_SPILL			19
+#define USB_MSG_TIMESTAMPS		20
+#define USB_MSG_OVERSAMPLING	21
+#define USB_MSG_PROFILE			22
+#define USB_MSG_TRIGGER			23
+#define USB_MSG_USBMODE			24
+#define USB_MSG_ENCODING		31	// After the messages to the host, 25 to 30
+#define USB_MSG_CODECSTATUS		32
+#define USB_MSG_TXQUEUE			33
+#define USB_MSG_TXSTATUS		34
 
 
 
@@ -91,6 +133,7 @@
 #define USB_MSG_SET_GAIN_SIZE		3
 #define USB_MSG_CURRENT_SCALE_SIZE	2
 #define USB_MSG_ADC_SAMPLING_SIZE	11
+#define USB_MSG_ADC_SAMPLING_CODEC_SIZE	12	// With the optional compress byte
 #define USB_MSG_ADC_STOP_SAMPLING_SIZE	1
 #define USB_MSG_CALIBRATE_SIZE		1
 #define USB_MSG_DDS_POWERDOWN_SIZE	12//#!
@@ -99,10 +142,41 @@
 #define USB_MSG_OPMODE_SIZE	2
 #define USB_MSG_STEPPER_EN_SIZE	3
 #define USB_MSG_ADC_SINGLESAMPLE_SIZE		1
+#define USB_MSG_DECIMATION_SIZE		2
+#define USB_MSG_BLOCKSIZE_SIZE		3
+#define USB_MSG_FIROFFLOAD_SIZE		2
+#define USB_MSG_DFT_SIZE			5
+#define USB_MSG_BANK_SIZE			(2+4*BANK_LANES_MAX)
+#define USB_MSG_ADCDMA_SIZE			2
+#define USB_MSG_RINGSTATUS_SIZE		1
+#define USB_MSG_RAWCAPTURE_SIZE		2
+#define USB_MSG_SPILL_SIZE			2
+#define USB_MSG_TIMESTAMPS_SIZE		2
+#define USB_MSG_OVERSAMPLING_SIZE	2
+#define USB_MSG_PROFILE_SIZE		2
+#define USB_MSG_TRIGGER_SIZE		14
+#define USB_MSG_USBMODE_SIZE		2
+#define USB_MSG_ENCODING_SIZE		2
+#define USB_MSG_CODECSTATUS_SIZE	2
+#define USB_MSG_TXQUEUE_SIZE		2
+#define USB_MSG_TXSTATUS_SIZE		2
 
 
 
 #define USB_MSG_SENDSAMPLEDATA 25
+#define USB_MSG_SENDBLOCKDATA 26
+#define USB_MSG_SENDRAWDATA 27
+#define USB_MSG_SENDSPILLDATA 28
+#define USB_MSG_SENDTIMESTAMP 29
+#define USB_MSG_SENDSTEPDATA 30
+
+extern int USB_writeMode;
+extern bool USB_txEnabled;
+extern unsigned int USB_txHead;
+extern unsigned int USB_txTail;
+extern unsigned int USB_txHighWater;
+extern unsigned int USB_txDropped;
+extern unsigned int USB_txSent;
 
 // Function prototypes
 void InitUSB_IO(void);
@@ -115,6 +189,15 @@ int USB_readPayload(unsigned short usb_size, unsigned char * payload_buffer);
 int USB_access(char access, char readwrite, char data);
 int USB_sendADCData(int buffer_size, unsigned int * buffer);
 int USB_writeBuffer(int buffer_size, unsigned char * buffer);
+void USB_burstStart(void);
+void USB_burstEnd(void);
+int USB_burstStatus(void);
+int USB_burstWrite(int value);
+int USB_txQueue(int header_size, unsigned char * header, unsigned int words_a, unsigned int * buffer_a,
+				unsigned int words_b, unsigned int * buffer_b, bool droppable);
+int USB_txNextByte(void);
+void USB_txService(void);
+int USB_txFlush(void);
 int USB_purge(void);
 
 
@@ -18,7 +18,7 @@
 #define _CONFIGXY_H
 
 
-#include "..\h\general.h"
+#include "../h/general.h"
 
 
 // IO Definitions
@@ -89,5 +89,18 @@
 #define MODE_CW			1
 #define MODE_CCW		0
 
+// Core cycle timestamps of the last move (DSP_timestamp)
+extern unsigned long long XY_moveStartTime;
+extern unsigned long long XY_moveEndTime;
+
+// Triggered acquisition: one capture per step, see XY_triggeredCapture
+#define XY_TRIGGER_SETTLE_MAX	100000		// us
+extern bool XY_triggerMode;
+extern unsigned int XY_triggerSettle;
+extern unsigned int XY_triggerSamples;
+extern unsigned int XY_triggerPeriod;
+extern unsigned int XY_triggerStep;
+void XY_triggeredCapture(void);
+
 
 #endif
\ No newline at end of file
@@ -38,6 +38,8 @@
 //#include <filter.h>
 
 //#include <initPLL.h> 
+void InitPLL(void);
+void InitSDRAM(void);
 
 
 //#include <services/int/adi_int.h>
@@ -35,11 +35,16 @@
 #define TAPS_FIR 159
 #define TAPS_FIR_LP 283//153
 
+// Polyphase decimating low pass filter
+#define DECIMATION_MAX		64
+#define TAPS_FIR_LP_POLY	(TAPS_FIR_LP+DECIMATION_MAX)
+
 #define MAX_SAMPLES_BUFFER_SIZE 8192 // 8192+5
 #define USB_MAX_PAYLOAD_SIZE	300
 #define USB_MAX_ACK_SIZE	10
 #define MODE_IQ 0
 #define MODE_IF 1
+#define MODE_DFT 2
 
 
 // Acquisition Run
@@ -51,6 +56,81 @@ extern unsigned int AR_bufferIndex;
 extern float *AR_bufferChA;
 extern float *AR_bufferChB;
 
+// Raw SPORT3 words stored by the ADC interrupt in block processing mode
+extern volatile unsigned int AR_rawIndex;
+extern unsigned int AR_rawTotal;
+extern volatile bool AR_rawFinished;
+extern unsigned int AR_rawOverruns;
+
+// Packed raw capture: the ADC interrupt keeps the SPORT3 word (chB<<16 | chA)
+// in the sample buffers instead of two floats
+#define RAW_CAPTURE_OFF		0
+#define RAW_CAPTURE_HOST	1	// Packed words sent to the host, up to RAW_CAPTURE_MAX samples
+#define RAW_CAPTURE_VOLTS	2	// Converted to volts after the run, up to MAX_SAMPLES_BUFFER_SIZE
+#define RAW_CAPTURE_MAX		(2*MAX_SAMPLES_BUFFER_SIZE)
+#define RAW_VOLTS_PER_LSB	(2.5/65536)
+extern char AR_rawCaptureMode;
+extern char AR_rawCapture;
+extern unsigned int *AR_rawCapturePtr;
+
+// Wire encoding of the float sample packets, negotiated by USB
+#define ENCODE_FLOAT32		0	// IEEE floats, the original format
+#define ENCODE_INT16		1	// int16 times a per packet scale
+#define ENCODE_INT24		2	// int24 times a per packet scale
+#define ENCODE_DELTA		3	// Lossless delta codec, per acquisition (AR_compress)
+#define ENCODE_CHUNK		256	// Samples per conversion pass, a multiple of 4
+#define CODEC_BLOCK			32	// Samples sharing one bit width
+#define CODEC_WIDTH_BITS	6	// Bits of each width field, widths are 0 to 32
+extern char DSP_sampleEncoding;
+extern int ENC_quantized[ENCODE_CHUNK];
+extern unsigned int ENC_packed[ENCODE_CHUNK];
+extern bool AR_compress;
+extern unsigned int CODEC_samples;
+extern unsigned int CODEC_rawBytes;
+extern unsigned int CODEC_packedBytes;
+extern unsigned int CODEC_cycles;
+extern unsigned int CODEC_sendCycles;
+
+// Timestamps from the core cycle counter (EMUCLK2:EMUCLK), in CCLK cycles
+#define CCLK_PER_PCG_TICK		16		// 400 MHz core clock, 25 MHz PCG clock
+#define CCLK_PER_TIMER_TICK		2		// General purpose timers run on PCLK
+#define CCLK_PER_uSEC			400
+#define TIMESTAMP_START			0		// First sample of an acquisition run
+#define TIMESTAMP_BLOCK			1		// First sample of a ping-pong or SDRAM block
+#define TIMESTAMP_MOVE_START	2		// First step of an XY move
+#define TIMESTAMP_MOVE_END		3		// Last step of an XY move
+extern bool DSP_timestamps;
+extern unsigned long long AR_startTime;
+extern volatile bool AR_timeArmed;
+extern volatile bool AR_timePending;
+
+// ISR profiler. Uncomment DSP_PROFILE to add the instrumentation to the
+// ISRs; without it the statistics stay at 0.
+//#define DSP_PROFILE
+#define PROF_ADC_SAMPLE		0		// IRQ_ADC_SampleDone
+#define PROF_ADC_BLOCK		1		// IRQ_ADC_BlockDone
+#define PROF_STEPPER		2		// IRQ_stepperTimer
+#define PROF_ALIVE			3		// IRQ_aliveTimer
+#define PROF_ISRS			4
+#define PROF_BUCKETS		8		// Bucket k counts durations below 2^(k+PROF_BUCKET_LOG2) cycles
+#define PROF_BUCKET_LOG2	7		// the last one everything above
+#ifdef DSP_PROFILE
+#define PROF_ENTER(isr)		unsigned int prof_entry = DSP_cycles()
+#define PROF_EXIT(isr)		DSP_profile(isr, prof_entry, DSP_cycles())
+#else
+#define PROF_ENTER(isr)
+#define PROF_EXIT(isr)
+#endif
+extern unsigned int PROF_count[PROF_ISRS];
+extern unsigned int PROF_min[PROF_ISRS];
+extern unsigned int PROF_max[PROF_ISRS];
+extern unsigned int PROF_maxGap[PROF_ISRS];
+extern unsigned int PROF_missed[PROF_ISRS];
+extern unsigned int PROF_deadline[PROF_ISRS];
+extern unsigned int PROF_hist[PROF_ISRS][PROF_BUCKETS];
+extern unsigned int PROF_lastEntry[PROF_ISRS];
+extern bool PROF_gapValid[PROF_ISRS];
+
 // DC decimal values of the ADC inputs when there is no signal present.
 #define CAL_CHA_DECIMAL	27420
 #define CAL_CHB_DECIMAL 27830
@@ -100,9 +180,85 @@ extern float dm FIR_BPstatesChA[TAPS_FIR];
 extern float dm FIR_BPstatesChB[TAPS_FIR];
 
 extern float pm LP_FIR_coeffs[TAPS_FIR_LP];
+extern float pm LP_FIR_design[TAPS_FIR_LP];
 extern float dm FIR_LPstatesChA[TAPS_FIR_LP];
 extern float dm FIR_LPstatesChB[TAPS_FIR_LP];
 
+// Paired (SIMD) FIR for the A/B channels. Comment to use two fir() calls.
+#define DSP_PAIRED_FIR
+
+extern float pm BP_FIR_coeffs2[2*TAPS_FIR];
+extern float dm FIR_BPstatesAB[4*TAPS_FIR];
+extern int FIR_BPindexAB;
+extern float pm LP_FIR_coeffs2[2*TAPS_FIR_LP];
+extern float dm FIR_LPstatesAB[4*TAPS_FIR_LP];
+extern int FIR_LPindexAB;
+
+extern unsigned int DSP_decimation;
+extern unsigned int DSP_decimationRequest;
+extern float pm POLY_LP_coeffs[TAPS_FIR_LP_POLY];
+extern float dm POLY_LPstatesChA[2*TAPS_FIR_LP_POLY];
+extern float dm POLY_LPstatesChB[2*TAPS_FIR_LP_POLY];
+
+// Block demodulation pipeline
+#define DSP_BLOCK_MAX		1024
+extern unsigned int DSP_blockSize;
+extern unsigned int DSP_blockIndex;
+extern unsigned int DSP_outputOverflows;
+extern float dm DSP_blockI[TAPS_FIR_LP-1+DSP_BLOCK_MAX];
+extern float dm DSP_blockQ[TAPS_FIR_LP-1+DSP_BLOCK_MAX];
+
+// FIR accelerator offload of the block low pass filter
+#define FIR_ACC_WINDOW		512
+#define FIR_ACC_INPUT		(TAPS_FIR_LP-1+FIR_ACC_WINDOW)
+#define FIR_ACC_SETS		2
+#define FIR_ACC_IDLE		0	// Owned by the core, free to fill
+#define FIR_ACC_QUEUED		1	// Filled, waiting for the accelerator
+#define FIR_ACC_BUSY		2	// Being filtered by the accelerator
+#define FIR_ACC_DONE		3	// Filtered, outputs to be read by the core
+extern bool DSP_firOffload;
+extern bool DSP_firOffloadActive;
+extern volatile int FIR_ACCstate[FIR_ACC_SETS];
+extern int FIR_ACCwindow[FIR_ACC_SETS];
+extern int FIR_ACCphase[FIR_ACC_SETS];
+extern float FIR_ACCinI[FIR_ACC_SETS][FIR_ACC_INPUT];
+extern float FIR_ACCinQ[FIR_ACC_SETS][FIR_ACC_INPUT];
+extern float FIR_ACCoutI[FIR_ACC_SETS][FIR_ACC_WINDOW];
+extern float FIR_ACCoutQ[FIR_ACC_SETS][FIR_ACC_WINDOW];
+
+// Overlap-save FFT convolution of the block low pass filter
+#define DSP_PI				3.14159265358979
+#define OLS_FFT_SIZE		1024
+#define OLS_FFT_LOG2		10
+#define OLS_VALID			(OLS_FFT_SIZE-TAPS_FIR_LP+1)	// Outputs per FFT
+#define DSP_ENGINE_DIRECT	0
+#define DSP_ENGINE_OLS		1
+extern char DSP_filterEngine;
+extern float dm OLS_in[2*OLS_FFT_SIZE];
+extern float dm OLS_work[2*OLS_FFT_SIZE];
+extern float pm OLS_H[2*OLS_FFT_SIZE];
+extern float pm OLS_twiddles[OLS_FFT_SIZE];
+
+// Single bin sliding DFT demodulation (MODE_DFT)
+#define DFT_WINDOW_MAX		1024
+extern unsigned int DFT_window;
+extern unsigned int DFT_outputRate;
+extern unsigned int DFT_windowRequest;
+extern unsigned int DFT_outputRateRequest;
+extern float dm DFT_ringI[DFT_WINDOW_MAX];
+extern float dm DFT_ringQ[DFT_WINDOW_MAX];
+
+// Multi frequency demodulation bank
+#define BANK_LANES_MAX		4
+#define BANK_STRIDE			(2*BANK_LANES_MAX)	// I/Q of every lane for one tap
+extern unsigned int BANK_lanes;
+extern unsigned int BANK_lanesRequest;
+extern bool BANK_active;
+extern unsigned int BANK_if_inc[BANK_LANES_MAX];
+extern unsigned int BANK_lut_inc[BANK_LANES_MAX];
+extern unsigned int BANK_lut_acc[BANK_LANES_MAX];
+extern float dm BANK_states[2*TAPS_FIR_LP*BANK_STRIDE];
+
 
 extern float BIQUAD_stateChA[NSTATE];
 extern float BIQUAD_stateChB[NSTATE];
@@ -112,11 +268,33 @@ extern float  pm BIQUAD_coeffs[BIQUAD_TAPS*NSECTIONS];
 
 
 // Internal DDS Variables and memory allocation
-#define SINE_VALUES_SIZE 4096
-#define SINE_VALUES_90_DELAY 1024
+// Quarter wave sine table, sin(2*pi*k/4096) for k = 0..1024. Same
+// resolution as a full 4096 entry table. sine_quarter1025.txt is written by
+// host/sineTable.c. Comment SINE_INTERPOLATE for truncated lookups.
+#define SINE_QUARTER_BITS	10
+#define SINE_QUARTER_SIZE	(1<<SINE_QUARTER_BITS)
+#define SINE_QUARTER_SHIFT	(32-2-SINE_QUARTER_BITS)
+#define SINE_FRACTION_MASK	((1<<SINE_QUARTER_SHIFT)-1)
+//#define SINE_INTERPOLATE
+
+// Block paths (mixer and bank) use a complex rotator LO instead of the
+// table, renormalized every LO_RENORM samples (power of two). Measured on
+// the host over 10^7 samples (test_lodrift): reseeded every DSP_BLOCK_MAX
+// samples, phase error < 1.4e-5 rad and magnitude error < 1e-6. Free
+// running, the phase drifts by 0.1 rad; the magnitude stays within 1e-6.
+//#define LO_ROTATOR
+#define LO_RENORM			32
+
+// Magnitude/phase kernels
+#define PHASE_FAST			0	// Phase error < 1e-3 rad, magnitude < 1e-3 relative
+#define PHASE_PRECISE		1	// Phase error < 1e-6 rad, magnitude to float precision
+#define CORDIC_ITERATIONS	24
+#define CORDIC_SHIFT		14			// 16 bit inputs scaled to keep 2 bits of headroom
+#define CORDIC_GAIN_Q16		39797		// 65536/1.6467602, inverse CORDIC gain
+extern unsigned int pm CORDIC_atan[CORDIC_ITERATIONS];
 extern unsigned int DDS_inc_Fex;
 extern unsigned int DDS_inc_Flo;
-extern float sine_values_lut[];
+extern float pm sine_quarter_lut[SINE_QUARTER_SIZE+1];
 extern unsigned int iDDS_lut_inc;
 extern unsigned int iDDS_lut_acc;
 
@@ -129,7 +307,7 @@ extern bool CAL_calibrateFlag;
 
 extern float memDSPBufferAmplitude[MAX_SAMPLES_BUFFER_SIZE];
 extern float memDSPBufferPhase[MAX_SAMPLES_BUFFER_SIZE];
-extern bool DSP_processingFIR;
+extern volatile bool DSP_processingFIR;
 extern unsigned char USB_PAYLOAD_BUFFER[USB_MAX_PAYLOAD_SIZE];
 extern unsigned char USB_ACK_BUFFER[USB_MAX_ACK_SIZE];
 
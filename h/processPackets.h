@@ -18,19 +18,58 @@
 #define _PROCESSPACKETS_H
 
 
-#include "..\h\general.h"
+#include "../h/general.h"
 
 
 
 
 
 int processDDSChangeFreq(unsigned short msg_size, unsigned char * msg_buffer);
+int processCalibrate(unsigned short msg_size, unsigned char * msg_buffer);
+int processMoveXY(unsigned short msg_size, unsigned char * msg_buffer);
+int processDriverEn(unsigned short msg_size, unsigned char * msg_buffer);
+int processStepperEn(unsigned short msg_size, unsigned char * msg_buffer);
+int processOpMode(unsigned short msg_size, unsigned char * msg_buffer);
+int processADCSingleSample(unsigned short msg_size, unsigned char * msg_buffer);
+int process_sendAcknowledge(unsigned char header);
+int process_sendSampleData(unsigned short sample_size, float * bufferChA, float * bufferChB);
 
 int processSetGain(unsigned short msg_size, unsigned char * msg_buffer);
 int processSetCurrentScale(unsigned short msg_size, unsigned char * msg_buffer);
 int processADCStartSampling(unsigned short msg_size, unsigned char * msg_buffer);
 int processADCStopSampling(unsigned short msg_size, unsigned char * msg_buffer);
 int USB_processPayload(unsigned short payload_size, unsigned char * payload_buffer);
+int processDecimation(unsigned short msg_size, unsigned char * msg_buffer);
+int processBlockSize(unsigned short msg_size, unsigned char * msg_buffer);
+int processFIROffload(unsigned short msg_size, unsigned char * msg_buffer);
+int processDFT(unsigned short msg_size, unsigned char * msg_buffer);
+int processBank(unsigned short msg_size, unsigned char * msg_buffer);
+int processADCDMA(unsigned short msg_size, unsigned char * msg_buffer);
+int processRingStatus(unsigned short msg_size, unsigned char * msg_buffer);
+int processRawCapture(unsigned short msg_size, unsigned char * msg_buffer);
+int process_sendRawData(unsigned int sample_size);
+int processSpill(unsigned short msg_size, unsigned char * msg_buffer);
+int processOversampling(unsigned short msg_size, unsigned char * msg_buffer);
+int processProfile(unsigned short msg_size, unsigned char * msg_buffer);
+int processTrigger(unsigned short msg_size, unsigned char * msg_buffer);
+int processUSBMode(unsigned short msg_size, unsigned char * msg_buffer);
+int processEncoding(unsigned short msg_size, unsigned char * msg_buffer);
+unsigned int process_sampleBytes(unsigned int sample_size, float * bufferChA, float * bufferChB);
+unsigned int process_deltaWords(unsigned int sample_size, unsigned int * buffer);
+void process_putBits(unsigned int value, int width);
+int process_sendDelta(unsigned int sample_size, unsigned int * buffer);
+int processCodecStatus(unsigned short msg_size, unsigned char * msg_buffer);
+int processTxQueue(unsigned short msg_size, unsigned char * msg_buffer);
+int processTxStatus(unsigned short msg_size, unsigned char * msg_buffer);
+int process_sendSamples(unsigned int sample_size, float * bufferChA, float * bufferChB);
+int processTimestamps(unsigned short msg_size, unsigned char * msg_buffer);
+int process_sendTimestamp(char event, unsigned int index, unsigned long long time);
+int process_sendSpillData(unsigned int sequence, unsigned int sample_size,
+						unsigned int * buffer);
+int process_sendStepData(unsigned int step, unsigned short sample_size,
+						float * bufferChA, float * bufferChB);
+int process_sendBlockData(unsigned int sequence, unsigned short sample_size,
+						float * bufferChA, float * bufferChB);
 
 
 
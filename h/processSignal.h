@@ -22,8 +22,69 @@
 
 
 int DSP_ModeIQ_AmplitudePhase(unsigned int buffer_size, unsigned int * samples_buffer,float * buffer_amplitude, float * buffer_phase);
+int DSP_MagnitudePhase(unsigned int buffer_size, float * bufferI, float * bufferQ,
+						float * buffer_amplitude, float * buffer_phase, int accuracy);
+int DSP_MagnitudePhaseCORDIC(unsigned int buffer_size, int * bufferI, int * bufferQ,
+						int * buffer_amplitude, unsigned int * buffer_phase);
+unsigned long long DSP_timestamp(void);
+unsigned int DSP_cycles(void);
+void DSP_profile(int isr, unsigned int entry, unsigned int exit);
+void DSP_profileRestart(int isr, unsigned int deadline);
+void DSP_profileClear(void);
 void IRQ_FIR();
 
+void fir_pair(float* sampleA_ptr, float* sampleB_ptr, float pm * coeffs2,
+						float dm * states2, int * index, int taps);
+int Init_FIR_pair(void);
+int Init_FIR_LPrate(unsigned int rate_factor);
+int Init_FIR_LPdecimator(unsigned int decimation);
+int signalFIR_decimate_lowpass(float* sampleA_ptr,float* sampleB_ptr);
+int signal_QuadratureDemodulation_InternalLO_PtbyPt (float* bufferA,float* bufferB,int index);
+
+int Init_DemodulateBlock(void);
+int signal_DemodulateBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB);
+int signal_ConvertBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB);
+int signal_ConvertRawCapture(unsigned int sample_size);
+float signal_EncodeScale(unsigned int sample_size, float * bufferA, float * bufferB, int encoding);
+int signal_EncodeWords(unsigned int sample_size, int encoding);
+int signal_EncodeSamples(unsigned int sample_size, float * buffer, float inv_scale, int encoding);
+int signal_DeltaBlock(unsigned int block_size, unsigned int * buffer, unsigned int previous);
+int signal_ProcessRawBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB);
+unsigned int signal_MaxOutputs(unsigned int block_size);
+void DSP_ProcessOverflow(void);
+int DSP_ProcessBlocks(void);
+int DSP_ProcessFullBuffer(void);
+int signal_MixBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferI, float * bufferQ);
+
+void signal_SinCos(unsigned int phase, float * sin_ptr, float * cos_ptr);
+void signal_RotatorSeed(unsigned int phase, unsigned int inc,
+						float * cos_ptr, float * sin_ptr, float * dcos_ptr, float * dsin_ptr);
+
+int Init_DFT(void);
+int signal_DFT_sample(float sample, float * sampleA_ptr, float * sampleB_ptr);
+int signal_QuadratureDemodulation_DFT_PtbyPt (float* bufferA,float* bufferB,int index);
+int signal_DFTBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB);
+
+int Init_Bank(void);
+int signal_BankBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB);
+
+void signal_FFT(float * data, int n);
+int Init_OLS(void);
+int signal_OLS_segment(int valid, float * bufferA, float * bufferB);
+int signal_OLS_filter(float * bufferI, float * bufferQ, unsigned int block_size,
+						float * bufferA, float * bufferB);
+int signal_OLS_flush(float * bufferA, float * bufferB);
+
+int Init_FIR_offload(void);
+void FIR_ACC_start(int set);
+int DSP_ProcessBlocksFIR(void);
+
 
 
 
@@ -0,0 +1,285 @@
+/***************************************************************
+	Filename:	hostDecode.c (PC side of the USB packets)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:	hostDecode.h
+
+	Purpose:	See hostDecode.h.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostDecode.h"
+#include "h/general.h"
+
+
+/************************************************************
+	Function:	unsigned int DECODE_int (const unsigned char * bytes)
+	Return:		Int field of a packet, most significant byte first
+************************************************************/
+unsigned int DECODE_int(const unsigned char * bytes)
+{
+	return (unsigned int)bytes[0]<<24 | bytes[1]<<16 | bytes[2]<<8 | bytes[3];
+}
+
+
+/************************************************************
+	Function:	int DECODE_next (const unsigned char * stream, unsigned int size,
+					unsigned int * offset, const unsigned char ** packet,
+					unsigned int * packet_size)
+	Argument:	stream, size - Bytes read by the PC
+				offset - Position in the stream, moved past the packet
+				packet - Set to the header byte of the packet
+				packet_size - Bytes of the packet from the header on
+	Return:		TRUE if a whole packet was found at offset, FALSE at
+		the end of the stream or on a byte that does not start one.
+************************************************************/
+int DECODE_next(const unsigned char * stream, unsigned int size, unsigned int * offset,
+				const unsigned char ** packet, unsigned int * packet_size)
+{
+	unsigned int length;
+
+	if(*offset + 5 > size || stream[*offset] != USB_START_OF_PACKET_TO_HOST){
+		return FALSE;
+	}
+	length = DECODE_int(&stream[*offset+1]);
+	if(length < 1 || *offset + 5 + length > size){
+		return FALSE;
+	}
+	*packet = &stream[*offset+5];
+	*packet_size = length;
+	*offset += 5 + length;
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:	unsigned int DECODE_samples (const unsigned char * data, unsigned int size,
+					int encoding, float * chA, float * chB, unsigned int max_samples)
+	Argument:	data, size - Sample payload, as sent by process_sendSamples
+				encoding - The format the PC asked for: ENCODE_FLOAT32,
+					ENCODE_INT16, ENCODE_INT24, or ENCODE_DELTA for
+					float32 with the codec (AR_compress)
+				chA, chB - Decoded samples
+	Return:		Samples per channel, 0 on a malformed payload
+	Description:	ENCODE_FLOAT32: channel A, then channel B, each
+		float least significant byte first.
+		ENCODE_INT16, ENCODE_INT24: byte encoding, int samples and
+		float scale, most significant byte first, then each channel
+		as little endian codes, zero padded to a whole word. A
+		sample is its sign extended code times scale.
+		ENCODE_DELTA: byte encoding and int samples, then each
+		channel as the bit stream of process_sendDelta, zero padded
+		to a whole word.
+************************************************************/
+static float decode_float(const unsigned char * bytes)
+{
+	unsigned int word = bytes[0] | bytes[1]<<8 | bytes[2]<<16 | (unsigned int)bytes[3]<<24;
+	float value;
+
+	memcpy(&value, &word, sizeof(value));
+	return value;
+}
+
+static int decode_code(const unsigned char * bytes, int encoding)
+{
+	if(encoding == ENCODE_INT16){
+		return (short)(bytes[0] | bytes[1]<<8);
+	}
+	return (int)((bytes[0]<<8 | bytes[1]<<16 | (unsigned int)bytes[2]<<24))>>8;
+}
+
+static unsigned int decode_bits(const unsigned char * data, unsigned int * position, int width)
+{
+	unsigned int value = 0;
+	int k;
+
+	for(k = 0; k < width; k++, (*position)++){
+		value |= (unsigned int)((data[*position>>3]>>(*position&7))&1)<<k;
+	}
+	return value;
+}
+
+static unsigned int decode_delta(const unsigned char * data, unsigned int size,
+				unsigned int samples, float * channel)
+{
+	unsigned int position = 0, k, code, word;
+	int width = 0;
+
+	if(size < 4){
+		return 0;
+	}
+	word = decode_bits(data, &position, 32);
+	memcpy(&channel[0], &word, sizeof(word));
+	for(k = 1; k < samples; k++){
+		if((k-1)%CODEC_BLOCK == 0){
+			if(position + CODEC_WIDTH_BITS > 8*size){
+				return 0;
+			}
+			width = decode_bits(data, &position, CODEC_WIDTH_BITS);
+		}
+		if(width > 32 || position + width > 8*size){
+			return 0;
+		}
+		code = decode_bits(data, &position, width);
+		word += (code>>1) ^ -(code&1);
+		memcpy(&channel[k], &word, sizeof(word));
+	}
+	return 4*((position+31)/32);
+}
+
+unsigned int DECODE_samples(const unsigned char * data, unsigned int size, int encoding,
+				float * chA, float * chB, unsigned int max_samples)
+{
+	unsigned int samples, k, width, channel_bytes;
+	unsigned int word;
+	float scale;
+
+	if(encoding == ENCODE_FLOAT32){
+		if(size%8 != 0 || size/8 > max_samples){
+			return 0;
+		}
+		samples = size/8;
+		for(k = 0; k < samples; k++){
+			chA[k] = decode_float(&data[4*k]);
+			chB[k] = decode_float(&data[4*(samples+k)]);
+		}
+		return samples;
+	}
+	if(encoding == ENCODE_DELTA){
+		if(size < 5 || data[0] != ENCODE_DELTA){
+			return 0;
+		}
+		samples = DECODE_int(&data[1]);
+		if(samples == 0 || samples > max_samples){
+			return 0;
+		}
+		channel_bytes = decode_delta(&data[5], size-5, samples, chA);
+		if(channel_bytes == 0){
+			return 0;
+		}
+		size -= 5 + channel_bytes;
+		return (size >= 4 && decode_delta(&data[5+channel_bytes], size, samples, chB) == size) ? samples : 0;
+	}
+	if((encoding != ENCODE_INT16 && encoding != ENCODE_INT24) || size < 9 || data[0] != encoding){
+		return 0;
+	}
+	samples = DECODE_int(&data[1]);
+	word = DECODE_int(&data[5]);
+	memcpy(&scale, &word, sizeof(scale));
+	width = encoding == ENCODE_INT16 ? 2 : 3;
+	channel_bytes = 4*((width*samples+3)/4);
+	if(samples > max_samples || size != 9 + 2*channel_bytes){
+		return 0;
+	}
+	for(k = 0; k < samples; k++){
+		chA[k] = decode_code(&data[9 + width*k], encoding)*scale;
+		chB[k] = decode_code(&data[9 + channel_bytes + width*k], encoding)*scale;
+	}
+	return samples;
+}
+
+
+/************************************************************
+	Function:	unsigned int DECODE_collect (const unsigned char * stream, unsigned int size,
+					int header, unsigned int skip, int encoding, float * chA, float * chB,
+					unsigned int max_samples, unsigned int * packets)
+	Argument:	header - Message of the sample packets to collect
+				skip - Bytes of fields between the header and the samples
+					(4 for the sequence of USB_MSG_SENDBLOCKDATA)
+				packets - Number of packets collected
+	Return:		Samples per channel of all the packets, appended in
+		order. Other packets are skipped.
+************************************************************/
+unsigned int DECODE_collect(const unsigned char * stream, unsigned int size, int header,
+				unsigned int skip, int encoding, float * chA, float * chB,
+				unsigned int max_samples, unsigned int * packets)
+{
+	unsigned int offset = 0, total = 0, packet_size;
+	const unsigned char * packet;
+
+	*packets = 0;
+	while(DECODE_next(stream, size, &offset, &packet, &packet_size)){
+		if(packet[0] != header || packet_size < 1 + skip){
+			continue;
+		}
+		total += DECODE_samples(&packet[1+skip], packet_size-1-skip, encoding,
+					&chA[total], &chB[total], max_samples-total);
+		(*packets)++;
+	}
+	return total;
+}
+
+
+/************************************************************
+	Function:	int DECODE_timestamp (const unsigned char * packet, unsigned int packet_size,
+					DECODE_stamp * stamp)
+	Argument:	packet, packet_size - As returned by DECODE_next
+	Return:		TRUE if the packet is a timestamp, decoded in stamp
+	Description:	Layout of process_sendTimestamp: byte event,
+		int index, int time high, int time low, int period.
+************************************************************/
+int DECODE_timestamp(const unsigned char * packet, unsigned int packet_size, DECODE_stamp * stamp)
+{
+	if(packet[0] != USB_MSG_SENDTIMESTAMP || packet_size != 18){
+		return FALSE;
+	}
+	stamp->event = packet[1];
+	stamp->index = DECODE_int(&packet[2]);
+	stamp->time = (unsigned long long)DECODE_int(&packet[6])<<32 | DECODE_int(&packet[10]);
+	stamp->period = DECODE_int(&packet[14]);
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:	unsigned int DECODE_times (const unsigned char * stream, unsigned int size,
+					int header, unsigned int skip, unsigned int sample_bytes, double step,
+					unsigned long long * times, unsigned int max_samples)
+	Argument:	header, skip - Data packets, as for DECODE_collect
+				sample_bytes - Bytes of one sample in the payload
+					(4 for a raw word)
+				step - ADC samples per sample of the payload, the
+					decimation of demodulated data, 1 for raw words
+				times - Core cycle time of each sample
+	Return:		Samples timed, in the order of DECODE_collect.
+		Samples sent before any acquisition timestamp get time 0.
+************************************************************/
+unsigned int DECODE_times(const unsigned char * stream, unsigned int size, int header,
+				unsigned int skip, unsigned int sample_bytes, double step,
+				unsigned long long * times, unsigned int max_samples)
+{
+	unsigned int offset = 0, total = 0, packet_size, samples, k, count = 0;
+	const unsigned char * packet;
+	DECODE_stamp stamp;
+	int timed = FALSE;
+
+	while(DECODE_next(stream, size, &offset, &packet, &packet_size)){
+		if(DECODE_timestamp(packet, packet_size, &stamp)){
+			if(stamp.event == TIMESTAMP_START || stamp.event == TIMESTAMP_BLOCK){
+				timed = TRUE;
+				count = 0;
+			}
+			continue;
+		}
+		if(packet[0] != header || packet_size < 1 + skip){
+			continue;
+		}
+		samples = (packet_size-1-skip)/sample_bytes;
+		for(k = 0; k < samples && total < max_samples; k++, count++){
+			times[total++] = timed ? stamp.time + (unsigned long long)(count*step*stamp.period + 0.5) : 0;
+		}
+	}
+	return total;
+}
+
+
+/************************************************************
+	Function:	double DECODE_seconds (unsigned long long cycles)
+	Return:		Core cycles in seconds
+************************************************************/
+double DECODE_seconds(unsigned long long cycles)
+{
+	return cycles/(CCLK_PER_uSEC*1e6);
+}
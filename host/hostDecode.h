@@ -0,0 +1,50 @@
+/***************************************************************
+	Filename:	hostDecode.h (PC side of the USB packets)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:
+
+	Purpose:	Splits the byte stream the PC reads from the FT2232H
+		into packets and decodes their sample payloads, as the PC
+		application does. Used by the host tests on HOST_usbCapture.
+
+		Packet:	byte USB_START_OF_PACKET_TO_HOST, int size (most
+			significant byte first), then size bytes, the first being
+			the message header.
+
+		Sample times: an acquisition timestamp (USB_MSG_SENDTIMESTAMP,
+			TIMESTAMP_START or TIMESTAMP_BLOCK) goes just before the
+			data it refers to. Sample k after it was taken at
+			time + k*period core cycles, counted across the packets
+			up to the next acquisition timestamp.
+
+***************************************************************/
+
+#ifndef _HOSTDECODE_H
+#define _HOSTDECODE_H
+
+unsigned int DECODE_int(const unsigned char * bytes);
+int DECODE_next(const unsigned char * stream, unsigned int size, unsigned int * offset,
+				const unsigned char ** packet, unsigned int * packet_size);
+unsigned int DECODE_samples(const unsigned char * data, unsigned int size, int encoding,
+				float * chA, float * chB, unsigned int max_samples);
+unsigned int DECODE_collect(const unsigned char * stream, unsigned int size, int header,
+				unsigned int skip, int encoding, float * chA, float * chB,
+				unsigned int max_samples, unsigned int * packets);
+
+// Timestamp packet, times in core cycles (DSP_timestamp)
+typedef struct {
+	int event;					// TIMESTAMP_START, TIMESTAMP_BLOCK, ...
+	unsigned int index;			// Block sequence number, or steps of a move
+	unsigned long long time;
+	unsigned int period;		// ADC sample period
+} DECODE_stamp;
+
+int DECODE_timestamp(const unsigned char * packet, unsigned int packet_size, DECODE_stamp * stamp);
+unsigned int DECODE_times(const unsigned char * stream, unsigned int size, int header,
+				unsigned int skip, unsigned int sample_bytes, double step,
+				unsigned long long * times, unsigned int max_samples);
+double DECODE_seconds(unsigned long long cycles);
+
+#endif
@@ -0,0 +1,627 @@
+/***************************************************************
+	Filename:	hostModel.c (host model of the ADSP-21489 board)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:	hostModel.h
+
+	Purpose:	Register file, interrupts, FT2232H FIFO, external
+		port DMA, FIR accelerator and SPORT3 of the host build.
+		See hostModel.h.
+
+***************************************************************/
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <Cdef21489.h>
+#include <def21489.h>
+
+#define HOST_DMA_OFFSET		0x00080000	// Internal memory offset of the SPORT TCB addresses
+#define HOST_DMA_PCI		0x00080000	// Interrupt flag of the SPORT chain pointers
+#define HOST_FIR_OFFSET		0x00080000	// Offset of CPFIR
+#define HOST_CP_LOADED		0x80000000	// Unused CP bit: set when the model loaded the chain pointer
+#define HOST_USB_RX_SIZE	4096
+
+volatile unsigned int HOST_regs[HOST_REGISTER_COUNT];
+
+// Interrupts
+static host_handler host_handlers[HOST_SIGNALS];
+static volatile int host_masked = 0;		// Model call or interrupt in progress
+static volatile int host_tickPending = 0;
+volatile unsigned int HOST_ticks = 0;
+
+// FT2232H
+static int host_a0 = 1;
+static int host_cs = 1;
+static unsigned char host_usbTx[HOST_USB_TX_SIZE];
+static unsigned int host_usbTxSize = HOST_USB_TX_SIZE;
+static unsigned int host_usbTxHead = 0;
+static unsigned int host_usbDrainNum = 1;
+static unsigned int host_usbDrainDen = 1;
+static unsigned int host_usbDrainAcc = 0;
+static unsigned char host_usbRx[HOST_USB_RX_SIZE];
+static unsigned int host_usbRxHead = 0;
+static unsigned int host_usbRxTail = 0;
+unsigned char HOST_usbCapture[HOST_USB_CAPTURE];
+volatile unsigned int HOST_usbCaptured = 0;
+volatile unsigned int HOST_usbLost = 0;
+volatile unsigned int HOST_usbChannelB = 0;
+volatile unsigned int HOST_usbSelects = 0;
+volatile unsigned int HOST_usbBadAccess = 0;
+volatile unsigned long long HOST_usbAccesses = 0;
+volatile unsigned int HOST_usbLevel = 0;
+volatile unsigned int HOST_usbMaxLevel = 0;
+
+// Background engines
+static unsigned int host_ep0Done = 0;		// Words of the EP0 transfer moved
+static unsigned int * host_sdramBase = 0;	// SDRAM window of EP0
+static unsigned int host_sdramWords = 0;
+volatile unsigned int HOST_sdramWritten = 0;
+volatile unsigned int HOST_sdramBadAccess = 0;
+static unsigned int * host_sportTcb = 0;	// TCB being filled by SPORT3 DMA
+static unsigned int host_sportDone = 0;
+volatile unsigned int HOST_firChains = 0;
+volatile unsigned int HOST_firTcbErrors = 0;
+static const unsigned int * host_adcWords = 0;	// Conversions of the ADC stream
+static unsigned int host_adcCount = 0;
+static unsigned int host_adcPerTick = 0;
+volatile unsigned int HOST_adcStreamed = 0;
+
+
+/************************************************************
+	Function:	static void host_enter (void), host_leave (void)
+	Description:	Bracket every model call the firmware makes.
+		A timer tick that arrives in between is run on the way
+		out, so a bus access is never split by the engines.
+************************************************************/
+static void host_enter(void)
+{
+	host_masked++;
+}
+
+static void host_leave(void)
+{
+	if(--host_masked == 0 && host_tickPending){
+		host_tickPending = 0;
+		HOST_hardware();
+	}
+}
+
+
+host_handler interrupt(int sig, host_handler handler)
+{
+	host_handler previous = host_handlers[sig];
+
+	host_handlers[sig] = (handler == SIG_IGN || handler == SIG_DFL) ? 0 : handler;
+	return previous;
+}
+
+host_handler interrupts(int sig, host_handler handler)
+{
+	return interrupt(sig, handler);
+}
+
+host_handler interruptf(int sig, host_handler handler)
+{
+	return interrupt(sig, handler);
+}
+
+
+/************************************************************
+	Function:	void HOST_raise (int sig)
+	Description:	Runs the handler of an interrupt. Interrupts
+		do not nest: ticks arriving meanwhile wait for it.
+************************************************************/
+void HOST_raise(int sig)
+{
+	host_enter();
+	if(host_handlers[sig]){
+		host_handlers[sig](sig);
+	}
+	host_leave();
+}
+
+
+static void host_tick(int sig)
+{
+	(void)sig;
+	if(host_masked){
+		host_tickPending = 1;
+		return;
+	}
+	HOST_hardware();
+}
+
+
+/************************************************************
+	Function:	void HOST_init (void)
+	Description:	Clears the model and starts the timer tick.
+************************************************************/
+void HOST_init(void)
+{
+	struct sigaction action;
+	struct itimerval timer;
+
+	memset((void*)HOST_regs, 0, sizeof(HOST_regs));
+	memset(host_handlers, 0, sizeof(host_handlers));
+	host_adcCount = 0;
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = host_tick;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGALRM, &action, 0);
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = HOST_TICK_USEC;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_REAL, &timer, 0);
+}
+
+
+/************************************************************
+	Function:	void HOST_sdram (unsigned int * base, unsigned int words)
+	Description:	Sets the SDRAM window EP0 may address and fills
+		it with HOST_SDRAM_GARBAGE, as found at power up.
+************************************************************/
+void HOST_sdram(unsigned int * base, unsigned int words)
+{
+	unsigned int n;
+
+	host_enter();
+	for(n = 0; n < words; n++){
+		base[n] = HOST_SDRAM_GARBAGE;
+	}
+	host_sdramBase = base;
+	host_sdramWords = words;
+	HOST_sdramWritten = 0;
+	HOST_sdramBadAccess = 0;
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_sru (const char * from, const char * to)
+	Description:	Follows the SRU connections to the FT2232H
+		pins: A0 on DAI_PB15, !CS on DAI_PB11.
+************************************************************/
+void HOST_sru(const char * from, const char * to)
+{
+	int level;
+
+	if(strcmp(from, "HIGH") == 0){
+		level = 1;
+	}else if(strcmp(from, "LOW") == 0){
+		level = 0;
+	}else{
+		return;
+	}
+	if(strcmp(to, "DAI_PB15_I") == 0){
+		host_a0 = level;
+	}else if(strcmp(to, "DAI_PB11_I") == 0){
+		if(host_cs && !level){
+			HOST_usbSelects++;
+		}
+		host_cs = level;
+	}
+}
+
+
+/************************************************************
+	Function:	static void host_usbAccess (void)
+	Description:	One access on the FT2232H bus. The PC reads
+		the TX FIFO at drain_num bytes per drain_den accesses.
+************************************************************/
+static void host_usbAccess(void)
+{
+	unsigned int tail;
+
+	HOST_usbAccesses++;
+	host_usbDrainAcc += host_usbDrainNum;
+	while(host_usbDrainAcc >= host_usbDrainDen && HOST_usbLevel > 0){
+		host_usbDrainAcc -= host_usbDrainDen;
+		tail = (host_usbTxHead + host_usbTxSize - HOST_usbLevel) % host_usbTxSize;
+		if(HOST_usbCaptured < HOST_USB_CAPTURE){
+			HOST_usbCapture[HOST_usbCaptured] = host_usbTx[tail];
+		}
+		HOST_usbCaptured++;
+		HOST_usbLevel--;
+	}
+	if(HOST_usbLevel == 0 && host_usbDrainAcc > host_usbDrainDen){
+		host_usbDrainAcc = host_usbDrainDen;
+	}
+}
+
+static void host_usbPut(unsigned int value)
+{
+	if(host_cs || host_a0){
+		HOST_usbBadAccess++;
+		host_usbAccess();
+		return;
+	}
+	if(value & 0xff00){
+		HOST_usbChannelB++;
+	}
+	if(HOST_usbLevel >= host_usbTxSize){
+		HOST_usbLost++;
+	}else{
+		host_usbTx[host_usbTxHead] = value&0xff;
+		host_usbTxHead = (host_usbTxHead + 1) % host_usbTxSize;
+		HOST_usbLevel++;
+		if(HOST_usbLevel > HOST_usbMaxLevel){
+			HOST_usbMaxLevel = HOST_usbLevel;
+		}
+	}
+	host_usbAccess();
+}
+
+
+/************************************************************
+	Function:	int HOST_usbRead (void)
+	Return:		Status register with A0 high, else the next
+		byte sent by the PC.
+************************************************************/
+int HOST_usbRead(void)
+{
+	int value = 0;
+
+	host_enter();
+	if(host_cs){
+		HOST_usbBadAccess++;
+	}else if(host_a0){
+		if(host_usbRxHead != host_usbRxTail){
+			value |= 0x0101;
+		}
+		if(HOST_usbLevel < host_usbTxSize){
+			value |= 0x0202;
+		}
+	}else if(host_usbRxHead != host_usbRxTail){
+		value = host_usbRx[host_usbRxTail++ % HOST_USB_RX_SIZE];
+	}
+	host_usbAccess();
+	host_leave();
+
+	return value;
+}
+
+
+/************************************************************
+	Function:	void HOST_usbWrite (int value)
+	Description:	Data write by the core. D0-7 go to channel A;
+		anything on D8-15 is counted in HOST_usbChannelB. A write
+		to a full FIFO is lost.
+************************************************************/
+void HOST_usbWrite(int value)
+{
+	host_enter();
+	host_usbPut(value);
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_usbReset (unsigned int tx_size, unsigned int drain_num,
+					unsigned int drain_den)
+	Description:	Empties the FIFOs and the capture, sets the TX
+		size and the rate the PC reads at. A rate of 0 stalls it.
+************************************************************/
+void HOST_usbReset(unsigned int tx_size, unsigned int drain_num, unsigned int drain_den)
+{
+	host_enter();
+	if(tx_size < 1 || tx_size > HOST_USB_TX_SIZE) tx_size = HOST_USB_TX_SIZE;
+	host_usbTxSize = tx_size;
+	host_usbTxHead = 0;
+	host_usbDrainNum = drain_num;
+	host_usbDrainDen = drain_den ? drain_den : 1;
+	host_usbDrainAcc = 0;
+	host_usbRxHead = host_usbRxTail = 0;
+	HOST_usbCaptured = 0;
+	HOST_usbLost = 0;
+	HOST_usbChannelB = 0;
+	HOST_usbSelects = 0;
+	HOST_usbBadAccess = 0;
+	HOST_usbAccesses = 0;
+	HOST_usbLevel = 0;
+	HOST_usbMaxLevel = 0;
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_usbRate (unsigned int drain_num, unsigned int drain_den)
+	Description:	Changes the rate the PC reads at and keeps the
+		FIFOs, as a PC that stalls and resumes.
+************************************************************/
+void HOST_usbRate(unsigned int drain_num, unsigned int drain_den)
+{
+	host_enter();
+	host_usbDrainNum = drain_num;
+	host_usbDrainDen = drain_den ? drain_den : 1;
+	host_usbDrainAcc = 0;
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_usbDrainAll (void)
+	Description:	The PC reads whatever is left in the TX FIFO.
+************************************************************/
+void HOST_usbDrainAll(void)
+{
+	unsigned int num, den;
+
+	host_enter();
+	num = host_usbDrainNum;
+	den = host_usbDrainDen;
+	host_usbDrainNum = host_usbDrainDen = 1;
+	while(HOST_usbLevel > 0){
+		host_usbAccess();
+		HOST_usbAccesses--;
+	}
+	host_usbDrainNum = num;
+	host_usbDrainDen = den;
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_usbHostSend (const unsigned char * bytes, unsigned int size)
+	Description:	Bytes written by the PC, read by the firmware.
+************************************************************/
+void HOST_usbHostSend(const unsigned char * bytes, unsigned int size)
+{
+	unsigned int k;
+
+	host_enter();
+	for(k = 0; k < size; k++){
+		host_usbRx[host_usbRxHead++ % HOST_USB_RX_SIZE] = bytes[k];
+	}
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	static int host_epDma (int budget)
+	Return:		Bus accesses used
+	Description:	External port DMA channel 0 between internal
+		and external memory, internal to external with TRAN set.
+		The address is a host one that must sit in the HOST_sdram
+		window when one is set. The interrupt is raised when the
+		count runs out.
+************************************************************/
+static int host_epDma(int budget)
+{
+	unsigned int * internal = (unsigned int *)(unsigned long)HOST_regs[HOST_REG_IIEP0];
+	unsigned int modify = HOST_regs[HOST_REG_IMEP0];
+	unsigned int count = HOST_regs[HOST_REG_ICEP0];
+	unsigned int * external;
+	int used = 0;
+
+	if(!(HOST_regs[HOST_REG_DMAC0] & DMAEN)){
+		host_ep0Done = 0;
+		return 0;
+	}
+	while(host_ep0Done < count && used < budget){
+		external = (unsigned int *)(unsigned long)HOST_regs[HOST_REG_EIEP0]
+					+ host_ep0Done*HOST_regs[HOST_REG_EMEP0];
+		if(host_sdramBase && (external < host_sdramBase
+					|| external >= host_sdramBase + host_sdramWords)){
+			HOST_sdramBadAccess++;
+		}else if(HOST_regs[HOST_REG_DMAC0] & TRAN){
+			*external = internal[host_ep0Done*modify];
+			HOST_sdramWritten++;
+		}else{
+			internal[host_ep0Done*modify] = *external;
+		}
+		host_ep0Done++;
+		used++;
+	}
+	if(host_ep0Done >= count){
+		host_ep0Done = 0;
+		HOST_regs[HOST_REG_DMAC0] &= ~DMAEN;
+		HOST_raise(SIG_EP0I);
+	}
+	return used;
+}
+
+
+/************************************************************
+	Function:	static int host_firAccelerator (void)
+	Return:		TRUE if a chain was run
+	Description:	FIR accelerator in DMA mode. CPFIR holds the
+		address of word 12 of the first TCB less HOST_FIR_OFFSET,
+		word 0 of each TCB the address of word 12 of the next, or
+		0 at the end of the chain. Per TCB:
+			[1] taps		[3] coefficients
+			[5] outputs		[7] output buffer
+			[9] input size	[11] input buffer, taps-1 history first
+			[12] taps-1 | (outputs-1)<<14
+		output[n] = sum coefficients[k]*input[n+taps-1-k]
+		SIG_P5 is raised at the end of the chain. A chain of other
+		than FIRCTL1 channels TCBs, or a TCB whose sizes disagree,
+		is counted in HOST_firTcbErrors.
+************************************************************/
+static int host_firAccelerator(void)
+{
+	unsigned int * tcb;
+	float * coeffs;
+	float * input;
+	float * output;
+	int taps, outputs, n, k;
+	float acc;
+	int channels = 0;
+
+	if((HOST_regs[HOST_REG_FIRCTL1] & (FIR_EN|FIR_DMAEN)) != (FIR_EN|FIR_DMAEN)){
+		return 0;
+	}
+	tcb = (unsigned int *)(unsigned long)(HOST_regs[HOST_REG_CPFIR] + HOST_FIR_OFFSET) - 12;
+	while(tcb){
+		taps = tcb[1];
+		coeffs = (float *)(unsigned long)tcb[3];
+		outputs = tcb[5];
+		output = (float *)(unsigned long)tcb[7];
+		input = (float *)(unsigned long)tcb[11];
+		if(tcb[9] != taps-1+outputs || tcb[12] != ((taps-1)|((outputs-1)<<14))
+				|| outputs < 1 || taps < 1){
+			HOST_firTcbErrors++;
+			break;
+		}
+		channels++;
+		for(n = 0; n < outputs; n++){
+			acc = 0.0;
+			for(k = 0; k < taps; k++){
+				acc += coeffs[k]*input[n+taps-1-k];
+			}
+			output[n] = acc;
+		}
+		tcb = tcb[0] ? (unsigned int *)(unsigned long)tcb[0] - 12 : 0;
+	}
+	if(channels != ((HOST_regs[HOST_REG_FIRCTL1]>>2)&0x7f) + 1){
+		HOST_firTcbErrors++;
+	}
+	HOST_firChains++;
+	HOST_regs[HOST_REG_FIRCTL1] &= ~FIR_DMAEN;
+	HOST_raise(SIG_P5);
+	return 1;
+}
+
+
+/************************************************************
+	Function:	static int host_sport1 (void)
+	Return:		TRUE if a transfer was done
+	Description:	SPORT1 transmit DMA to the DDS, done in one
+		tick. SIG_SP1 is raised at its end.
+************************************************************/
+static int host_sport1(void)
+{
+	unsigned int go = SPEN_A | SDEN_A | SPTRAN;
+
+	if((HOST_regs[HOST_REG_SPCTL1] & go) != go){
+		return 0;
+	}
+	HOST_regs[HOST_REG_SPCTL1] &= ~SDEN_A;
+	HOST_raise(SIG_SP1);
+	return 1;
+}
+
+
+/************************************************************
+	Function:	void HOST_adcStream (const unsigned int * words,
+					unsigned int count, unsigned int per_tick)
+	Description:	Lets the ADC convert on its own: while the
+		conversion clock (PCG D frame sync) runs, every tick takes
+		per_tick words of words[], as HOST_adcSample does, until
+		count words have been converted. For firmware that waits
+		for a run to end, as the triggered capture does.
+************************************************************/
+void HOST_adcStream(const unsigned int * words, unsigned int count, unsigned int per_tick)
+{
+	host_enter();
+	host_adcWords = words;
+	host_adcCount = count;
+	host_adcPerTick = per_tick;
+	HOST_adcStreamed = 0;
+	host_leave();
+}
+
+static void host_adcConvert(void)
+{
+	unsigned int k;
+
+	for(k = 0; k < host_adcPerTick && HOST_adcStreamed < host_adcCount; k++){
+		if(!(HOST_regs[HOST_REG_PCG_CTLD0] & ENFSD)){
+			break;
+		}
+		HOST_adcSample(host_adcWords[HOST_adcStreamed++]);
+	}
+}
+
+
+/************************************************************
+	Function:	void HOST_hardware (void)
+	Description:	One tick of the background engines, at most
+		HOST_TICK_BUDGET external bus accesses. Runs from the
+		timer signal, or directly from a test.
+************************************************************/
+void HOST_hardware(void)
+{
+	int budget = HOST_TICK_BUDGET;
+	int used;
+
+	host_enter();
+	HOST_ticks++;
+	do{
+		used = host_epDma(budget);
+		budget -= used;
+		used += host_firAccelerator();
+		used += host_sport1();
+	}while(used > 0 && budget > 0);
+	host_adcConvert();
+	host_leave();
+}
+
+
+/************************************************************
+	Function:	void HOST_adcSample (unsigned int word)
+	Description:	One conversion received by SPORT3. With DMA
+		enabled the word goes to the TCB chain loaded from CPSP3A,
+		and SIG_SP3 is raised at the end of each TCB; otherwise it
+		is left in RXSP3A with DXS1_A set, and SIG_SP3 is raised
+		for it. The CNV and BUSY handshake is not modelled.
+		SPORT TCB: [0] chain pointer, [1] count, [2] modify, [3] index,
+		the pointers address word 3 less HOST_DMA_OFFSET, the chain
+		ones with HOST_DMA_PCI added. As on the SPORT, CPSP3A follows
+		the chain; a write of CPSP3A by the firmware restarts it.
+************************************************************/
+void HOST_adcSample(unsigned int word)
+{
+	unsigned int * buffer;
+
+	if(!(HOST_regs[HOST_REG_SPCTL3] & SDEN_A)){
+		host_sportTcb = 0;
+		HOST_regs[HOST_REG_RXSP3A] = word;
+		HOST_regs[HOST_REG_SPCTL3] |= DXS1_A;
+		HOST_raise(SIG_SP3);
+		return;
+	}
+
+	if(host_sportTcb == 0 || !(HOST_regs[HOST_REG_CPSP3A] & HOST_CP_LOADED)){
+		host_sportTcb = (unsigned int *)(unsigned long)((HOST_regs[HOST_REG_CPSP3A] & ~HOST_CP_LOADED) + HOST_DMA_OFFSET - 3);
+		host_sportDone = 0;
+		HOST_regs[HOST_REG_CPSP3A] |= HOST_CP_LOADED;
+	}
+	buffer = (unsigned int *)(unsigned long)(host_sportTcb[3] + HOST_DMA_OFFSET);
+	buffer[host_sportDone*host_sportTcb[2]] = word;
+	if(++host_sportDone == host_sportTcb[1]){
+		host_sportDone = 0;
+		HOST_regs[HOST_REG_CPSP3A] = host_sportTcb[0] | HOST_CP_LOADED;
+		host_sportTcb = (HOST_regs[HOST_REG_SPCTL3] & SCHEN_A) ?
+			(unsigned int *)(unsigned long)(host_sportTcb[0] - HOST_DMA_PCI + HOST_DMA_OFFSET - 3) : 0;
+		HOST_raise(SIG_SP3);
+	}
+}
+
+
+/************************************************************
+	Function:	float fir (float x, const float * coeffs, float * state, int taps)
+	Description:	VisualDSP++ fir(): the state holds the last taps
+		inputs, newest first; coefficient k weighs the input k
+		samples back.
+************************************************************/
+float fir(float x, const float * coeffs, float * state, int taps)
+{
+	int k;
+	float acc = 0.0;
+
+	for(k = taps-1; k > 0; k--){
+		state[k] = state[k-1];
+	}
+	state[0] = x;
+	for(k = 0; k < taps; k++){
+		acc += coeffs[k]*state[k];
+	}
+	return acc;
+}
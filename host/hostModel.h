@@ -0,0 +1,115 @@
+/***************************************************************
+	Filename:	hostModel.h (host model of the ADSP-21489 board)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:
+
+	Purpose:	Lets the firmware sources build and run on a Linux
+		host for the tests in host/test. Models the parts of the
+		board the firmware talks to:
+			register file		- plain memory behind the p* pointers
+			interrupts			- interrupt() table, HOST_raise
+			SRU					- A0 and !CS of the FT2232H
+			FT2232H channel A	- bounded TX FIFO drained per bus access, RX queue
+			external port DMA	- EP0, a bus access budget per tick
+			SDRAM				- EP0 window, garbage at power up
+			FIR accelerator		- TCB chains
+			SPORT1				- DDS words, transmit DMA
+			SPORT3				- ADC words, core or chained DMA reception
+
+	Usage:	Call HOST_init first. The DMA engines and the FIR
+		accelerator run in the background, from a periodic timer
+		signal that preempts the test like the peripherals preempt
+		the main loop on the DSP. Their interrupts run from there.
+		Model calls made by the firmware are atomic, as a bus access
+		is: a tick that arrives during one is run when it returns.
+
+		The firmware stores addresses in 32 bit registers and TCBs,
+		so the tests build with -no-pie and keep every buffer the
+		model walks in static storage.
+
+***************************************************************/
+
+#ifndef _HOSTMODEL_H
+#define _HOSTMODEL_H
+
+// Registers the firmware uses. Order does not matter.
+#define HOST_REGISTERS(R) \
+	R(AMICTL0) R(AMICTL1) R(AMICTL2) R(CPFIR) R(CPSP3A) R(CSP1A) R(CSP3A) \
+	R(DAI_IRPTL_FE) R(DAI_IRPTL_H) R(DAI_IRPTL_PRI) R(DAI_IRPTL_RE) R(DAI_PIN_STAT) \
+	R(DIV1) R(DIV2) R(DIV3) R(DMAC0) R(ECEP0) R(EIEP0) R(EMEP0) R(EPCTL) R(FIRCTL1) \
+	R(FIRDMASTAT) R(ICEP0) R(IIEP0) R(IISP1A) R(IISP3A) R(IMEP0) R(IMSP1A) R(IMSP3A) \
+	R(PCG_CTLA0) R(PCG_CTLA1) R(PCG_CTLB0) R(PCG_CTLB1) R(PCG_CTLC0) R(PCG_CTLC1) \
+	R(PCG_CTLD0) R(PCG_CTLD1) R(PCG_PW2) R(PCG_SYNC1) R(PCG_SYNC2) R(PICR0) \
+	R(PMCTL) R(PMCTL1) R(RXSP3A) R(SDCTL) R(SDRRC) R(SPCTL1) R(SPCTL2) R(SPCTL3) \
+	R(SPCTL4) R(SYSCTL) R(TM0CTL) R(TM0PRD) R(TM0STAT) R(TM0W) R(TM1CTL) R(TM1PRD) \
+	R(TM1STAT) R(TM1W) R(TMSTAT) R(TXSP2A)
+
+#define HOST_REGISTER_ENUM(name) HOST_REG_##name,
+enum host_register { HOST_REGISTERS(HOST_REGISTER_ENUM) HOST_REGISTER_COUNT };
+
+extern volatile unsigned int HOST_regs[HOST_REGISTER_COUNT];
+
+// Interrupts
+enum host_signal {
+	SIG_P0 = 0, SIG_P5, SIG_SP1, SIG_SP3, SIG_EP0I,
+	SIG_GPTMR0, SIG_GPTMR1, SIG_IRQ0, SIG_IRQ1, HOST_SIGNALS
+};
+typedef void (*host_handler)(int);
+
+host_handler interrupt(int sig, host_handler handler);
+host_handler interrupts(int sig, host_handler handler);
+host_handler interruptf(int sig, host_handler handler);
+void HOST_raise(int sig);
+
+void HOST_init(void);
+void HOST_sru(const char * from, const char * to);
+
+// FT2232H channel A, async 245 FIFO behind A0 and !CS
+#define HOST_USB_TX_SIZE	4096	// Bytes of the FT2232H TX buffer
+#define HOST_USB_CAPTURE	(1<<22)	// Bytes kept of what the PC read
+
+int HOST_usbRead(void);
+void HOST_usbWrite(int value);
+void HOST_usbReset(unsigned int tx_size, unsigned int drain_num, unsigned int drain_den);
+void HOST_usbRate(unsigned int drain_num, unsigned int drain_den);
+void HOST_usbDrainAll(void);
+void HOST_usbHostSend(const unsigned char * bytes, unsigned int size);
+
+extern unsigned char HOST_usbCapture[HOST_USB_CAPTURE];
+extern volatile unsigned int HOST_usbCaptured;		// Bytes the PC read
+extern volatile unsigned int HOST_usbLost;			// Bytes written to a full FIFO
+extern volatile unsigned int HOST_usbChannelB;		// Accesses with data on D8-15
+extern volatile unsigned int HOST_usbSelects;		// !CS assertions
+extern volatile unsigned int HOST_usbBadAccess;		// Data accesses without !CS low and A0 low
+extern volatile unsigned long long HOST_usbAccesses;	// Bus accesses, status reads included
+extern volatile unsigned int HOST_usbLevel;			// Bytes in the TX FIFO
+extern volatile unsigned int HOST_usbMaxLevel;
+
+// Background engines: external port DMA and FIR accelerator
+#define HOST_TICK_USEC		20		// Timer period
+#define HOST_TICK_BUDGET	64		// External bus accesses per tick
+
+void HOST_hardware(void);
+extern volatile unsigned int HOST_ticks;
+extern volatile unsigned int HOST_firChains;		// TCB chains run by the FIR accelerator
+extern volatile unsigned int HOST_firTcbErrors;		// Chains with inconsistent TCBs
+
+// SDRAM behind EP0. Not cleared at boot: HOST_sdram fills the window
+// with HOST_SDRAM_GARBAGE, EP0 transfers outside it are counted.
+#define HOST_SDRAM_GARBAGE	0xdeadbeef
+
+void HOST_sdram(unsigned int * base, unsigned int words);
+extern volatile unsigned int HOST_sdramWritten;		// Words EP0 wrote to the window
+extern volatile unsigned int HOST_sdramBadAccess;	// EP0 words outside the window
+
+// SPORT3: one ADC conversion, 16 bit chB<<16 | chA
+void HOST_adcSample(unsigned int word);
+void HOST_adcStream(const unsigned int * words, unsigned int count, unsigned int per_tick);
+extern volatile unsigned int HOST_adcStreamed;		// Words of the stream converted
+
+// Firmware VisualDSP++ run time
+float fir(float x, const float * coeffs, float * state, int taps);
+
+#endif
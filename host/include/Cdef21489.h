@@ -0,0 +1,80 @@
+/***************************************************************
+	Filename:	Cdef21489.h (host build)
+
+	Purpose:	Host stand in for the VisualDSP++ register
+		pointers. Each one points into the register file of
+		hostModel.c. pm and dm qualifiers are dropped.
+
+***************************************************************/
+
+#ifndef _HOST_CDEF21489_H
+#define _HOST_CDEF21489_H
+
+#include "hostModel.h"
+
+#define pm
+#define dm
+
+#define pAMICTL0	((volatile unsigned int *)&HOST_regs[HOST_REG_AMICTL0])
+#define pAMICTL1	((volatile unsigned int *)&HOST_regs[HOST_REG_AMICTL1])
+#define pAMICTL2	((volatile unsigned int *)&HOST_regs[HOST_REG_AMICTL2])
+#define pCPFIR	((volatile unsigned int *)&HOST_regs[HOST_REG_CPFIR])
+#define pCPSP3A	((volatile unsigned int *)&HOST_regs[HOST_REG_CPSP3A])
+#define pCSP1A	((volatile unsigned int *)&HOST_regs[HOST_REG_CSP1A])
+#define pCSP3A	((volatile unsigned int *)&HOST_regs[HOST_REG_CSP3A])
+#define pDAI_IRPTL_FE	((volatile unsigned int *)&HOST_regs[HOST_REG_DAI_IRPTL_FE])
+#define pDAI_IRPTL_H	((volatile unsigned int *)&HOST_regs[HOST_REG_DAI_IRPTL_H])
+#define pDAI_IRPTL_PRI	((volatile unsigned int *)&HOST_regs[HOST_REG_DAI_IRPTL_PRI])
+#define pDAI_IRPTL_RE	((volatile unsigned int *)&HOST_regs[HOST_REG_DAI_IRPTL_RE])
+#define pDAI_PIN_STAT	((volatile unsigned int *)&HOST_regs[HOST_REG_DAI_PIN_STAT])
+#define pDIV1	((volatile unsigned int *)&HOST_regs[HOST_REG_DIV1])
+#define pDIV2	((volatile unsigned int *)&HOST_regs[HOST_REG_DIV2])
+#define pDIV3	((volatile unsigned int *)&HOST_regs[HOST_REG_DIV3])
+#define pDMAC0	((volatile unsigned int *)&HOST_regs[HOST_REG_DMAC0])
+#define pECEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_ECEP0])
+#define pEIEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_EIEP0])
+#define pEMEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_EMEP0])
+#define pEPCTL	((volatile unsigned int *)&HOST_regs[HOST_REG_EPCTL])
+#define pFIRCTL1	((volatile unsigned int *)&HOST_regs[HOST_REG_FIRCTL1])
+#define pFIRDMASTAT	((volatile unsigned int *)&HOST_regs[HOST_REG_FIRDMASTAT])
+#define pICEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_ICEP0])
+#define pIIEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_IIEP0])
+#define pIISP1A	((volatile unsigned int *)&HOST_regs[HOST_REG_IISP1A])
+#define pIISP3A	((volatile unsigned int *)&HOST_regs[HOST_REG_IISP3A])
+#define pIMEP0	((volatile unsigned int *)&HOST_regs[HOST_REG_IMEP0])
+#define pIMSP1A	((volatile unsigned int *)&HOST_regs[HOST_REG_IMSP1A])
+#define pIMSP3A	((volatile unsigned int *)&HOST_regs[HOST_REG_IMSP3A])
+#define pPCG_CTLA0	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLA0])
+#define pPCG_CTLA1	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLA1])
+#define pPCG_CTLB0	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLB0])
+#define pPCG_CTLB1	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLB1])
+#define pPCG_CTLC0	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLC0])
+#define pPCG_CTLC1	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLC1])
+#define pPCG_CTLD0	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLD0])
+#define pPCG_CTLD1	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_CTLD1])
+#define pPCG_PW2	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_PW2])
+#define pPCG_SYNC1	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_SYNC1])
+#define pPCG_SYNC2	((volatile unsigned int *)&HOST_regs[HOST_REG_PCG_SYNC2])
+#define pPICR0	((volatile unsigned int *)&HOST_regs[HOST_REG_PICR0])
+#define pPMCTL	((volatile unsigned int *)&HOST_regs[HOST_REG_PMCTL])
+#define pPMCTL1	((volatile unsigned int *)&HOST_regs[HOST_REG_PMCTL1])
+#define pRXSP3A	((volatile unsigned int *)&HOST_regs[HOST_REG_RXSP3A])
+#define pSDCTL	((volatile unsigned int *)&HOST_regs[HOST_REG_SDCTL])
+#define pSDRRC	((volatile unsigned int *)&HOST_regs[HOST_REG_SDRRC])
+#define pSPCTL1	((volatile unsigned int *)&HOST_regs[HOST_REG_SPCTL1])
+#define pSPCTL2	((volatile unsigned int *)&HOST_regs[HOST_REG_SPCTL2])
+#define pSPCTL3	((volatile unsigned int *)&HOST_regs[HOST_REG_SPCTL3])
+#define pSPCTL4	((volatile unsigned int *)&HOST_regs[HOST_REG_SPCTL4])
+#define pSYSCTL	((volatile unsigned int *)&HOST_regs[HOST_REG_SYSCTL])
+#define pTM0CTL	((volatile unsigned int *)&HOST_regs[HOST_REG_TM0CTL])
+#define pTM0PRD	((volatile unsigned int *)&HOST_regs[HOST_REG_TM0PRD])
+#define pTM0STAT	((volatile unsigned int *)&HOST_regs[HOST_REG_TM0STAT])
+#define pTM0W	((volatile unsigned int *)&HOST_regs[HOST_REG_TM0W])
+#define pTM1CTL	((volatile unsigned int *)&HOST_regs[HOST_REG_TM1CTL])
+#define pTM1PRD	((volatile unsigned int *)&HOST_regs[HOST_REG_TM1PRD])
+#define pTM1STAT	((volatile unsigned int *)&HOST_regs[HOST_REG_TM1STAT])
+#define pTM1W	((volatile unsigned int *)&HOST_regs[HOST_REG_TM1W])
+#define pTMSTAT	((volatile unsigned int *)&HOST_regs[HOST_REG_TMSTAT])
+#define pTXSP2A	((volatile unsigned int *)&HOST_regs[HOST_REG_TXSP2A])
+
+#endif
@@ -0,0 +1,152 @@
+/***************************************************************
+	Filename:	def21489.h (host build)
+
+	Purpose:	Host stand in for the VisualDSP++ register bit
+		definitions. Bits the host model acts on (DMA, FIR
+		accelerator, SPORT DMA, AMI packing) have their
+		ADSP-21489 positions; the others only need to be
+		distinct within their register.
+
+***************************************************************/
+
+#ifndef _HOST_DEF21489_H
+#define _HOST_DEF21489_H
+
+#define BIT_0	0x00000001
+#define BIT_1	0x00000002
+#define BIT_2	0x00000004
+#define BIT_3	0x00000008
+#define BIT_4	0x00000010
+#define BIT_5	0x00000020
+#define BIT_6	0x00000040
+#define BIT_7	0x00000080
+#define BIT_8	0x00000100
+#define BIT_9	0x00000200
+#define BIT_10	0x00000400
+#define BIT_11	0x00000800
+#define BIT_12	0x00001000
+#define BIT_13	0x00002000
+#define BIT_14	0x00004000
+#define BIT_15	0x00008000
+#define BIT_16	0x00010000
+#define BIT_17	0x00020000
+#define BIT_18	0x00040000
+#define BIT_19	0x00080000
+#define BIT_20	0x00100000
+#define BIT_21	0x00200000
+#define BIT_22	0x00400000
+#define BIT_23	0x00800000
+#define BIT_24	0x01000000
+#define BIT_25	0x02000000
+#define BIT_26	0x04000000
+#define BIT_27	0x08000000
+#define BIT_28	0x10000000
+#define BIT_29	0x20000000
+#define BIT_30	0x40000000
+#define BIT_31	0x80000000
+
+// SYSCTL, EPCTL
+#define MSEN		BIT_12
+#define B0SD		BIT_0
+#define B1SD		BIT_1
+#define B2SD		BIT_2
+#define B3SD		BIT_3
+
+// AMICTLx
+#define AMIEN		BIT_0
+#define BW16		BIT_2
+#define PKDIS		BIT_3
+#define WS20		(20<<4)
+#define PREDIS		BIT_11
+#define IC5			(5<<12)
+#define AMIFLSH		BIT_17
+
+// DMACx, external port DMA
+#define DMAEN		BIT_0
+#define TRAN		BIT_1
+#define DFLSH		BIT_4
+
+// PMCTL1, FIRCTL1
+#define FIRACCSEL	BIT_17
+#define IIRACCSEL	BIT_18
+#define FIR_EN		BIT_0
+#define FIR_DMAEN	BIT_1
+#define FIR_CH2		(1<<2)
+#define FIR_RND0	(0<<14)
+#define IIR_EN		BIT_0
+#define IIR_DMAEN	BIT_1
+#define IIR_CH2		(1<<2)
+#define IIR_RND0	(0<<14)
+
+// PICR0
+#define P5I0		BIT_25
+#define P5I1		BIT_26
+#define P5I2		BIT_27
+#define P5I3		BIT_28
+#define P5I4		BIT_29
+
+// SPCTLx
+#define SPEN_A		BIT_0
+#define SLEN8		(7<<4)
+#define SLEN16		(15<<4)
+#define SLEN32		(31<<4)
+#define LSBF		BIT_9
+#define ICLK		BIT_10
+#define FSR			BIT_12
+#define IFS			BIT_14
+#define LAFS		BIT_17
+#define SDEN_A		BIT_18
+#define SCHEN_A		BIT_19
+#define SPTRAN		BIT_25
+#define CKRE		BIT_27
+#define DXS1_A		BIT_30
+
+// PCG
+#define ENCLKA		BIT_31
+#define ENFSA		BIT_30
+#define ENCLKC		BIT_31
+#define ENFSC		BIT_30
+#define ENCLKD		BIT_29
+#define ENFSD		BIT_28
+#define CLKA_SOURCE_IOP	BIT_31
+#define FSA_SOURCE_IOP	BIT_30
+#define CLKA_SYNC	BIT_29
+
+// Timers
+#define TIMODEPWM	(1<<0)
+#define PULSE		BIT_2
+#define PRDCNT		BIT_3
+#define IRQEN		BIT_4
+#define TIM0EN		BIT_8
+#define TIM0DIS		BIT_9
+#define TIM1EN		BIT_10
+#define TIM0IRQ		BIT_0
+#define TIM1IRQ		BIT_1
+
+// DAI interrupts
+#define SRU_EXTMISCA1_INT	BIT_29
+#define SRU_EXTMISCA2_INT	BIT_30
+#define SRU_EXTMISCB0_INT	BIT_31
+#define DAI_PB07	BIT_6
+#define IRQ0EN		BIT_0
+#define IRQ1EN		BIT_1
+
+// PLL, SDRAM
+#define PLLM32		32
+#define INDIV		BIT_6
+#define DIVEN		BIT_9
+#define PLLBP		BIT_15
+#define CLKOUTEN	BIT_12
+#define DSDCLK1		BIT_1
+#define SDCL3		3
+#define SDCAW9		BIT_4
+#define SDRAW13		BIT_8
+#define SDTRAS7		(7<<11)
+#define SDTRP3		(3<<16)
+#define SDTWR2		(2<<19)
+#define SDTRCD3		(3<<26)
+#define SDPSS		BIT_23
+#define SDROPT		BIT_17
+#define X16DE		BIT_31
+
+#endif
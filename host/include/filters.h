@@ -0,0 +1,14 @@
+/***************************************************************
+	Filename:	filters.h (host build)
+
+	Purpose:	fir(), iir() and biquad() of the VisualDSP++ run
+		time, implemented by the host model.
+
+***************************************************************/
+
+#ifndef _HOST_FILTERS_H
+#define _HOST_FILTERS_H
+
+#include "hostModel.h"
+
+#endif
@@ -0,0 +1,15 @@
+/***************************************************************
+	Filename:	signal.h (host build)
+
+	Purpose:	The C library signal.h plus the VisualDSP++
+		interrupt() dispatch of the host model.
+
+***************************************************************/
+
+#ifndef _HOST_SIGNAL_H
+#define _HOST_SIGNAL_H
+
+#include_next <signal.h>
+#include "hostModel.h"
+
+#endif
@@ -0,0 +1,17 @@
+/***************************************************************
+	Filename:	sru.h (host build)
+
+	Purpose:	Host stand in for the SRU routing macro. The
+		connections go to the host model, which follows the
+		FT2232H A0 and !CS pins.
+
+***************************************************************/
+
+#ifndef _HOST_SRU_H
+#define _HOST_SRU_H
+
+#include "hostModel.h"
+
+#define SRU(from, to)	HOST_sru(#from, #to)
+
+#endif
@@ -0,0 +1,18 @@
+/***************************************************************
+	Filename:	sysreg.h (host build)
+
+	Purpose:	Host stand in for the system register built-ins.
+		The host model has no IMASK or MODE1, interrupts are
+		always enabled.
+
+***************************************************************/
+
+#ifndef _HOST_SYSREG_H
+#define _HOST_SYSREG_H
+
+#define sysreg_bit_set(reg, bits)	((void)0)
+#define sysreg_bit_clr(reg, bits)	((void)0)
+#define sysreg_read(reg)			0
+#define sysreg_write(reg, value)	((void)0)
+
+#endif
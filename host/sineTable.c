@@ -0,0 +1,37 @@
+/***************************************************************
+	Filename:	sineTable.c (quarter wave sine table generator)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:	h/general.h
+
+	Purpose:	Writes sine_quarter1025.txt, the initializer of
+		sine_quarter_lut: sin(2*pi*k/(4*SINE_QUARTER_SIZE)) for
+		k = 0..SINE_QUARTER_SIZE, at 9 significant digits, enough
+		for a float. The host build includes
+		the table it generates; the VisualDSP++ project includes the
+		copy at the top of the tree, which test_sinetable keeps equal.
+
+		Usage: sineTable <output file>
+
+***************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include "h/general.h"
+
+
+int main(int argc, char ** argv)
+{
+	FILE * file;
+	int k;
+
+	if(argc != 2 || (file = fopen(argv[1], "w")) == NULL){
+		fprintf(stderr, "usage: sineTable <output file>\n");
+		return 1;
+	}
+	for(k = 0; k <= SINE_QUARTER_SIZE; k++){
+		fprintf(file, "%.9g%s", sin(2*M_PI*k/(4*SINE_QUARTER_SIZE)), k < SINE_QUARTER_SIZE ? "," : "\n");
+	}
+	return fclose(file) != 0;
+}
@@ -0,0 +1,129 @@
+/***************************************************************
+	Filename:	hostTest.c (host test helpers)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:	hostTest.h
+
+	Purpose:	See hostTest.h.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+int TEST_failures = 0;
+static unsigned int test_random = 1;
+
+
+/************************************************************
+	Function:	void TEST_boot (void)
+	Description:	Resets the model and runs the part of the
+		boot sequence of main the firmware drivers need: the DDS
+		SPORT interrupt, the USB bus and an empty FIFO.
+************************************************************/
+void TEST_boot(void)
+{
+	HOST_init();
+	interrupt(SIG_SP1, IRQ_DDS_SP1);
+	InitDDS_IO();
+	InitUSB_IO();
+	USB_init();
+	HOST_usbDrainAll();
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	TEST_seed(1);
+}
+
+
+/************************************************************
+	Function:	int TEST_report (const char * name)
+	Return:		Number of failed checks, the exit code
+************************************************************/
+int TEST_report(const char * name)
+{
+	printf("%s: %s (%d failed)\n", name, TEST_failures ? "FAILED" : "passed", TEST_failures);
+	return TEST_failures;
+}
+
+
+double TEST_seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+
+/************************************************************
+	Function:	double TEST_noise (void)
+	Return:		Gaussian sample of unit variance, repeatable
+		after TEST_seed
+************************************************************/
+void TEST_seed(unsigned int seed)
+{
+	test_random = seed ? seed : 1;
+}
+
+static double test_uniform(void)
+{
+	test_random = test_random*1664525u + 1013904223u;
+	return ((test_random>>8) + 0.5)/16777216.0;
+}
+
+double TEST_noise(void)
+{
+	double u1 = test_uniform();
+	double u2 = test_uniform();
+
+	return sqrt(-2.0*log(u1))*cos(2*M_PI*u2);
+}
+
+
+/************************************************************
+	Function:	unsigned int TEST_ifWord (unsigned int n, double cycles, double volts,
+					double phase, double noise)
+	Argument:	n - Sample number
+				cycles - Tone frequency in cycles per sample
+				volts - Tone amplitude
+				phase - Tone phase at sample 0, radians
+				noise - RMS noise, volts
+	Return:		SPORT3 word: the probe tone on channel B (bits 16-31),
+		its quadrature on channel A, both around their calibration codes
+************************************************************/
+static unsigned int test_code(double volts, int offset)
+{
+	double code = offset + volts*TEST_CODES_PER_VOLT;
+
+	if(code < 0) code = 0;
+	if(code > 65535) code = 65535;
+	return (unsigned int)lrint(code);
+}
+
+unsigned int TEST_ifWord(unsigned int n, double cycles, double volts, double phase, double noise)
+{
+	double angle = 2*M_PI*fmod(cycles*n, 1.0) + phase;
+	double b = volts*cos(angle) + noise*TEST_noise();
+	double a = volts*sin(angle) + noise*TEST_noise();
+
+	return test_code(b, CAL_CHB_DECIMAL)<<16 | test_code(a, CAL_CHA_DECIMAL);
+}
+
+
+/************************************************************
+	Function:	int TEST_command (const unsigned char * msg, unsigned short size)
+	Return:		USB_processPayload result
+	Description:	Runs a command payload as the main loop does
+		once the packet has been read from the FIFO.
+************************************************************/
+int TEST_command(const unsigned char * msg, unsigned short size)
+{
+	static unsigned char payload[256];
+
+	memcpy(payload, msg, size);
+	return USB_processPayload(size, payload);
+}
@@ -0,0 +1,43 @@
+/***************************************************************
+	Filename:	hostTest.h (host test helpers)
+	Date:		October 2026
+	Version:	v1.0
+
+	Dependecies:	hostModel.h
+
+	Purpose:	Checks, timing, board boot and synthetic ADC signals
+		shared by the host tests. One executable per test_*.c file,
+		the exit code is the number of failed checks.
+
+***************************************************************/
+
+#ifndef _HOSTTEST_H
+#define _HOSTTEST_H
+
+#include <stdio.h>
+#include "hostModel.h"
+
+extern int TEST_failures;
+
+// Counts a failed check and prints where it failed
+#define CHECK(cond, ...) do{ \
+		if(!(cond)){ \
+			TEST_failures++; \
+			printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	}while(0)
+
+// ADC codes per volt, as converted by the firmware
+#define TEST_CODES_PER_VOLT		(65536/2.5)
+
+void TEST_boot(void);
+int TEST_report(const char * name);
+double TEST_seconds(void);
+void TEST_seed(unsigned int seed);
+double TEST_noise(void);
+unsigned int TEST_ifWord(unsigned int n, double cycles, double volts, double phase, double noise);
+int TEST_command(const unsigned char * msg, unsigned short size);
+
+#endif
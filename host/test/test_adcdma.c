@@ -0,0 +1,149 @@
+/***************************************************************
+	Filename:	test_adcdma.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Chained DMA reception of SPORT3 (ADC_dmaMode). The
+		model walks the TCB chain built by ADC_initDMA as the SPORT
+		DMA does: every block must land in its place of the raw
+		samples ring, be published by one IRQ_ADC_BlockDone, and give
+		the same outputs as the per sample interrupts, around the ring
+		several times. Also covers a consumer that falls a ring behind
+		and the two block rotation of oversampled runs.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913		// DDS increment difference: LO near 0.1 cycles/sample
+#define TEST_WORDS		(3*MAXSAMPLES)
+#define TEST_DECIMATION	8
+#define TEST_OUTPUTS	2500		// 20000 raw words: the chain goes round the ring twice
+
+static unsigned int words[TEST_WORDS];
+static float refI[MAX_SAMPLES_BUFFER_SIZE];
+static float refQ[MAX_SAMPLES_BUFFER_SIZE];
+
+
+/************************************************************
+	Function:	static unsigned int run (int dma, unsigned int outputs, int process)
+	Argument:	dma - ADC_dmaMode
+				outputs - Outputs of the finite block run
+				process - Call DSP_ProcessBlocks while sampling
+	Return:		Words converted before sampling stopped
+	Description:	With DMA, checks after every word that AR_rawIndex
+		only moves at the end of a TCB, by one block, and that the
+		block is in the ring where the chain put it.
+************************************************************/
+static unsigned int run(int dma, unsigned int outputs, int process)
+{
+	unsigned char command[USB_MSG_ADCDMA_SIZE] = {USB_MSG_ADCDMA, 0};
+	unsigned int n, k, published = 0, misplaced = 0, early = 0;
+
+	command[1] = dma;
+	TEST_command(command, sizeof(command));
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(outputs-1, 10, FALSE);
+	CHECK(ADC_dmaActive == dma, "DMA mode %d not applied", dma);
+	for(n = 0; n < TEST_WORDS && ADC_sampling; n++){
+		HOST_adcSample(words[n]);
+		if(dma && AR_rawIndex != published){
+			// One block per TCB, the last one cut to AR_rawTotal
+			if((n+1)%ADC_DMA_BLOCK != 0 || AR_rawIndex != n+1 && AR_rawIndex != AR_rawTotal){
+				early++;
+			}
+			for(k = published; k < AR_rawIndex; k++){
+				misplaced += SAMPLES_MEMORY[k&(MAXSAMPLES-1)] != words[k];
+			}
+			published = AR_rawIndex;
+		}
+		if(process && n%64 == 63){
+			DSP_ProcessBlocks();
+		}
+	}
+	while(!AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+	CHECK(early == 0, "%u blocks published off a TCB boundary", early);
+	CHECK(misplaced == 0, "%u raw words misplaced in the ring", misplaced);
+	return n;
+}
+
+
+int main(void)
+{
+	unsigned char decimation[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, TEST_DECIMATION};
+	unsigned char oversampling[USB_MSG_OVERSAMPLING_SIZE] = {USB_MSG_OVERSAMPLING, 2};
+	unsigned int n, k, a, b, outputs, overruns, averaged;
+	double cycles;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DSP_blockSize = 512;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + 0.0007;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, 0.5, 0.3, 0.01);
+	}
+	TEST_command(decimation, sizeof(decimation));
+
+	// Per sample interrupts, the reference
+	run(0, TEST_OUTPUTS, 1);
+	CHECK(AR_bufferIndex+1 == TEST_OUTPUTS, "reference: %u outputs", AR_bufferIndex+1);
+	memcpy(refI, AR_bufferChA, TEST_OUTPUTS*sizeof(float));
+	memcpy(refQ, AR_bufferChB, TEST_OUTPUTS*sizeof(float));
+
+	// Chained DMA, round the ring
+	n = run(1, TEST_OUTPUTS, 1);
+	printf("DMA run: %u words in %u blocks for %u outputs\n", n, (n+ADC_DMA_BLOCK-1)/ADC_DMA_BLOCK, AR_bufferIndex+1);
+	CHECK(n > 2*MAXSAMPLES, "the chain did not go round the ring");
+	CHECK(AR_bufferIndex+1 == TEST_OUTPUTS, "DMA: %u outputs", AR_bufferIndex+1);
+	CHECK(memcmp(AR_bufferChA, refI, TEST_OUTPUTS*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, refQ, TEST_OUTPUTS*sizeof(float)) == 0, "DMA outputs differ");
+
+	// Nobody processing: the chain must stop before the unread blocks
+	overruns = AR_rawOverruns;
+	n = run(1, TEST_OUTPUTS, 0);
+	outputs = AR_bufferIndex+1;
+	printf("DMA run without processing: stopped after %u words, %u outputs\n", n, outputs);
+	CHECK(AR_rawOverruns == overruns+1, "overrun not counted");
+	CHECK(n <= MAXSAMPLES, "%u words received into a ring of %d", n, MAXSAMPLES);
+	CHECK(outputs > 0 && memcmp(AR_bufferChA, refI, outputs*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, refQ, outputs*sizeof(float)) == 0, "outputs of the shortened run differ");
+
+	// Oversampling: two staging TCBs, each block summed into the ring
+	TEST_command(oversampling, sizeof(oversampling));
+	decimation[1] = 1;
+	TEST_command(decimation, sizeof(decimation));
+	AR_finishedFlag = FALSE;
+	ADC_dmaMode = TRUE;
+	ADC_StartSampling(1000-1, 10, FALSE);
+	CHECK(ADC_osr == 2, "oversampling %u", ADC_osr);
+	averaged = 0;
+	for(n = 0; n < TEST_WORDS && ADC_sampling; n++){
+		HOST_adcSample(words[n]);
+		if((n+1)%ADC_DMA_BLOCK == 0){
+			CHECK(AR_rawIndex == (n+1)/2 || AR_rawIndex == AR_rawTotal,
+				"%u averaged words after %u", AR_rawIndex, n+1);
+			for(k = averaged; k < AR_rawIndex; k++){
+				a = (words[2*k]&0xffff) + (words[2*k+1]&0xffff);
+				b = (words[2*k]>>16) + (words[2*k+1]>>16);
+				CHECK(SAMPLES_MEMORY[k&(MAXSAMPLES-1)] == b<<15 && ADC_osrRingA[k&(MAXSAMPLES-1)] == a<<15,
+					"summed word %u", k);
+			}
+			averaged = AR_rawIndex;
+			DSP_ProcessBlocks();
+		}
+	}
+	while(!AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+	CHECK(AR_bufferIndex+1 == 1000, "oversampled run: %u outputs", AR_bufferIndex+1);
+	printf("oversampled run: %u words for %u outputs\n", n, AR_bufferIndex+1);
+
+	return TEST_report("test_adcdma");
+}
@@ -0,0 +1,151 @@
+/***************************************************************
+	Filename:	test_bank.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Multi frequency demodulation bank. A bank command
+		during a run only takes effect on the next run, and a
+		triggered capture sends the last output of every lane, with
+		the ADC converting in the background as on the board.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913		// DDS increment difference: LO near 0.1 cycles/sample
+#define TEST_LANE_STEP	100000		// Lane IF spacing, DDS increment units
+#define TEST_VOLTS		0.5
+#define TEST_NOISE		0.01
+#define TEST_WORDS		8192
+#define TEST_OUTPUTS	500
+#define TEST_DECIMATION	4
+
+static unsigned int words[TEST_WORDS];
+static float laneI[MAX_SAMPLES_BUFFER_SIZE];
+static float laneQ[MAX_SAMPLES_BUFFER_SIZE];
+
+
+/************************************************************
+	Function:	static void bank (int lanes)
+	Description:	Bank command with lanes lanes, then the lane
+		IF increments the test uses.
+************************************************************/
+static void bank(int lanes)
+{
+	unsigned char command[USB_MSG_BANK_SIZE] = {USB_MSG_BANK, 0};
+	unsigned int k;
+
+	command[1] = lanes;
+	CHECK(processBank(sizeof(command), command) == TRUE, "bank command");
+	for(k = 0; k < BANK_LANES_MAX; k++){
+		BANK_if_inc[k] = (TEST_LO_STEP + k*TEST_LANE_STEP)*1200;
+	}
+}
+
+
+/************************************************************
+	Function:	static void run (int change)
+	Description:	Finite block run of TEST_OUTPUTS outputs per
+		lane. With change set a bank command of change lanes
+		arrives half way.
+************************************************************/
+static void run(int change)
+{
+	unsigned int n;
+
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(TEST_OUTPUTS-1, 10, FALSE);
+	for(n = 0; n < TEST_WORDS && !AR_finishedFlag; n++){
+		if(change && n == TEST_OUTPUTS*TEST_DECIMATION/2){
+			bank(change);
+		}
+		HOST_adcSample(words[n]);
+		if(n%64 == 63){
+			DSP_ProcessBlocks();
+		}
+	}
+	while(!AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+}
+
+
+int main(void)
+{
+	unsigned char decimation[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, TEST_DECIMATION};
+	unsigned int n, k, values, offset, size, samples, found;
+	const unsigned char * packet;
+	float stepI[BANK_LANES_MAX], stepQ[BANK_LANES_MAX];
+	double cycles, lane0, lane1;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DSP_blockSize = 512;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + 0.0007;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, TEST_VOLTS, 0.3, TEST_NOISE);
+	}
+	TEST_command(decimation, sizeof(decimation));
+
+	// Two lanes, the tone near lane 0
+	bank(2);
+	run(0);
+	values = AR_bufferIndex + 1;
+	CHECK(BANK_active && BANK_lanes == 2, "bank not active with 2 lanes");
+	CHECK(values == 2*TEST_OUTPUTS, "%u values for %u outputs of 2 lanes", values, TEST_OUTPUTS);
+	memcpy(laneI, AR_bufferChA, values*sizeof(float));
+	memcpy(laneQ, AR_bufferChB, values*sizeof(float));
+	lane0 = hypot(laneI[values-2], laneQ[values-2]);
+	lane1 = hypot(laneI[values-1], laneQ[values-1]);
+	printf("2 lanes: %u values, last output lane 0 %.4f V, lane 1 %.4f V\n", values, lane0, lane1);
+	CHECK(lane0 > 0.5 && lane1 < 0.05, "lanes mixed up: %g %g", lane0, lane1);
+
+	// A command during a run is kept for the next one
+	run(4);
+	CHECK(BANK_lanes == 2, "lanes changed during the run: %u", BANK_lanes);
+	CHECK(BANK_lanesRequest == 4, "request lost: %u", BANK_lanesRequest);
+	CHECK(AR_bufferIndex + 1 == values, "%u values after the change", AR_bufferIndex + 1);
+	CHECK(memcmp(AR_bufferChA, laneI, values*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, laneQ, values*sizeof(float)) == 0, "outputs changed during the run");
+	run(0);
+	CHECK(BANK_lanes == 4 && AR_bufferIndex + 1 == 4*TEST_OUTPUTS,
+		"request not applied: %u lanes, %u values", BANK_lanes, AR_bufferIndex + 1);
+
+	// Triggered capture: the main loop is held, the ADC converts by itself
+	bank(2);
+	XY_triggerSettle = 0;
+	XY_triggerSamples = TEST_OUTPUTS-1;
+	XY_triggerPeriod = 10;
+	XY_triggerStep = 7;
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	HOST_adcStream(words, TEST_WORDS, 8);
+	XY_triggeredCapture();
+	HOST_usbDrainAll();
+	CHECK(XY_triggerStep == 8, "step not counted");
+	CHECK(AR_bufferIndex + 1 == values, "triggered capture: %u values", AR_bufferIndex + 1);
+	offset = 0;
+	found = 0;
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+		if(packet[0] != USB_MSG_SENDSTEPDATA){
+			continue;
+		}
+		found++;
+		samples = DECODE_samples(packet+5, size-5, ENCODE_FLOAT32, stepI, stepQ, BANK_LANES_MAX);
+		CHECK(DECODE_int(packet+1) == 7, "step %u", DECODE_int(packet+1));
+		CHECK(samples == 2, "%u lanes in the step packet", samples);
+		for(k = 0; k < samples && k < 2; k++){
+			CHECK(stepI[k] == AR_bufferChA[values-2+k] && stepQ[k] == AR_bufferChB[values-2+k],
+				"lane %u is not the last output", k);
+		}
+	}
+	CHECK(found == 1, "%u step packets", found);
+	printf("triggered capture: %u words converted in the background\n", HOST_adcStreamed);
+
+	return TEST_report("test_bank");
+}
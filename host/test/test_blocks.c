@@ -0,0 +1,160 @@
+/***************************************************************
+	Filename:	test_blocks.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Block demodulation (DSP_ProcessBlocks) against the
+		point by point path on a synthetic IF, its throughput in
+		samples/s for block sizes 32 to 1024, the run size clamp and
+		the raw ring overrun check, with core and DMA reception.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913		// DDS increment difference: LO near 0.1 cycles/sample
+#define TEST_IF_OFFSET	0.0007
+#define TEST_OUTPUTS	4096
+#define TEST_WORDS		(3*MAXSAMPLES)
+#define TEST_POLL		256			// Samples between main loop passes
+#define TEST_REPEAT		8
+
+static unsigned int words[TEST_WORDS];
+static float pointI[MAX_SAMPLES_BUFFER_SIZE];
+static float pointQ[MAX_SAMPLES_BUFFER_SIZE];
+
+
+/************************************************************
+	Function:	static double run (unsigned int block, unsigned int outputs,
+					unsigned int poll)
+	Argument:	block - DSP_blockSize, 0 for the point by point path
+				outputs - Outputs requested
+				poll - Samples between DSP_ProcessBlocks calls, 0 for
+					none until every sample has been fed
+	Return:		Seconds taken
+	Description:	One finite IF run, the main loop calling
+		DSP_ProcessBlocks in between the samples.
+************************************************************/
+static double run(unsigned int block, unsigned int outputs, unsigned int poll)
+{
+	unsigned int n;
+	double start;
+
+	DSP_blockSize = block;
+	AR_finishedFlag = FALSE;
+	start = TEST_seconds();
+	ADC_StartSampling(outputs-1, 10, FALSE);
+	for(n = 0; n < TEST_WORDS && ADC_sampling; n++){
+		HOST_adcSample(words[n]);
+		if(block && poll && (n+1)%poll == 0){
+			DSP_ProcessBlocks();
+		}
+	}
+	while(block && !AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+	return TEST_seconds() - start;
+}
+
+
+static double difference(unsigned int outputs)
+{
+	unsigned int k;
+	double error = 0;
+
+	for(k = 0; k < outputs; k++){
+		error = fmax(error, fabs(AR_bufferChA[k] - pointI[k]));
+		error = fmax(error, fabs(AR_bufferChB[k] - pointQ[k]));
+	}
+	return error;
+}
+
+
+int main(void)
+{
+	static const unsigned int decimations[] = {1, 8};
+	unsigned char command[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, 0};
+	unsigned int d, m, block, outputs, n, r, kept;
+	double seconds, point_rate, rate, error;
+	double cycles;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + TEST_IF_OFFSET;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, 0.5, 0.3, 0.01);
+	}
+
+	// Throughput and agreement with the point by point path
+	for(d = 0; d < sizeof(decimations)/sizeof(decimations[0]); d++){
+		m = decimations[d];
+		command[1] = m;
+		TEST_command(command, sizeof(command));
+		outputs = (TEST_OUTPUTS*m > TEST_WORDS) ? TEST_WORDS/m : TEST_OUTPUTS;
+
+		seconds = 0;
+		for(r = 0; r < TEST_REPEAT; r++){
+			seconds += run(0, outputs, 0);
+		}
+		point_rate = TEST_REPEAT*outputs*m/seconds;
+		memcpy(pointI, AR_bufferChA, outputs*sizeof(float));
+		memcpy(pointQ, AR_bufferChB, outputs*sizeof(float));
+		printf("decimation %u, %u outputs\n", m, outputs);
+		printf("  point by point   %10.0f samples/s\n", point_rate);
+
+		for(block = 32; block <= DSP_BLOCK_MAX; block *= 2){
+			seconds = 0;
+			for(r = 0; r < TEST_REPEAT; r++){
+				seconds += run(block, outputs, TEST_POLL);
+			}
+			rate = TEST_REPEAT*outputs*m/seconds;
+			error = difference(outputs);
+			printf("  block %4u (%s) %10.0f samples/s  x%.2f  max error %.3g V\n", block,
+				DSP_filterEngine == DSP_ENGINE_OLS ? "OLS   " : "direct", rate, rate/point_rate, error);
+			CHECK(AR_bufferIndex == outputs-1, "block %u: run ended on %u", block, AR_bufferIndex);
+			CHECK(error < 1e-4, "block %u: error %g", block, error);
+			CHECK(AR_rawOverruns == 0, "block %u: overrun", block);
+		}
+	}
+
+	// A run never holds more outputs than the sample buffers
+	command[1] = 1;
+	TEST_command(command, sizeof(command));
+	DSP_blockSize = 256;
+	ADC_StartSampling(3*MAX_SAMPLES_BUFFER_SIZE, 10, FALSE);
+	CHECK(AR_totalSamples == MAX_SAMPLES_BUFFER_SIZE-1, "block run of %u samples", AR_totalSamples);
+	CHECK(AR_rawTotal == MAX_SAMPLES_BUFFER_SIZE, "block run of %u raw words", AR_rawTotal);
+	ADC_StopSampling();
+
+	// Main loop stalled: the run stops on a full ring, the kept samples are intact
+	command[1] = 4;
+	TEST_command(command, sizeof(command));
+	run(0, MAX_SAMPLES_BUFFER_SIZE, 0);
+	memcpy(pointI, AR_bufferChA, MAX_SAMPLES_BUFFER_SIZE*sizeof(float));
+	memcpy(pointQ, AR_bufferChB, MAX_SAMPLES_BUFFER_SIZE*sizeof(float));
+	AR_rawOverruns = 0;
+	run(256, MAX_SAMPLES_BUFFER_SIZE, 0);
+	kept = AR_bufferIndex+1;
+	printf("stalled core reception: %u overruns, %u raw words, %u outputs\n", AR_rawOverruns, AR_rawTotal, kept);
+	CHECK(AR_rawOverruns == 1, "core reception: %u overruns", AR_rawOverruns);
+	CHECK(AR_rawTotal == MAXSAMPLES, "core reception: %u raw words kept", AR_rawTotal);
+	CHECK(kept == MAXSAMPLES/4, "core reception: %u outputs", kept);
+	CHECK(difference(kept) < 1e-4, "core reception: outputs differ");
+
+	ADC_dmaMode = TRUE;
+	AR_rawOverruns = 0;
+	run(256, MAX_SAMPLES_BUFFER_SIZE, 0);
+	kept = AR_bufferIndex+1;
+	printf("stalled DMA reception:  %u overruns, %u raw words, %u outputs\n", AR_rawOverruns, AR_rawTotal, kept);
+	CHECK(AR_rawOverruns == 1, "DMA reception: %u overruns", AR_rawOverruns);
+	CHECK(AR_rawTotal == MAXSAMPLES-ADC_DMA_BLOCK, "DMA reception: %u raw words kept", AR_rawTotal);
+	CHECK(difference(kept) < 1e-4, "DMA reception: outputs differ");
+	ADC_dmaMode = FALSE;
+
+	return TEST_report("test_blocks");
+}
@@ -0,0 +1,149 @@
+/***************************************************************
+	Filename:	test_codec.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Lossless delta codec of float sample packets
+		(AR_compress). Block data sent with the codec, by single
+		and burst writes, must decode on the PC (DECODE_samples,
+		ENCODE_DELTA) to the same floats bit for bit, in packets
+		of the announced size. CODEC_cycles must
+		count the sizing pass (process_deltaWords) as well as the
+		coding one. Prints the compression ratio and the encode
+		cost per sample of a few signals; on the host the cycles
+		are nanoseconds.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	4000
+#define TEST_REPEAT		50
+
+static float chA[TEST_SAMPLES];
+static float chB[TEST_SAMPLES];
+static float gotA[TEST_SAMPLES];
+static float gotB[TEST_SAMPLES];
+static const char * names[] = {"demodulated", "noisy", "zero"};
+static const char * modes[] = {"single", "burst"};
+
+
+/************************************************************
+	Function:	static void fill (int signal)
+	Description:	Channels of the given kind: slowly varying
+		demodulator outputs, full scale noise, or all zero.
+************************************************************/
+static void fill(int signal)
+{
+	unsigned int k;
+
+	for(k = 0; k < TEST_SAMPLES; k++){
+		if(signal == 0){
+			chA[k] = 0.25 + 0.01*sin(0.001*k);
+			chB[k] = -0.125 + 0.01*cos(0.001*k);
+		}else if(signal == 1){
+			chA[k] = TEST_noise();
+			chB[k] = TEST_noise();
+		}else{
+			chA[k] = chB[k] = 0;
+		}
+	}
+}
+
+
+/************************************************************
+	Function:	static void send (int mode, unsigned int samples)
+	Description:	One block data packet with the codec, decoded
+		by the PC.
+************************************************************/
+static void send(int mode, unsigned int samples)
+{
+	unsigned int got, packets, offset = 0, size, bytes;
+	const unsigned char * packet;
+
+	USB_writeMode = mode;
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	bytes = 1 + 4 + process_sampleBytes(samples, chA, chB);
+	CHECK(process_sendBlockData(3, samples, chA, chB) == TRUE, "%s: send failed", modes[mode]);
+	HOST_usbDrainAll();
+
+	CHECK(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size) && size == bytes
+		&& offset == HOST_usbCaptured, "%s: packet of %u bytes announced, %u read", modes[mode], bytes,
+		HOST_usbCaptured);
+	got = DECODE_collect(HOST_usbCapture, HOST_usbCaptured, USB_MSG_SENDBLOCKDATA, 4,
+				ENCODE_DELTA, gotA, gotB, TEST_SAMPLES, &packets);
+	CHECK(got == samples && memcmp(gotA, chA, samples*sizeof(float)) == 0
+		&& memcmp(gotB, chB, samples*sizeof(float)) == 0, "%s: %u samples, %u decoded, not the same",
+		modes[mode], samples, got);
+}
+
+
+int main(void)
+{
+	unsigned int r, offset, size, decoded;
+	const unsigned char * packet;
+	int signal, mode;
+	double seconds;
+
+	TEST_boot();
+	DSP_sampleEncoding = ENCODE_FLOAT32;
+	AR_compress = TRUE;
+
+	// Same floats on the PC, whatever the write mode and block length
+	for(signal = 0; signal < 3; signal++){
+		fill(signal);
+		for(mode = USB_WRITE_SINGLE; mode <= USB_WRITE_BURST; mode++){
+			send(mode, TEST_SAMPLES);
+			send(mode, CODEC_BLOCK + 2);
+			send(mode, 1);
+		}
+	}
+	USB_writeMode = USB_WRITE_BURST;
+
+	// The sizing pass is encode time
+	fill(0);
+	CODEC_cycles = 0;
+	CODEC_samples = 0;
+	process_sampleBytes(TEST_SAMPLES, chA, chB);
+	CHECK(CODEC_cycles > 0 && CODEC_samples == 0, "sizing pass: %u cycles, %u samples", CODEC_cycles,
+		CODEC_samples);
+
+	// Compression ratio and encode cost per sample, sizing included
+	printf("signal       ratio  encode ns/sample  decode ns/sample\n");
+	for(signal = 0; signal < 3; signal++){
+		fill(signal);
+		CODEC_samples = 0;
+		CODEC_rawBytes = 0;
+		CODEC_packedBytes = 0;
+		CODEC_cycles = 0;
+		HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+		for(r = 0; r < TEST_REPEAT; r++){
+			process_sendBlockData(r, TEST_SAMPLES, chA, chB);
+		}
+		HOST_usbDrainAll();
+		offset = 0;
+		decoded = 0;
+		seconds = TEST_seconds();
+		while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+			decoded += DECODE_samples(&packet[5], size-5, ENCODE_DELTA, gotA, gotB, TEST_SAMPLES);
+		}
+		seconds = TEST_seconds() - seconds;
+		printf("%-11s  %5.2f  %16.1f  %16.1f\n", names[signal], (double)CODEC_rawBytes/CODEC_packedBytes,
+			(double)CODEC_cycles/CODEC_samples, 1e9*seconds/(2.0*decoded));
+		CHECK(decoded == TEST_REPEAT*TEST_SAMPLES, "%s: %u samples decoded", names[signal], decoded);
+		CHECK(CODEC_samples == 2*TEST_REPEAT*TEST_SAMPLES, "%u samples counted", CODEC_samples);
+		if(signal == 0){
+			CHECK(CODEC_rawBytes > 2*CODEC_packedBytes, "demodulated: ratio %.2f",
+				(double)CODEC_rawBytes/CODEC_packedBytes);
+		}
+	}
+
+	USB_writeMode = USB_WRITE_SINGLE;
+	AR_compress = FALSE;
+
+	return TEST_report("test_codec");
+}
@@ -0,0 +1,145 @@
+/***************************************************************
+	Filename:	test_decimator.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	The polyphase decimator of the per sample IF path
+		against the full rate low pass, on a synthetic IF tone with
+		noise fed through the SPORT3 interrupt. Also checks that a
+		decimation command only takes effect on the next run.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913		// DDS increment difference: LO near 0.1 cycles/sample
+#define TEST_IF_OFFSET	0.0007		// IF tone offset from the LO, cycles/sample
+#define TEST_VOLTS		0.5
+#define TEST_NOISE		0.01
+#define TEST_WORDS		8192
+
+static unsigned int words[TEST_WORDS];
+static float refI[TEST_WORDS];
+static float refQ[TEST_WORDS];
+static float stateI[TAPS_FIR_LP];
+static float stateQ[TAPS_FIR_LP];
+
+
+/************************************************************
+	Function:	static void reference (unsigned int inc)
+	Description:	Full rate demodulation of words[], one fir()
+		per channel as the undecimated per sample path.
+************************************************************/
+static void reference(unsigned int inc)
+{
+	unsigned int n, acc = 0;
+	float volts, lo_sin, lo_cos;
+
+	memset(stateI, 0, sizeof(stateI));
+	memset(stateQ, 0, sizeof(stateQ));
+	for(n = 0; n < TEST_WORDS; n++){
+		volts = (((int)(words[n]>>16)&0xffff)-CAL_CHB_DECIMAL)*2.5/65536;
+		signal_SinCos(acc, &lo_sin, &lo_cos);
+		refI[n] = fir(4*volts*lo_cos, LP_FIR_coeffs, stateI, TAPS_FIR_LP);
+		refQ[n] = fir(4*volts*lo_sin, LP_FIR_coeffs, stateQ, TAPS_FIR_LP);
+		acc += inc;
+	}
+}
+
+
+/************************************************************
+	Function:	static unsigned int run (unsigned int outputs, int change)
+	Return:		Samples fed before the run finished
+	Description:	One finite IF run through IRQ_ADC_SampleDone.
+		With change set a decimation command arrives half way.
+************************************************************/
+static unsigned int run(unsigned int outputs, int change)
+{
+	unsigned char command[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, 0};
+	unsigned int n;
+
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(outputs-1, 10, FALSE);
+	for(n = 0; n < TEST_WORDS && !AR_finishedFlag; n++){
+		if(change && n == TEST_WORDS/2){
+			command[1] = change;
+			CHECK(TEST_command(command, sizeof(command)) == TRUE, "decimation command");
+		}
+		HOST_adcSample(words[n]);
+	}
+	return n;
+}
+
+
+/************************************************************
+	Function:	static void compare (unsigned int decimation, unsigned int outputs)
+	Description:	Output k of a run decimated by M is the full
+		rate output of sample k*M.
+************************************************************/
+static void compare(unsigned int decimation, unsigned int outputs)
+{
+	unsigned int k, n;
+	double error = 0, peak = 0;
+
+	for(k = 0; k < outputs; k++){
+		n = k*decimation;
+		error = fmax(error, fabs(AR_bufferChA[k] - refI[n]));
+		error = fmax(error, fabs(AR_bufferChB[k] - refQ[n]));
+		peak = fmax(peak, hypot(refI[n], refQ[n]));
+	}
+	printf("decimation %2u: %4u outputs, peak %.4f V, max error %.3g V\n",
+		decimation, outputs, peak, error);
+	CHECK(peak > TEST_VOLTS, "decimation %u: no baseband tone (peak %g)", decimation, peak);
+	CHECK(error <= 1e-5*peak, "decimation %u: error %g", decimation, error);
+}
+
+
+int main(void)
+{
+	static const unsigned int factors[] = {1, 2, 3, 4, 8, 16, 64};
+	unsigned char command[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, 0};
+	unsigned int f, m, n, outputs;
+	double cycles;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DSP_blockSize = 0;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + TEST_IF_OFFSET;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, TEST_VOLTS, 0.3, TEST_NOISE);
+	}
+	reference(TEST_LO_STEP*1200);
+
+	for(f = 0; f < sizeof(factors)/sizeof(factors[0]); f++){
+		m = factors[f];
+		command[1] = m;
+		CHECK(TEST_command(command, sizeof(command)) == TRUE, "decimation command");
+		outputs = TEST_WORDS/m - 1;
+		if(outputs > MAX_SAMPLES_BUFFER_SIZE - 1) outputs = MAX_SAMPLES_BUFFER_SIZE - 1;
+		n = run(outputs, 0);
+		CHECK(AR_finishedFlag, "decimation %u: run did not finish", m);
+		CHECK(n == (outputs-1)*m + 1, "decimation %u: %u samples for %u outputs", m, n, outputs);
+		CHECK(DSP_decimation == m, "decimation %u: active %u", m, DSP_decimation);
+		compare(m, outputs);
+	}
+
+	// A command during a run is kept for the next one
+	command[1] = 4;
+	TEST_command(command, sizeof(command));
+	outputs = TEST_WORDS/4 - 1;
+	run(outputs, 8);
+	CHECK(DSP_decimation == 4, "decimation changed during the run: %u", DSP_decimation);
+	CHECK(DSP_decimationRequest == 8, "request lost: %u", DSP_decimationRequest);
+	compare(4, outputs);
+	outputs = TEST_WORDS/8 - 1;
+	run(outputs, 0);
+	CHECK(DSP_decimation == 8, "request not applied: %u", DSP_decimation);
+	compare(8, outputs);
+
+	return TEST_report("test_decimator");
+}
@@ -0,0 +1,167 @@
+/***************************************************************
+	Filename:	test_dft.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Single bin sliding DFT (MODE_DFT) against the FIR
+		path of MODE_IF: amplitude and phase of a probe tone at the
+		LO frequency, with an interfering tone and noise. Also checks
+		that a DFT command only takes effect on the next run.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913		// DDS increment difference: LO near 0.1 cycles/sample
+#define TEST_WINDOW		250			// Whole LO cycles, and 2 LO a DFT null
+#define TEST_RATE		10
+#define TEST_VOLTS		0.5
+#define TEST_PHASE		0.3
+#define TEST_SPUR		0.2			// Interfering tone, 6 bins off the LO
+#define TEST_NOISE		0.02
+#define TEST_WORDS		8192
+#define TEST_SETTLE		(TAPS_FIR_LP + TEST_WINDOW)	// Samples before both are settled
+
+static unsigned int words[TEST_WORDS];
+static float firI[MAX_SAMPLES_BUFFER_SIZE];
+static float firQ[MAX_SAMPLES_BUFFER_SIZE];
+static float dftI[MAX_SAMPLES_BUFFER_SIZE];
+static float dftQ[MAX_SAMPLES_BUFFER_SIZE];
+
+
+/************************************************************
+	Function:	static unsigned int run (unsigned int block, unsigned int outputs, int change)
+	Argument:	block - DSP_blockSize, 0 for the point by point path
+				outputs - Outputs of the finite run
+				change - Window of a DFT command sent half way, 0 for none
+	Return:		Samples fed before the run finished
+************************************************************/
+static unsigned int run(unsigned int block, unsigned int outputs, int change)
+{
+	unsigned char command[USB_MSG_DFT_SIZE] = {USB_MSG_DFT, 0, 0, 0, 1};
+	unsigned int n;
+
+	DSP_blockSize = block;
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(outputs-1, 10, FALSE);
+	for(n = 0; n < TEST_WORDS && !AR_finishedFlag; n++){
+		if(change && n == TEST_WORDS/2){
+			command[1] = change>>8;
+			command[2] = change;
+			CHECK(TEST_command(command, sizeof(command)) == TRUE, "DFT command");
+		}
+		HOST_adcSample(words[n]);
+		if(block && n%64 == 63){
+			DSP_ProcessBlocks();
+		}
+	}
+	while(block && !AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+	return n;
+}
+
+
+/************************************************************
+	Function:	static void estimate (const float * i, const float * q, unsigned int first,
+					unsigned int outputs, double * amplitude, double * phase, double * spread)
+	Description:	Mean phasor of the settled outputs, and the RMS
+		distance of the outputs from it.
+************************************************************/
+static void estimate(const float * i, const float * q, unsigned int first, unsigned int outputs,
+					double * amplitude, double * phase, double * spread)
+{
+	unsigned int k;
+	double sumI = 0, sumQ = 0, power = 0;
+
+	for(k = first; k < outputs; k++){
+		sumI += i[k];
+		sumQ += q[k];
+	}
+	sumI /= outputs - first;
+	sumQ /= outputs - first;
+	for(k = first; k < outputs; k++){
+		power += (i[k]-sumI)*(i[k]-sumI) + (q[k]-sumQ)*(q[k]-sumQ);
+	}
+	*amplitude = hypot(sumI, sumQ);
+	*phase = atan2(sumQ, sumI);
+	*spread = sqrt(power/(outputs - first));
+}
+
+
+int main(void)
+{
+	unsigned char window[USB_MSG_DFT_SIZE] = {USB_MSG_DFT, TEST_WINDOW>>8, TEST_WINDOW&0xff, 0, TEST_RATE};
+	unsigned char decimation[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, TEST_RATE};
+	unsigned int n, k, outputs;
+	double lo, angle, volts, error, gain = 0;
+	double firAmplitude, firPhase, firSpread, dftAmplitude, dftPhase, dftSpread;
+
+	TEST_boot();
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	lo = TEST_LO_STEP*1200.0/4294967296.0;
+	for(n = 0; n < TEST_WORDS; n++){
+		angle = 2*M_PI*fmod(lo*n, 1.0);
+		volts = TEST_VOLTS*cos(angle + TEST_PHASE)
+			+ TEST_SPUR*cos(angle + 2*M_PI*fmod(6.0*n/TEST_WINDOW, 1.0))
+			+ TEST_NOISE*TEST_noise();
+		words[n] = TEST_ifWord(n, 0, volts, 0, 0);
+	}
+	outputs = TEST_WORDS/TEST_RATE - 1;
+
+	// FIR path, decimated to the DFT output rate
+	OpMode = MODE_IF;
+	TEST_command(decimation, sizeof(decimation));
+	run(0, outputs, 0);
+	CHECK(AR_finishedFlag, "FIR run did not finish");
+	memcpy(firI, AR_bufferChA, outputs*sizeof(float));
+	memcpy(firQ, AR_bufferChB, outputs*sizeof(float));
+
+	// Single bin DFT, point by point and in blocks
+	OpMode = MODE_DFT;
+	TEST_command(window, sizeof(window));
+	n = run(0, outputs, 0);
+	CHECK(AR_finishedFlag, "DFT run did not finish");
+	CHECK(n == outputs*TEST_RATE, "%u samples for %u outputs", n, outputs);
+	memcpy(dftI, AR_bufferChA, outputs*sizeof(float));
+	memcpy(dftQ, AR_bufferChB, outputs*sizeof(float));
+	run(512, outputs, 0);
+	error = 0;
+	for(k = 0; k < outputs; k++){
+		error = fmax(error, fabs(AR_bufferChA[k] - dftI[k]));
+		error = fmax(error, fabs(AR_bufferChB[k] - dftQ[k]));
+	}
+	CHECK(error == 0, "block and point by point DFT differ by %g V", error);
+
+	// The low pass does not have unit gain at DC: compare in tone volts
+	for(k = 0; k < TAPS_FIR_LP; k++){
+		gain += LP_FIR_coeffs[k];
+	}
+	estimate(firI, firQ, TEST_SETTLE/TEST_RATE, outputs, &firAmplitude, &firPhase, &firSpread);
+	firAmplitude /= gain;
+	firSpread /= gain;
+	estimate(dftI, dftQ, TEST_SETTLE/TEST_RATE, outputs, &dftAmplitude, &dftPhase, &dftSpread);
+	printf("FIR DC gain %.4f\n", gain);
+	printf("tone %.3f V at %.4f rad: FIR %.4f V %.4f rad (rms %.4f V), DFT %.4f V %.4f rad (rms %.4f V)\n",
+		2*TEST_VOLTS, -TEST_PHASE, firAmplitude, firPhase, firSpread, dftAmplitude, dftPhase, dftSpread);
+	CHECK(fabs(dftAmplitude - firAmplitude) < 0.002*firAmplitude, "amplitude %g, FIR %g", dftAmplitude, firAmplitude);
+	CHECK(fabs(dftPhase - firPhase) < 0.002, "phase %g, FIR %g", dftPhase, firPhase);
+	CHECK(fabs(dftAmplitude - 2*TEST_VOLTS) < 0.005, "amplitude %g", dftAmplitude);
+	CHECK(fabs(dftPhase + TEST_PHASE) < 0.005, "phase %g", dftPhase);
+
+	// A command during a run is kept for the next one
+	TEST_command(window, sizeof(window));
+	run(0, outputs, 2*TEST_WINDOW);
+	CHECK(DFT_window == TEST_WINDOW, "window changed during the run: %u", DFT_window);
+	CHECK(DFT_windowRequest == 2*TEST_WINDOW, "request lost: %u", DFT_windowRequest);
+	CHECK(memcmp(AR_bufferChA, dftI, outputs*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, dftQ, outputs*sizeof(float)) == 0, "outputs changed during the run");
+	run(0, outputs, 0);
+	CHECK(DFT_window == 2*TEST_WINDOW, "request not applied: %u", DFT_window);
+
+	return TEST_report("test_dft");
+}
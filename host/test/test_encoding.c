@@ -0,0 +1,111 @@
+/***************************************************************
+	Filename:	test_encoding.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Sample packet encodings (USB_MSG_ENCODING). Block
+		data sent as float32, int16 and int24 must decode on the PC
+		(DECODE_samples) to the samples within half a code, plus the
+		float rounding, for channels of odd lengths and longer than
+		ENCODE_CHUNK. Values that land just above the largest code
+		must be clamped, not wrap to the other sign.
+
+***************************************************************/
+
+#include <math.h>
+#include <float.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	(3*ENCODE_CHUNK + 37)
+
+static float chA[TEST_SAMPLES];
+static float chB[TEST_SAMPLES];
+static float gotA[TEST_SAMPLES];
+static float gotB[TEST_SAMPLES];
+static const char * names[] = {"float32", "int16", "int24"};
+
+
+/************************************************************
+	Function:	static void clamp (int encoding, int limit)
+	Description:	Both peaks a little more than half a code
+		above the largest one must give +-limit.
+************************************************************/
+static void clamp(int encoding, int limit)
+{
+	float peaks[4] = {1.0, -1.0, 0.5, -0.25};
+
+	signal_EncodeSamples(4, peaks, limit + 0.7, encoding);
+	printf("%s: peaks of %.1f codes encode to %d and %d\n", names[encoding], limit + 0.7,
+		ENC_quantized[0], ENC_quantized[1]);
+	CHECK(ENC_quantized[0] == limit && ENC_quantized[1] == -limit, "%s: peaks encode to %d and %d",
+		names[encoding], ENC_quantized[0], ENC_quantized[1]);
+	CHECK(ENC_quantized[2] == (int)((limit + 0.7)/2 + 0.5), "%s: half peak encodes to %d",
+		names[encoding], ENC_quantized[2]);
+}
+
+
+/************************************************************
+	Function:	static void send (int encoding, unsigned int samples)
+	Description:	A block data packet of samples per channel in
+		the encoding, decoded by the PC.
+************************************************************/
+static void send(int encoding, unsigned int samples)
+{
+	unsigned char command[USB_MSG_ENCODING_SIZE] = {USB_MSG_ENCODING, 0};
+	unsigned int got, packets, k, bad = 0;
+	float scale, error = 0;
+
+	command[1] = encoding;
+	TEST_command(command, sizeof(command));
+	CHECK(DSP_sampleEncoding == encoding, "encoding %d selected", DSP_sampleEncoding);
+
+	scale = signal_EncodeScale(samples, chA, chB, encoding);
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	process_sendBlockData(7, samples, chA, chB);
+	HOST_usbDrainAll();
+	got = DECODE_collect(HOST_usbCapture, HOST_usbCaptured, USB_MSG_SENDBLOCKDATA, 4,
+				encoding, gotA, gotB, TEST_SAMPLES, &packets);
+	for(k = 0; k < got; k++){
+		error = fmaxf(error, fmaxf(fabsf(gotA[k] - chA[k]), fabsf(gotB[k] - chB[k])));
+		// Half a code, plus the float rounding of code times scale
+		bad += fabsf(gotA[k] - chA[k]) > 0.5*scale + fabsf(chA[k])*FLT_EPSILON;
+		bad += fabsf(gotB[k] - chB[k]) > 0.5*scale + fabsf(chB[k])*FLT_EPSILON;
+	}
+
+	printf("%-7s %4u samples: %u decoded, max error %.3g (%.3f codes)\n", names[encoding], samples,
+		got, error, encoding == ENCODE_FLOAT32 ? 0 : error/scale);
+	CHECK(packets == 1 && got == samples, "%s: %u samples decoded of %u", names[encoding], got, samples);
+	if(encoding == ENCODE_FLOAT32){
+		CHECK(error == 0, "float32: error %g", error);
+	}else{
+		CHECK(bad == 0, "%s: %u samples off by more than half a code", names[encoding], bad);
+	}
+}
+
+
+int main(void)
+{
+	unsigned int k;
+	int encoding;
+
+	TEST_boot();
+	for(k = 0; k < TEST_SAMPLES; k++){
+		chA[k] = 0.8*sin(0.0123*k) + 0.01*TEST_noise();
+		chB[k] = -0.3*cos(0.0456*k) + 0.01*TEST_noise();
+	}
+	chA[100] = -1.25;		// Peak, negative
+
+	clamp(ENCODE_INT16, 32767);
+	clamp(ENCODE_INT24, 8388607);
+
+	for(encoding = ENCODE_FLOAT32; encoding <= ENCODE_INT24; encoding++){
+		send(encoding, TEST_SAMPLES);
+		send(encoding, TEST_SAMPLES - 2);
+		send(encoding, 1);
+	}
+	DSP_sampleEncoding = ENCODE_FLOAT32;
+
+	return TEST_report("test_encoding");
+}
@@ -0,0 +1,133 @@
+/***************************************************************
+	Filename:	test_firoffload.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	FIR accelerator offload of the block low pass
+		(DSP_ProcessBlocksFIR) on the accelerator model: outputs
+		against the core block path, TCB chains, the bound on the
+		outputs written and the refusal of continuous runs.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913
+#define TEST_WORDS		(2*MAXSAMPLES)
+#define TEST_POLL		128
+
+static unsigned int words[TEST_WORDS];
+static float coreI[MAX_SAMPLES_BUFFER_SIZE];
+static float coreQ[MAX_SAMPLES_BUFFER_SIZE];
+
+
+/************************************************************
+	Function:	static unsigned int run (unsigned int outputs, unsigned int start_index)
+	Argument:	outputs - Outputs requested
+				start_index - AR_bufferIndex forced after the start, to
+					leave less room in the sample buffers
+	Return:		Outputs of the run
+************************************************************/
+static unsigned int run(unsigned int outputs, unsigned int start_index)
+{
+	unsigned int n;
+
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(outputs-1, 10, FALSE);
+	AR_bufferIndex = start_index;
+	for(n = 0; n < TEST_WORDS && ADC_sampling; n++){
+		HOST_adcSample(words[n]);
+		if((n+1)%TEST_POLL == 0){
+			DSP_ProcessBlocks();
+		}
+	}
+	while(!AR_finishedFlag){
+		DSP_ProcessBlocks();
+	}
+	return AR_bufferIndex + 1 - start_index;
+}
+
+
+int main(void)
+{
+	static const unsigned int decimations[] = {1, 3, 8};
+	static const unsigned int blocks[] = {100, 512, 1024};
+	unsigned char decimation[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, 0};
+	unsigned char offload[USB_MSG_FIROFFLOAD_SIZE] = {USB_MSG_FIROFFLOAD, 0};
+	unsigned char start[USB_MSG_ADC_SAMPLING_SIZE] = {USB_MSG_ADC_SAMPLING, 0, 0, 0, 10, 1, 0, 0, 0x0f, 0xff, 0};
+	unsigned int d, b, m, outputs, got, chains, k, n;
+	double error, cycles;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + 0.0007;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, 0.5, 0.3, 0.01);
+	}
+
+	for(d = 0; d < sizeof(decimations)/sizeof(decimations[0]); d++){
+		m = decimations[d];
+		decimation[1] = m;
+		TEST_command(decimation, sizeof(decimation));
+		outputs = 4000/m;
+		for(b = 0; b < sizeof(blocks)/sizeof(blocks[0]); b++){
+			DSP_blockSize = blocks[b];
+			offload[1] = 0;
+			TEST_command(offload, sizeof(offload));
+			DSP_filterEngine = DSP_ENGINE_DIRECT;
+			run(outputs, 0);
+			memcpy(coreI, AR_bufferChA, outputs*sizeof(float));
+			memcpy(coreQ, AR_bufferChB, outputs*sizeof(float));
+
+			offload[1] = 1;
+			TEST_command(offload, sizeof(offload));
+			chains = HOST_firChains;
+			got = run(outputs, 0);
+			chains = HOST_firChains - chains;
+			error = 0;
+			for(k = 0; k < outputs; k++){
+				error = fmax(error, fabs(AR_bufferChA[k] - coreI[k]));
+				error = fmax(error, fabs(AR_bufferChB[k] - coreQ[k]));
+			}
+			printf("decimation %u, block %4u: %u outputs, %u accelerator chains, max error %.3g V\n",
+				m, blocks[b], got, chains, error);
+			CHECK(DSP_firOffloadActive, "offload not used");
+			CHECK(got == outputs, "decimation %u block %u: %u outputs", m, blocks[b], got);
+			CHECK(error < 1e-5, "decimation %u block %u: error %g", m, blocks[b], error);
+			CHECK(chains >= (outputs*m + FIR_ACC_WINDOW-1)/FIR_ACC_WINDOW, "%u chains", chains);
+		}
+	}
+	CHECK(HOST_firTcbErrors == 0, "%u inconsistent TCB chains", HOST_firTcbErrors);
+
+	// Outputs never go past the sample buffers, with or without offload
+	decimation[1] = 1;
+	TEST_command(decimation, sizeof(decimation));
+	DSP_blockSize = 256;
+	for(k = 0; k < 2; k++){
+		offload[1] = k;
+		TEST_command(offload, sizeof(offload));
+		DSP_outputOverflows = 0;
+		got = run(2000, MAX_SAMPLES_BUFFER_SIZE-1000);
+		printf("%s: run cut to %u outputs, %u overflows\n", k ? "offload" : "core", got, DSP_outputOverflows);
+		CHECK(AR_bufferIndex <= MAX_SAMPLES_BUFFER_SIZE-1, "outputs past the buffers: %u", AR_bufferIndex);
+		CHECK(got > 0 && got <= 1000, "%u outputs kept", got);
+		CHECK(DSP_outputOverflows == 1, "%u overflows", DSP_outputOverflows);
+	}
+
+	// A continuous block run is refused while the offload is enabled
+	ADC_sampling = FALSE;
+	CHECK(processADCStartSampling(sizeof(start), start) == USB_WRONG_CMD, "continuous run with offload accepted");
+	CHECK(ADC_sampling == FALSE, "continuous run started");
+	offload[1] = 0;
+	TEST_command(offload, sizeof(offload));
+	CHECK(processADCStartSampling(sizeof(start), start) == TRUE, "continuous run refused");
+	CHECK(ADC_sampling == TRUE, "continuous run not started");
+	ADC_StopSampling();
+
+	return TEST_report("test_firoffload");
+}
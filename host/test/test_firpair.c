@@ -0,0 +1,95 @@
+/***************************************************************
+	Filename:	test_firpair.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	The paired A/B filter (fir_pair, SSE on the host)
+		against the scalar path of two fir() calls: the outputs must
+		be bit identical. Also prints the cost of both per sample.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	100000
+#define TEST_TAPS_MAX	TAPS_FIR_LP
+
+static float coeffs[TEST_TAPS_MAX];
+static float coeffs2[2*TEST_TAPS_MAX];
+static float states2[4*TEST_TAPS_MAX];
+static float stateA[TEST_TAPS_MAX];
+static float stateB[TEST_TAPS_MAX];
+static float input[2][TEST_SAMPLES];
+static float paired[2][TEST_SAMPLES];
+static float scalar[2][TEST_SAMPLES];
+
+
+/************************************************************
+	Function:	static void compare (const float * h, int taps)
+	Description:	Filters the same random A/B input both ways.
+************************************************************/
+static void compare(const float * h, int taps, const char * name)
+{
+	int k, n, index = 0, mismatches = 0;
+	double start, pair_time, scalar_time;
+
+	for(k = 0; k < taps; k++){
+		coeffs[k] = h[k];
+		coeffs2[2*k] = coeffs2[2*k+1] = h[k];
+	}
+	memset(states2, 0, sizeof(states2));
+	memset(stateA, 0, sizeof(stateA));
+	memset(stateB, 0, sizeof(stateB));
+
+	start = TEST_seconds();
+	for(n = 0; n < TEST_SAMPLES; n++){
+		paired[0][n] = input[0][n];
+		paired[1][n] = input[1][n];
+		fir_pair(&paired[0][n], &paired[1][n], coeffs2, states2, &index, taps);
+	}
+	pair_time = TEST_seconds() - start;
+
+	start = TEST_seconds();
+	for(n = 0; n < TEST_SAMPLES; n++){
+		scalar[0][n] = fir(input[0][n], coeffs, stateA, taps);
+		scalar[1][n] = fir(input[1][n], coeffs, stateB, taps);
+	}
+	scalar_time = TEST_seconds() - start;
+
+	for(n = 0; n < TEST_SAMPLES; n++){
+		if(memcmp(&paired[0][n], &scalar[0][n], sizeof(float))
+			|| memcmp(&paired[1][n], &scalar[1][n], sizeof(float))){
+			mismatches++;
+		}
+	}
+	printf("%-12s %3d taps: fir_pair %6.1f ns, 2 x fir() %6.1f ns per sample pair, %d mismatches\n",
+		name, taps, 1e9*pair_time/TEST_SAMPLES, 1e9*scalar_time/TEST_SAMPLES, mismatches);
+	CHECK(mismatches == 0, "%s: %d outputs differ", name, mismatches);
+}
+
+
+int main(void)
+{
+	static float random_taps[TEST_TAPS_MAX];
+	static const int taps[] = {1, 2, 3, 64, 65};
+	int k, n;
+
+	TEST_seed(7);
+	for(n = 0; n < TEST_SAMPLES; n++){
+		input[0][n] = TEST_noise();
+		input[1][n] = TEST_noise();
+	}
+	for(k = 0; k < TEST_TAPS_MAX; k++){
+		random_taps[k] = TEST_noise()/16;
+	}
+
+	compare(LP_FIR_coeffs, TAPS_FIR_LP, "low pass");
+	compare(BP_FIR_coeffs, TAPS_FIR, "band pass");
+	for(k = 0; k < sizeof(taps)/sizeof(taps[0]); k++){
+		compare(random_taps, taps[k], "random");
+	}
+
+	return TEST_report("test_firpair");
+}
@@ -0,0 +1,86 @@
+/***************************************************************
+	Filename:	test_lodrift.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Phase and magnitude error of the block mixer LO over
+		10^7 samples, against the exact phase of the 32 bit phase
+		accumulator. Built with the table LO and with LO_ROTATOR,
+		where it also runs the rotator free, without the reseed of
+		every block.
+
+***************************************************************/
+
+#include <math.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	10000000
+#define TEST_LO_INC		(357913u*1200+12345)	// LO near 0.1 cycles/sample, no short period
+#define TEST_CODE		8192				// Raw input, 0.3125 V: mixer output magnitude 1.25
+
+static float mixI[TEST_SAMPLES];
+static float mixQ[TEST_SAMPLES];
+
+
+/************************************************************
+	Function:	static void errors (unsigned int samples, unsigned int acc,
+					double * phase, double * magnitude)
+	Description:	Largest phase error (rad) and relative magnitude
+		error of mixI/mixQ, the LO having started at acc.
+************************************************************/
+static void errors(unsigned int samples, unsigned int acc, double * phase, double * magnitude)
+{
+	unsigned int n;
+	double error;
+
+	for(n = 0; n < samples; n++){
+		error = atan2(mixQ[n], mixI[n]) - 2*M_PI*(acc/4294967296.0);
+		error = remainder(error, 2*M_PI);
+		*phase = fmax(*phase, fabs(error));
+		*magnitude = fmax(*magnitude, fabs(hypot(mixI[n], mixQ[n])/1.25 - 1));
+		acc += TEST_LO_INC;
+	}
+}
+
+
+int main(void)
+{
+	unsigned int n, done, block;
+	double phase = 0, magnitude = 0;
+
+	for(n = 0; n < MAXSAMPLES; n++){
+		SAMPLES_MEMORY[n] = (CAL_CHB_DECIMAL + TEST_CODE)<<16;
+	}
+	iDDS_lut_inc = TEST_LO_INC;
+
+	// As the block paths run it: one call, one LO seed, per block
+	iDDS_lut_acc = 0x9e3779b9;
+	for(done = 0; done < TEST_SAMPLES; done += block){
+		block = TEST_SAMPLES - done;
+		if(block > DSP_BLOCK_MAX) block = DSP_BLOCK_MAX;
+		signal_MixBlock(SAMPLES_MEMORY, done, block, &mixI[done], &mixQ[done]);
+	}
+	CHECK(iDDS_lut_acc == 0x9e3779b9 + TEST_SAMPLES*TEST_LO_INC, "accumulator lost track");
+	errors(TEST_SAMPLES, 0x9e3779b9, &phase, &magnitude);
+#ifdef LO_ROTATOR
+	printf("rotator, reseeded every %d samples: phase error %.3g rad, magnitude error %.3g\n",
+		DSP_BLOCK_MAX, phase, magnitude);
+	CHECK(phase < 2e-5, "phase error %g rad", phase);
+	CHECK(magnitude < 1e-5, "magnitude error %g", magnitude);
+
+	// Free running for 10^7 samples: the drift the reseed removes
+	phase = magnitude = 0;
+	iDDS_lut_acc = 0x9e3779b9;
+	signal_MixBlock(SAMPLES_MEMORY, 0, TEST_SAMPLES, mixI, mixQ);
+	errors(TEST_SAMPLES, 0x9e3779b9, &phase, &magnitude);
+	printf("rotator, free running %d samples: phase error %.3g rad, magnitude error %.3g\n",
+		TEST_SAMPLES, phase, magnitude);
+	CHECK(magnitude < 1e-5, "renormalization: magnitude error %g", magnitude);
+#else
+	printf("table LO: phase error %.3g rad, magnitude error %.3g\n", phase, magnitude);
+	CHECK(phase < 1.001*2*M_PI/4096, "phase error %g rad", phase);
+#endif
+
+	return TEST_report("test_lodrift");
+}
@@ -0,0 +1,155 @@
+/***************************************************************
+	Filename:	test_magphase.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Magnitude and phase kernels over the full unit circle:
+		accuracy of PHASE_FAST, PHASE_PRECISE and the CORDIC variant
+		against atan2/hypot in double, with the axes, the diagonals and
+		0 included, and their cost per sample.
+
+***************************************************************/
+
+#include <math.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_POINTS		(1<<16)		// Angles around the circle
+#define TEST_REPEAT		64			// Benchmark passes
+
+static float inI[TEST_POINTS];
+static float inQ[TEST_POINTS];
+static float outA[TEST_POINTS];
+static float outP[TEST_POINTS];
+static int fixI[TEST_POINTS];
+static int fixQ[TEST_POINTS];
+static int fixA[TEST_POINTS];
+static unsigned int fixP[TEST_POINTS];
+
+
+/************************************************************
+	Function:	static void circle (double radius)
+	Description:	TEST_POINTS samples evenly around a circle,
+		starting on the I axis, so the axes and the diagonals are
+		among them. Also the 16 bit version for the CORDIC kernel.
+************************************************************/
+static void circle(double radius)
+{
+	unsigned int k;
+	double angle;
+
+	for(k = 0; k < TEST_POINTS; k++){
+		angle = 2*M_PI*k/TEST_POINTS;
+		inI[k] = radius*cos(angle);
+		inQ[k] = radius*sin(angle);
+		fixI[k] = lrint(radius*cos(angle));
+		fixQ[k] = lrint(radius*sin(angle));
+	}
+	// Exact axes, cos(pi/2) is not 0 in double
+	for(k = 0; k < TEST_POINTS; k += TEST_POINTS/4){
+		inI[k] = (k == 0) ? radius : (k == TEST_POINTS/2) ? -radius : 0;
+		inQ[k] = (k == TEST_POINTS/4) ? radius : (k == 3*TEST_POINTS/4) ? -radius : 0;
+	}
+}
+
+
+/************************************************************
+	Function:	static void accuracy (const char * name, int accuracy, double radius,
+					double phase_bound, double magnitude_bound)
+	Description:	Largest phase error (rad) and relative magnitude
+		error of DSP_MagnitudePhase on a circle.
+************************************************************/
+static void accuracy(const char * name, int accuracy, double radius, double phase_bound, double magnitude_bound)
+{
+	unsigned int k;
+	double phase = 0, magnitude = 0;
+
+	circle(radius);
+	DSP_MagnitudePhase(TEST_POINTS, inI, inQ, outA, outP, accuracy);
+	for(k = 0; k < TEST_POINTS; k++){
+		phase = fmax(phase, fabs(remainder(outP[k] - atan2(inQ[k], inI[k]), 2*M_PI)));
+		magnitude = fmax(magnitude, fabs(outA[k]/hypot(inI[k], inQ[k]) - 1));
+	}
+	printf("%-8s radius %-6g: phase error %.3g rad, magnitude error %.3g\n", name, radius, phase, magnitude);
+	CHECK(phase < phase_bound, "%s: phase error %g rad", name, phase);
+	CHECK(magnitude < magnitude_bound, "%s: magnitude error %g", name, magnitude);
+}
+
+
+/************************************************************
+	Function:	static void cordic (int radius)
+	Description:	Phase error and magnitude error in LSB of the
+		CORDIC kernel on a circle of 16 bit samples. The phase
+		resolution is that of the scaled inputs, so its bound grows
+		as the radius shrinks.
+************************************************************/
+static void cordic(int radius)
+{
+	unsigned int k;
+	double phase = 0, magnitude = 0;
+	double phase_bound = fmax(2e-7, 1e-3/radius);
+
+	circle(radius);
+	DSP_MagnitudePhaseCORDIC(TEST_POINTS, fixI, fixQ, fixA, fixP);
+	for(k = 0; k < TEST_POINTS; k++){
+		phase = fmax(phase, fabs(remainder((int)fixP[k]*(2*M_PI/4294967296.0)
+						- atan2(fixQ[k], fixI[k]), 2*M_PI)));
+		magnitude = fmax(magnitude, fabs(fixA[k] - hypot(fixI[k], fixQ[k])));
+	}
+	printf("CORDIC   radius %-6d: phase error %.3g rad, magnitude error %.3g LSB\n", radius, phase, magnitude);
+	CHECK(phase < phase_bound, "CORDIC radius %d: phase error %g rad", radius, phase);
+	CHECK(magnitude <= 1, "CORDIC radius %d: magnitude error %g LSB", radius, magnitude);
+}
+
+
+int main(void)
+{
+	static const char * names[] = {"FAST", "PRECISE"};
+	unsigned int k, r, accuracy_mode;
+	float zeroI = 0, zeroQ = 0, zeroA = 1, zeroP = 1;
+	double begin;
+
+	accuracy("FAST", PHASE_FAST, 1, 1e-3, 1e-3);
+	accuracy("FAST", PHASE_FAST, 1e-4, 1e-3, 1e-3);
+	accuracy("FAST", PHASE_FAST, 1e4, 1e-3, 1e-3);
+	accuracy("PRECISE", PHASE_PRECISE, 1, 1e-6, 1e-6);
+	accuracy("PRECISE", PHASE_PRECISE, 1e-4, 1e-6, 1e-6);
+	accuracy("PRECISE", PHASE_PRECISE, 1e4, 1e-6, 1e-6);
+	cordic(32767);
+	cordic(1000);
+	cordic(10);
+
+	// I = Q = 0 is defined: 0 for both
+	for(accuracy_mode = PHASE_FAST; accuracy_mode <= PHASE_PRECISE; accuracy_mode++){
+		DSP_MagnitudePhase(1, &zeroI, &zeroQ, &zeroA, &zeroP, accuracy_mode);
+		CHECK(zeroA == 0 && zeroP == 0, "%s at 0: %g %g", names[accuracy_mode], zeroA, zeroP);
+	}
+
+	// Cost per sample, with sqrtf/atan2f as the reference
+	circle(1);
+	for(accuracy_mode = PHASE_FAST; accuracy_mode <= PHASE_PRECISE; accuracy_mode++){
+		begin = TEST_seconds();
+		for(r = 0; r < TEST_REPEAT; r++){
+			DSP_MagnitudePhase(TEST_POINTS, inI, inQ, outA, outP, accuracy_mode);
+		}
+		printf("%-8s %.2f ns per sample\n", names[accuracy_mode],
+			1e9*(TEST_seconds() - begin)/(TEST_REPEAT*TEST_POINTS));
+	}
+	circle(32767);
+	begin = TEST_seconds();
+	for(r = 0; r < TEST_REPEAT; r++){
+		DSP_MagnitudePhaseCORDIC(TEST_POINTS, fixI, fixQ, fixA, fixP);
+	}
+	printf("CORDIC   %.2f ns per sample\n", 1e9*(TEST_seconds() - begin)/(TEST_REPEAT*TEST_POINTS));
+	circle(1);
+	begin = TEST_seconds();
+	for(r = 0; r < TEST_REPEAT; r++){
+		for(k = 0; k < TEST_POINTS; k++){
+			outA[k] = sqrtf(inI[k]*inI[k] + inQ[k]*inQ[k]);
+			outP[k] = atan2f(inQ[k], inI[k]);
+		}
+	}
+	printf("libm     %.2f ns per sample (sqrtf, atan2f)\n", 1e9*(TEST_seconds() - begin)/(TEST_REPEAT*TEST_POINTS));
+
+	return TEST_report("test_magphase");
+}
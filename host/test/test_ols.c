@@ -0,0 +1,171 @@
+/***************************************************************
+	Filename:	test_ols.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Overlap-save low pass of the block demodulation.
+		Continuous block runs must send every output once stopped,
+		the ones still in the last overlap-save segment included.
+		Also measures the cost of the direct and overlap-save engines
+		and the crossover between them.
+
+***************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_LO_STEP	357913
+#define TEST_WORDS		(3*ADC_PINGPONG_SIZE)
+#define TEST_BLOCK		1024
+#define TEST_REPEAT		16
+
+static unsigned int words[TEST_WORDS];
+static float refI[TEST_WORDS];
+static float refQ[TEST_WORDS];
+static float stateI[TAPS_FIR_LP];
+static float stateQ[TAPS_FIR_LP];
+static float gotI[TEST_WORDS];
+static float gotQ[TEST_WORDS];
+static float outI[2*TEST_BLOCK];
+static float outQ[2*TEST_BLOCK];
+
+
+static void reference(unsigned int inc)
+{
+	unsigned int n, acc = 0;
+	float volts, lo_sin, lo_cos;
+
+	memset(stateI, 0, sizeof(stateI));
+	memset(stateQ, 0, sizeof(stateQ));
+	for(n = 0; n < TEST_WORDS; n++){
+		volts = (((int)(words[n]>>16)&0xffff)-CAL_CHB_DECIMAL)*2.5/65536;
+		signal_SinCos(acc, &lo_sin, &lo_cos);
+		refI[n] = fir(4*volts*lo_cos, LP_FIR_coeffs, stateI, TAPS_FIR_LP);
+		refQ[n] = fir(4*volts*lo_sin, LP_FIR_coeffs, stateQ, TAPS_FIR_LP);
+		acc += inc;
+	}
+}
+
+
+/************************************************************
+	Function:	static void continuous (unsigned int samples)
+	Description:	Continuous block run of samples raw words, then
+		stopped, with the main loop serving DSP_ProcessFullBuffer.
+		The outputs the PC receives must be all of them.
+************************************************************/
+static void continuous(unsigned int samples)
+{
+	unsigned int n, k, got, packets;
+	double error = 0;
+
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	ADC_StartSampling(0, 10, TRUE);
+	for(n = 0; n < samples; n++){
+		HOST_adcSample(words[n]);
+		if((n+1)%64 == 0){
+			DSP_ProcessFullBuffer();
+		}
+	}
+	ADC_StopSampling();
+	while(DSP_ProcessFullBuffer());
+	HOST_usbDrainAll();
+
+	got = DECODE_collect(HOST_usbCapture, HOST_usbCaptured, USB_MSG_SENDBLOCKDATA, 4,
+				ENCODE_FLOAT32, gotI, gotQ, TEST_WORDS, &packets);
+	for(k = 0; k < got && k < samples; k++){
+		error = fmax(error, fabs(gotI[k] - refI[k]));
+		error = fmax(error, fabs(gotQ[k] - refQ[k]));
+	}
+	printf("continuous run of %5u samples: %5u outputs in %u packets, max error %.3g V\n",
+		samples, got, packets, error);
+	CHECK(DSP_filterEngine == DSP_ENGINE_OLS, "overlap-save not selected");
+	CHECK(got == samples, "%u samples, %u outputs", samples, got);
+	CHECK(error < 1e-5, "error %g", error);
+}
+
+
+/************************************************************
+	Function:	static double cost (int engine, unsigned int * outputs)
+	Argument:	engine - DSP_ENGINE_DIRECT, DSP_ENGINE_OLS, or -1 for
+					the mixing alone
+	Return:		Seconds to demodulate TEST_REPEAT rings of raw words
+************************************************************/
+static double cost(int engine, unsigned int * outputs)
+{
+	unsigned int r, start;
+	double begin;
+
+	Init_DemodulateBlock();
+	Init_OLS();
+	DSP_filterEngine = engine < 0 ? DSP_ENGINE_DIRECT : engine;
+	*outputs = 0;
+	begin = TEST_seconds();
+	for(r = 0; r < TEST_REPEAT; r++){
+		for(start = 0; start < MAXSAMPLES; start += TEST_BLOCK){
+			if(engine < 0){
+				*outputs += signal_MixBlock(SAMPLES_MEMORY, start, TEST_BLOCK, outI, outQ);
+			}else{
+				*outputs += signal_DemodulateBlock(SAMPLES_MEMORY, start, TEST_BLOCK, outI, outQ);
+			}
+		}
+	}
+	return TEST_seconds() - begin;
+}
+
+
+int main(void)
+{
+	static const unsigned int decimations[] = {1, 2, 4, 6, 7, 8, 16, 64};
+	unsigned char command[USB_MSG_DECIMATION_SIZE] = {USB_MSG_DECIMATION, 1};
+	unsigned int d, m, n, outputs, inputs;
+	double cycles, mix, direct, ols, tap, segment;
+	int chosen;
+
+	TEST_boot();
+	OpMode = MODE_IF;
+	DDS_inc_Flo = 1000;
+	DDS_inc_Fex = DDS_inc_Flo + TEST_LO_STEP;
+	cycles = TEST_LO_STEP*1200.0/4294967296.0 + 0.0007;
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, cycles, 0.5, 0.3, 0.01);
+	}
+	reference(TEST_LO_STEP*1200);
+
+	// Every output reaches the PC, however the run ends
+	TEST_command(command, sizeof(command));
+	DSP_blockSize = 512;
+	continuous(2*ADC_PINGPONG_SIZE + 1000);
+	continuous(2*ADC_PINGPONG_SIZE);
+	continuous(OLS_VALID - 42);
+	continuous(3*OLS_VALID);
+
+	// Engine cost on the host, per output and per input sample
+	memcpy(SAMPLES_MEMORY, words, MAXSAMPLES*sizeof(unsigned int));
+	iDDS_lut_inc = TEST_LO_STEP*1200;
+	inputs = TEST_REPEAT*MAXSAMPLES;
+	printf("decimation  direct ns/out  OLS ns/out  Init_OLS choice  faster\n");
+	for(d = 0; d < sizeof(decimations)/sizeof(decimations[0]); d++){
+		m = decimations[d];
+		Init_FIR_LPdecimator(m);
+		chosen = Init_OLS();
+		mix = cost(-1, &outputs);
+		direct = cost(DSP_ENGINE_DIRECT, &outputs);
+		ols = cost(DSP_ENGINE_OLS, &outputs);
+		printf("%10u  %13.1f  %10.1f  %15s  %s\n", m, 1e9*direct/outputs, 1e9*ols/outputs,
+			chosen == DSP_ENGINE_OLS ? "OLS" : "direct", direct < ols ? "direct" : "OLS");
+		if(m == 1){
+			// Filter cost alone: direct per tap of one output, OLS per input sample
+			tap = (direct - mix)/outputs/TAPS_FIR_LP;
+			segment = (ols - mix)/inputs;
+		}
+	}
+	printf("direct %.2f ns per tap and output, overlap-save %.1f ns per input sample\n", 1e9*tap, 1e9*segment);
+	printf("crossover at decimation 1: %.0f taps (cost model 37)\n", segment/tap);
+	printf("crossover at %d taps: decimation %.1f (cost model %.1f)\n", TAPS_FIR_LP, TAPS_FIR_LP*tap/segment,
+		2.0*TAPS_FIR_LP/((OLS_FFT_SIZE*OLS_FFT_LOG2*5 + OLS_FFT_SIZE*4)/OLS_VALID));
+
+	return TEST_report("test_ols");
+}
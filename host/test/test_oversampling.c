@@ -0,0 +1,184 @@
+/***************************************************************
+	Filename:	test_oversampling.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	SNR model of the boxcar oversampling
+		(ADC_oversampleBlock). A 16 bit quantized tone with 3 LSB
+		RMS of white noise is averaged for each factor. Every
+		doubling of the factor must take about 3 dB off the noise.
+		With 0.3 LSB of noise the 16 bit quantization dominates:
+		the demodulator input (ADC_RAW_VOLTS_B) must still gain,
+		where the mean rounded back to 16 bits stays near the
+		1/sqrt(12) LSB floor.
+		Also checks the factor ADC_StartSampling applies: the CNV
+		period can not go below ADC_FS_DIVIDER_MIN (100 PCG ticks),
+		so at the default divider of 250 only 2 is possible, 4 needs
+		a 20 us period and 8 a 40 us one.
+
+***************************************************************/
+
+#include <math.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_OUTPUTS	MAXSAMPLES
+#define TEST_CYCLES		0.0123				// Tone, cycles per output sample
+#define TEST_VOLTS		0.8
+#define TEST_NOISE		(3/TEST_CODES_PER_VOLT)	// 3 LSB RMS
+#define TEST_FINE		(0.3/TEST_CODES_PER_VOLT)	// Below 1 LSB
+
+static unsigned int raw[ADC_OSR_MAX*TEST_OUTPUTS];
+static unsigned int ring[MAXSAMPLES];
+static double value[TEST_OUTPUTS];
+
+
+/************************************************************
+	Function:	static double det3 (double m[3][3])
+	Return:		Determinant of m
+************************************************************/
+static double det3(double m[3][3])
+{
+	return m[0][0]*(m[1][1]*m[2][2]-m[1][2]*m[2][1]) - m[0][1]*(m[1][0]*m[2][2]-m[1][2]*m[2][0])
+		+ m[0][2]*(m[1][0]*m[2][1]-m[1][1]*m[2][0]);
+}
+
+
+/************************************************************
+	Function:	static double residual (void)
+	Return:		RMS of value in LSB once offset, cosine and sine
+		at the tone frequency are fitted by least squares
+************************************************************/
+static double residual(void)
+{
+	double s[3][3] = {{0}}, m[3][3], r[3] = {0}, x[3], v[3], e, sum = 0;
+	unsigned int n, i, j;
+
+	// Normal equations of y = x0 + x1 cos + x2 sin, solved by Cramer's rule
+	for(n = 0; n < TEST_OUTPUTS; n++){
+		v[0] = 1;
+		v[1] = cos(2*M_PI*TEST_CYCLES*n);
+		v[2] = sin(2*M_PI*TEST_CYCLES*n);
+		for(i = 0; i < 3; i++){
+			r[i] += v[i]*value[n];
+			for(j = 0; j < 3; j++){
+				s[i][j] += v[i]*v[j];
+			}
+		}
+	}
+	for(n = 0; n < 3; n++){
+		for(i = 0; i < 3; i++){
+			for(j = 0; j < 3; j++){
+				m[i][j] = j == n ? r[i] : s[i][j];
+			}
+		}
+		x[n] = det3(m)/det3(s);
+	}
+	for(n = 0; n < TEST_OUTPUTS; n++){
+		e = value[n] - x[0] - x[1]*cos(2*M_PI*TEST_CYCLES*n) - x[2]*sin(2*M_PI*TEST_CYCLES*n);
+		sum += e*e;
+	}
+	return sqrt(sum/TEST_OUTPUTS);
+}
+
+
+/************************************************************
+	Function:	static double noise (unsigned int osr, double rms, double * rounded)
+	Argument:	rms - Input noise, volts
+				rounded - Noise of the mean rounded to 16 bits
+	Return:		RMS noise of channel B in LSB at the demodulator
+	Description:	Averages osr times oversampled words block by
+		block, then takes the noise off the channel B volts the
+		demodulator reads.
+************************************************************/
+static double noise(unsigned int osr, double rms, double * rounded)
+{
+	unsigned int n;
+	double result;
+
+	TEST_seed(osr);
+	for(n = 0; n < osr*TEST_OUTPUTS; n++){
+		raw[n] = TEST_ifWord(n, TEST_CYCLES/osr, TEST_VOLTS, 0.3, rms);
+	}
+	ADC_osrSet(osr);
+	SAMPLES_MEMORY = ring;
+	AR_rawIndex = 0;
+	for(n = 0; n < osr*TEST_OUTPUTS; n += ADC_DMA_BLOCK){
+		AR_rawIndex += ADC_oversampleBlock(&raw[n]);
+	}
+
+	for(n = 0; n < TEST_OUTPUTS; n++){
+		value[n] = ADC_RAW_VOLTS_B(ring[n])*TEST_CODES_PER_VOLT;
+	}
+	result = residual();
+	for(n = 0; n < TEST_OUTPUTS; n++){
+		value[n] = floor(value[n] + 0.5);
+	}
+	*rounded = residual();
+	return result;
+}
+
+
+/************************************************************
+	Function:	static unsigned int applied (unsigned int period)
+	Return:		ADC_osr of a DMA block run at period microseconds,
+		with the largest factor requested
+************************************************************/
+static unsigned int applied(unsigned int period)
+{
+	ADC_StartSampling(999, period, FALSE);
+	ADC_StopSampling();
+	return ADC_osr;
+}
+
+
+int main(void)
+{
+	unsigned char oversampling[USB_MSG_OVERSAMPLING_SIZE] = {USB_MSG_OVERSAMPLING, ADC_OSR_MAX};
+	double rms, rounded, previous = 0, first = 0, signal;
+	unsigned int osr;
+
+	TEST_boot();
+	signal = 20*log10(TEST_VOLTS*TEST_CODES_PER_VOLT/sqrt(2));
+	for(osr = 1; osr <= ADC_OSR_MAX; osr <<= 1){
+		rms = noise(osr, TEST_NOISE, &rounded);
+		printf("osr %u: noise %.3f LSB, SNR %.1f dB", osr, rms, signal - 20*log10(rms));
+		if(osr == 1){
+			first = rms;
+			CHECK(rms > 2.9 && rms < 3.1, "noise %.3f LSB without oversampling", rms);
+		}else{
+			printf(", %.2f dB less than osr %u", 20*log10(previous/rms), osr/2);
+			CHECK(20*log10(previous/rms) > 2.6 && 20*log10(previous/rms) < 3.3,
+				"osr %u: %.2f dB per doubling", osr, 20*log10(previous/rms));
+		}
+		printf("\n");
+		previous = rms;
+	}
+	CHECK(20*log10(first/previous) > 8.5, "osr %d gains %.2f dB", ADC_OSR_MAX, 20*log10(first/previous));
+
+	// Noise below 1 LSB: only the bits below the 16 bit mean hold the gain
+	for(osr = 1; osr <= ADC_OSR_MAX; osr <<= 1){
+		rms = noise(osr, TEST_FINE, &rounded);
+		printf("osr %u, 0.3 LSB in: noise %.3f LSB, %.3f LSB rounded to 16 bits\n", osr, rms, rounded);
+		if(osr == 1){
+			first = rms;
+			CHECK(fabs(rms - rounded) < 1e-9, "noise %.3f LSB, %.3f LSB rounded", rms, rounded);
+		}
+	}
+	CHECK(20*log10(first/rms) > 6, "osr %d gains %.2f dB below 1 LSB", ADC_OSR_MAX, 20*log10(first/rms));
+	CHECK(rms < 0.5*rounded && rounded > 0.27, "osr %d: %.3f LSB, %.3f LSB rounded to 16 bits",
+		ADC_OSR_MAX, rms, rounded);
+	ADC_osrSet(1);
+
+	// Factor applied: CNV period of ADC_fsDivider/ADC_osr ticks, at least ADC_FS_DIVIDER_MIN
+	OpMode = MODE_IF;
+	DSP_blockSize = 512;
+	ADC_dmaMode = TRUE;
+	TEST_command(oversampling, sizeof(oversampling));
+	CHECK(applied(10) == 2, "osr %u at the default divider of %d", ADC_osr, ADC_FS_DIVIDER);
+	CHECK(applied(20) == 4, "osr %u at a divider of %u", ADC_osr, ADC_fsDivider);
+	CHECK(applied(40) == 8, "osr %u at a divider of %u", ADC_osr, ADC_fsDivider);
+	printf("osr %d requested: 2 at 10 us, 4 at 20 us, 8 at 40 us\n", ADC_OSR_MAX);
+
+	return TEST_report("test_oversampling");
+}
@@ -0,0 +1,104 @@
+/***************************************************************
+	Filename:	test_profiler.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	ISR profiler (DSP_PROFILE). Built with DSP_PROFILE
+		(test_profiler_profile), a point by point run must count
+		one IRQ_ADC_SampleDone per word, with consistent durations
+		and histogram, and USB_MSG_PROFILE must reply with the same
+		statistics and clear them. Built without it, as the
+		firmware is by default, nothing is counted. On the host the
+		profiler counts nanoseconds.
+
+***************************************************************/
+
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_WORDS		2000
+#define TEST_VALUES		(6+PROF_BUCKETS)
+
+
+/************************************************************
+	Function:	static int reply (int clear, unsigned int values[PROF_ISRS][TEST_VALUES])
+	Return:		TRUE if USB_MSG_PROFILE replied, decoded in values
+************************************************************/
+static int reply(int clear, unsigned int values[PROF_ISRS][TEST_VALUES])
+{
+	unsigned char command[USB_MSG_PROFILE_SIZE] = {USB_MSG_PROFILE, 0};
+	unsigned int offset = 0, size, isr, k;
+	const unsigned char * packet;
+
+	command[1] = clear;
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	TEST_command(command, sizeof(command));
+	HOST_usbDrainAll();
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+		if(packet[0] == USB_MSG_PROFILE && size == 1+PROF_ISRS*TEST_VALUES*4){
+			for(isr = 0; isr < PROF_ISRS; isr++){
+				for(k = 0; k < TEST_VALUES; k++){
+					values[isr][k] = DECODE_int(&packet[1+(isr*TEST_VALUES+k)*4]);
+				}
+			}
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+int main(void)
+{
+	unsigned int values[PROF_ISRS][TEST_VALUES];
+	unsigned int n, k, sum = 0;
+
+	TEST_boot();
+	OpMode = MODE_IQ;
+	DSP_blockSize = 0;
+	DSP_profileClear();
+
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(TEST_WORDS-1, 10, FALSE);
+	for(n = 0; n < TEST_WORDS && !AR_finishedFlag; n++){
+		HOST_adcSample(TEST_ifWord(n, 0.0123, 0.8, 0.1, 0.01));
+	}
+	CHECK(n == TEST_WORDS, "run ended after %u words", n);
+	CHECK(reply(TRUE, values), "no profile reply");
+
+#ifdef DSP_PROFILE
+	for(k = 0; k < PROF_BUCKETS; k++){
+		sum += values[PROF_ADC_SAMPLE][6+k];
+	}
+	printf("IRQ_ADC_SampleDone: %u runs, %u to %u ns, deadline %u\n", values[PROF_ADC_SAMPLE][0],
+		values[PROF_ADC_SAMPLE][1], values[PROF_ADC_SAMPLE][2], values[PROF_ADC_SAMPLE][5]);
+	CHECK(values[PROF_ADC_SAMPLE][0] == TEST_WORDS, "%u runs counted for %u words",
+		values[PROF_ADC_SAMPLE][0], TEST_WORDS);
+	CHECK(values[PROF_ADC_SAMPLE][1] <= values[PROF_ADC_SAMPLE][2], "min above max");
+	CHECK(sum == TEST_WORDS, "histogram holds %u runs", sum);
+	CHECK(values[PROF_ADC_SAMPLE][5] == ADC_fsDivider*CCLK_PER_PCG_TICK, "deadline %u",
+		values[PROF_ADC_SAMPLE][5]);
+	CHECK(values[PROF_ADC_SAMPLE][0] == PROF_count[PROF_ADC_SAMPLE] + TEST_WORDS
+		&& PROF_count[PROF_ADC_SAMPLE] == 0, "statistics not cleared by the reply");
+
+	// A run longer than the deadline, and one entered 1.5 deadlines late
+	DSP_profileRestart(PROF_ALIVE, 1000);
+	DSP_profile(PROF_ALIVE, 0, 1001);
+	DSP_profile(PROF_ALIVE, 1501, 1600);
+	DSP_profile(PROF_ALIVE, 2501, 2600);
+	CHECK(PROF_missed[PROF_ALIVE] == 2 && PROF_maxGap[PROF_ALIVE] == 1501,
+		"%u missed deadlines, max gap %u", PROF_missed[PROF_ALIVE], PROF_maxGap[PROF_ALIVE]);
+	CHECK(PROF_min[PROF_ALIVE] == 99 && PROF_max[PROF_ALIVE] == 1001, "durations %u to %u",
+		PROF_min[PROF_ALIVE], PROF_max[PROF_ALIVE]);
+#else
+	// Instrumentation left out: the ISRs count nothing
+	for(k = 0; k < PROF_ISRS; k++){
+		sum += values[k][0];
+	}
+	printf("DSP_PROFILE off: %u ISR runs counted\n", sum);
+	CHECK(sum == 0, "%u ISR runs counted without DSP_PROFILE", sum);
+#endif
+
+	return TEST_report("test_profiler");
+}
@@ -0,0 +1,97 @@
+/***************************************************************
+	Filename:	test_rawcapture.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Packed raw capture (AR_rawCaptureMode). The words the
+		host receives with RAW_CAPTURE_HOST, converted on the PC, must
+		be every word of the run and give the same volts as the
+		interrupt conversion and as RAW_CAPTURE_VOLTS.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_WORDS		12000		// Past MAX_SAMPLES_BUFFER_SIZE: the words go on in AR_bufferChB
+#define TEST_SHORT		8000		// Fits the volts buffers
+
+static unsigned int words[TEST_WORDS+1];
+static unsigned int received[TEST_WORDS+1];
+static float hostA[TEST_WORDS+1];
+static float hostB[TEST_WORDS+1];
+
+
+/************************************************************
+	Function:	static void run (char mode, unsigned int samples)
+	Description:	Point by point IQ run of samples+1 words, the
+		last one included, as ADC_StartSampling(samples) takes.
+************************************************************/
+static void run(char mode, unsigned int samples)
+{
+	unsigned char command[USB_MSG_RAWCAPTURE_SIZE] = {USB_MSG_RAWCAPTURE, 0};
+	unsigned int n;
+
+	command[1] = mode;
+	TEST_command(command, sizeof(command));
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(samples, 10, FALSE);
+	for(n = 0; n <= TEST_WORDS && !AR_finishedFlag; n++){
+		HOST_adcSample(words[n]);
+	}
+	CHECK(AR_finishedFlag && n == samples+1, "mode %d: %u words for %u samples", mode, n, samples);
+}
+
+
+int main(void)
+{
+	unsigned int n, count, offset = 0, size, packets = 0;
+	const unsigned char * packet;
+
+	TEST_boot();
+	OpMode = MODE_IQ;
+	DSP_blockSize = 0;
+	for(n = 0; n <= TEST_WORDS; n++){
+		words[n] = TEST_ifWord(n, 0.0123, 0.8, 0.1, 0.05);
+	}
+
+	// Packed words to the host, sent as the main loop does
+	run(RAW_CAPTURE_HOST, TEST_WORDS);
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	CHECK(process_sendRawData(AR_bufferIndex+1) == TRUE, "raw data not sent");
+	HOST_usbDrainAll();
+	count = 0;
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+		if(packet[0] != USB_MSG_SENDRAWDATA){
+			continue;
+		}
+		packets++;
+		// PC side: words least significant byte first, converted as the firmware does
+		for(n = 1; n + 4 <= size && count <= TEST_WORDS; n += 4, count++){
+			received[count] = packet[n] | packet[n+1]<<8 | packet[n+2]<<16 | (unsigned int)packet[n+3]<<24;
+			hostA[count] = (((int)(received[count]>>16)&0xffff)-CAL_CHB_DECIMAL)*2.5/65536;
+			hostB[count] = (((int)received[count]&0xffff)-CAL_CHA_DECIMAL)*2.5/65536;
+		}
+	}
+	printf("raw capture of %u samples: %u words received\n", TEST_WORDS, count);
+	CHECK(packets == 1, "%u raw packets", packets);
+	CHECK(count == TEST_WORDS+1, "%u words received for a run of %u", count, TEST_WORDS+1);
+	CHECK(memcmp(received, words, count*sizeof(unsigned int)) == 0, "words changed on the way");
+
+	// The interrupt converts the same words to the same volts
+	run(RAW_CAPTURE_OFF, TEST_SHORT);
+	CHECK(memcmp(AR_bufferChA, hostA, (TEST_SHORT+1)*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, hostB, (TEST_SHORT+1)*sizeof(float)) == 0,
+		"host volts differ from the interrupt conversion");
+
+	// And so does the deferred conversion, up to the last word
+	run(RAW_CAPTURE_VOLTS, TEST_SHORT);
+	CHECK(signal_ConvertRawCapture(AR_bufferIndex+1) == TEST_SHORT+1, "converted count");
+	CHECK(memcmp(AR_bufferChA, hostA, (TEST_SHORT+1)*sizeof(float)) == 0
+		&& memcmp(AR_bufferChB, hostB, (TEST_SHORT+1)*sizeof(float)) == 0,
+		"host volts differ from RAW_CAPTURE_VOLTS");
+
+	return TEST_report("test_rawcapture");
+}
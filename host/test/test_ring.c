@@ -0,0 +1,123 @@
+/***************************************************************
+	Filename:	test_ring.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Continuous acquisition ring (ADC_ringPut/ADC_ringGet)
+		under load, with a producer thread standing in for the ADC
+		interrupt and the test as the main loop. Every sample read
+		must be whole and in order, every sample missing must be a
+		counted overrun, and the high water mark must be the highest
+		level reached.
+
+***************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	10000000	// Per phase, exact in float
+#define TEST_CHUNK_MAX	(2*ADC_RING_CHUNK)
+
+static volatile unsigned int produced;
+static unsigned int burst;			// Samples between producer pauses, 0 for none
+static unsigned int level_seen;
+
+
+/************************************************************
+	Function:	static void * producer (void * arg)
+	Description:	The ADC interrupt: puts TEST_SAMPLES samples,
+		burst at a time with a pause of 20 us in between, as DMA
+		blocks arrive. Sample k is k whether it is stored or
+		dropped, as a sample the ADC converted.
+************************************************************/
+static void * producer(void * arg)
+{
+	unsigned int k;
+
+	(void)arg;
+	for(k = 0; k < TEST_SAMPLES; k++){
+		ADC_ringPut((float)k, -(float)k);
+		produced = k + 1;
+		if(burst && k%burst == burst-1){
+			usleep(20);
+		}
+	}
+	return 0;
+}
+
+
+/************************************************************
+	Function:	static void phase (const char * name, unsigned int producer_burst,
+					unsigned int consumer_pause)
+	Argument:	producer_burst - Samples between producer pauses, 0 for none
+				consumer_pause - Microseconds between gets, 0 to yield
+					only when the ring is empty
+	Description:	Runs TEST_SAMPLES through the ring and checks
+		what the consumer read against what was dropped.
+************************************************************/
+static void phase(const char * name, unsigned int producer_burst, unsigned int consumer_pause)
+{
+	static float chunkA[TEST_CHUNK_MAX], chunkB[TEST_CHUNK_MAX];
+	pthread_t thread;
+	unsigned int k, count, received = 0, missing = 0, torn = 0, backwards = 0;
+	unsigned int next = 0, level;
+
+	ADC_ringReset();
+	produced = 0;
+	level_seen = 0;
+	burst = producer_burst;
+	pthread_create(&thread, 0, producer, 0);
+	do{
+		level = ADC_ringCount();
+		if(level > level_seen) level_seen = level;
+		count = ADC_ringGet(chunkA, chunkB, 1 + rand()%TEST_CHUNK_MAX);
+		for(k = 0; k < count; k++){
+			if(chunkB[k] != -chunkA[k]){
+				torn++;
+			}
+			if(chunkA[k] < next){
+				backwards++;
+			}else{
+				missing += (unsigned int)chunkA[k] - next;
+				next = (unsigned int)chunkA[k] + 1;
+			}
+		}
+		received += count;
+		if(consumer_pause){
+			usleep(consumer_pause);
+		}else if(count == 0){
+			sched_yield();
+		}
+	}while(produced < TEST_SAMPLES || ADC_ringCount() > 0);
+	pthread_join(thread, 0);
+	missing += TEST_SAMPLES - next;
+
+	printf("%-14s %8u read, %8u dropped, high water %4u of %d\n",
+		name, received, ADC_ringOverruns, ADC_ringHighWater, ADC_RING_SIZE);
+	CHECK(torn == 0, "%s: %u samples torn between channels", name, torn);
+	CHECK(backwards == 0, "%s: %u samples out of order", name, backwards);
+	CHECK(missing == ADC_ringOverruns, "%s: %u missing, %u overruns", name, missing, ADC_ringOverruns);
+	CHECK(received + ADC_ringOverruns == TEST_SAMPLES, "%s: %u read + %u dropped", name, received, ADC_ringOverruns);
+	CHECK(ADC_ringHighWater <= ADC_RING_SIZE && ADC_ringHighWater >= level_seen,
+		"%s: high water %u, level seen %u", name, ADC_ringHighWater, level_seen);
+}
+
+
+int main(void)
+{
+	srand(1);
+
+	// Consumer keeping up, then one that falls behind and forces overruns
+	phase("paced", ADC_DMA_BLOCK, 0);
+	CHECK(ADC_ringHighWater > 0, "nothing went through the ring");
+	phase("free running", 0, 0);
+	phase("slow consumer", ADC_DMA_BLOCK, 500);
+	CHECK(ADC_ringOverruns > 0 && ADC_ringHighWater == ADC_RING_SIZE,
+		"slow consumer: %u overruns, high water %u", ADC_ringOverruns, ADC_ringHighWater);
+
+	return TEST_report("test_ring");
+}
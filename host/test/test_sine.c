@@ -0,0 +1,153 @@
+/***************************************************************
+	Filename:	test_sine.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Software LO lookup (signal_SinCos, quarter wave table)
+		against the 4096 entry table it replaced: spurious free
+		dynamic range of the complex LO and cost per sample. Built
+		twice, truncated and with SINE_INTERPOLATE.
+
+***************************************************************/
+
+#include <math.h>
+#include "hostTest.h"
+#include "h/general.h"
+
+#define TEST_FFT_LOG2	16
+#define TEST_FFT_SIZE	(1<<TEST_FFT_LOG2)
+#define TEST_BIN		1001		// LO frequency in FFT bins, odd
+#define TEST_CALLS		(1<<24)
+#define TEST_LO_INC		(357913*1200)	// LO near 0.1 cycles/sample
+
+// Table of the previous firmware and its lookup
+static float old_lut[4096] = {
+	#include "sine4096.txt"
+};
+
+static double re[TEST_FFT_SIZE];
+static double im[TEST_FFT_SIZE];
+
+
+static void old_SinCos(unsigned int phase, float * sin_ptr, float * cos_ptr)
+{
+	*sin_ptr = old_lut[phase>>20];
+	*cos_ptr = old_lut[((phase>>20)+1024)%4096];
+}
+
+
+/************************************************************
+	Function:	static void fft (void)
+	Description:	In place radix 2 FFT of re/im, in double so
+		its own rounding stays far below the table spurs.
+************************************************************/
+static void fft(void)
+{
+	unsigned int i, j, k, span;
+	double t, wr, wi, xr, xi;
+
+	for(i = 0, j = 0; i < TEST_FFT_SIZE; i++){
+		if(i < j){
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+		for(k = TEST_FFT_SIZE>>1; k && (j & k); k >>= 1){
+			j ^= k;
+		}
+		j |= k;
+	}
+	for(span = 1; span < TEST_FFT_SIZE; span <<= 1){
+		for(k = 0; k < span; k++){
+			wr = cos(M_PI*k/span);
+			wi = -sin(M_PI*k/span);
+			for(i = k; i < TEST_FFT_SIZE; i += 2*span){
+				j = i + span;
+				xr = re[j]*wr - im[j]*wi;
+				xi = re[j]*wi + im[j]*wr;
+				re[j] = re[i] - xr;
+				im[j] = im[i] - xi;
+				re[i] += xr;
+				im[i] += xi;
+			}
+		}
+	}
+}
+
+
+/************************************************************
+	Function:	static double sfdr (void (*lookup)(unsigned int, float *, float *))
+	Return:		Carrier to largest spur of cos + j sin, dB
+	Description:	The LO sits on a bin and its phase steps are
+		multiples of 2^32/TEST_FFT_SIZE, so the truncation error is
+		periodic over the FFT and every spur falls on a bin: no
+		window is needed.
+************************************************************/
+static double sfdr(void (*lookup)(unsigned int, float *, float *))
+{
+	unsigned int n, inc = TEST_BIN*(0x100000000ULL/TEST_FFT_SIZE);
+	float s, c;
+	double power, spur = 0;
+
+	for(n = 0; n < TEST_FFT_SIZE; n++){
+		lookup(n*inc, &s, &c);
+		re[n] = c;
+		im[n] = s;
+	}
+	fft();
+	for(n = 0; n < TEST_FFT_SIZE; n++){
+		power = re[n]*re[n] + im[n]*im[n];
+		if(n != TEST_BIN && power > spur){
+			spur = power;
+		}
+	}
+	power = re[TEST_BIN]*re[TEST_BIN] + im[TEST_BIN]*im[TEST_BIN];
+	return 10*log10(power/spur);
+}
+
+
+/************************************************************
+	Function:	static double cost (void (*lookup)(unsigned int, float *, float *))
+	Return:		Nanoseconds per sin/cos pair, the phase stepping
+		as in the mixer
+************************************************************/
+static double cost(void (*lookup)(unsigned int, float *, float *))
+{
+	unsigned int n, acc = 0, inc = TEST_LO_INC;
+	float s, c, sum = 0;
+	double begin = TEST_seconds();
+
+	for(n = 0; n < TEST_CALLS; n++){
+		lookup(acc, &s, &c);
+		sum += s + c;
+		acc += inc;
+	}
+	begin = TEST_seconds() - begin;
+	CHECK(fabsf(sum) < TEST_CALLS, "sum %g", sum);
+	return 1e9*begin/TEST_CALLS;
+}
+
+
+int main(void)
+{
+	double old_dB, new_dB, old_ns, new_ns;
+
+	old_dB = sfdr(old_SinCos);
+	new_dB = sfdr(signal_SinCos);
+	old_ns = cost(old_SinCos);
+	new_ns = cost(signal_SinCos);
+#ifdef SINE_INTERPOLATE
+	printf("interpolated quarter table: SFDR %.1f dBc, %.2f ns per sample\n", new_dB, new_ns);
+#else
+	printf("truncated quarter table:    SFDR %.1f dBc, %.2f ns per sample\n", new_dB, new_ns);
+#endif
+	printf("previous 4096 entry table:  SFDR %.1f dBc, %.2f ns per sample\n", old_dB, old_ns);
+
+	// 12 bits of phase for both tables: about 6 dB per bit
+	CHECK(old_dB > 66, "previous table SFDR %.1f dB", old_dB);
+	CHECK(new_dB > old_dB - 0.5, "quarter table SFDR %.1f dB, previous %.1f dB", new_dB, old_dB);
+#ifdef SINE_INTERPOLATE
+	CHECK(new_dB > 110, "interpolated SFDR %.1f dB", new_dB);
+#endif
+
+	return TEST_report("test_sine");
+}
@@ -0,0 +1,137 @@
+/***************************************************************
+	Filename:	test_spill.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Long capture through SDRAM (ADC_spillMode). The ADC
+		words stream in while the main loop drains the SDRAM ring
+		to USB. The host must get every word in order, none of the
+		uninitialised SDRAM, and the capture must end by itself.
+		With USB stalled the ring fills: the dropped blocks are
+		counted and show as a sequence gap.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	(40*ADC_SPILL_BLOCK + 300)			// Partial last block
+#define TEST_STALLED	((ADC_SPILL_BLOCKS+8)*ADC_SPILL_BLOCK + 300)	// Past the ring
+
+extern unsigned int ADC_spillSDRAM[ADC_SPILL_BLOCKS*ADC_SPILL_BLOCK];
+
+static unsigned int words[TEST_STALLED+1];
+static unsigned int received[TEST_STALLED+1];
+static unsigned int sequence[ADC_SPILL_BLOCKS+16];
+
+
+/************************************************************
+	Function:	static unsigned int collect (unsigned int * blocks)
+	Return:		Words received, in received[]
+	Description:	PC side: spill packets, sequence number then
+		words least significant byte first. Each word lands at
+		its place in the run, from the sequence number.
+************************************************************/
+static unsigned int collect(unsigned int * blocks)
+{
+	unsigned int n, offset = 0, size, count = 0, base;
+	const unsigned char * packet;
+
+	*blocks = 0;
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+		if(packet[0] != USB_MSG_SENDSPILLDATA || size < 5){
+			continue;
+		}
+		sequence[(*blocks)++] = DECODE_int(&packet[1]);
+		base = DECODE_int(&packet[1])*ADC_SPILL_BLOCK;
+		for(n = 5; n + 4 <= size && base <= TEST_STALLED; n += 4, base++, count++){
+			received[base] = packet[n] | packet[n+1]<<8 | packet[n+2]<<16 | (unsigned int)packet[n+3]<<24;
+		}
+	}
+	return count;
+}
+
+
+/************************************************************
+	Function:	static void start (unsigned int samples, unsigned int per_tick)
+	Description:	Long capture of samples+1 words, fed per_tick
+		words per tick of the model.
+************************************************************/
+static void start(unsigned int samples, unsigned int per_tick)
+{
+	unsigned char command[USB_MSG_SPILL_SIZE] = {USB_MSG_SPILL, 1};
+
+	TEST_command(command, sizeof(command));
+	HOST_sdram(ADC_spillSDRAM, ADC_SPILL_BLOCKS*ADC_SPILL_BLOCK);
+	memset(received, 0, sizeof(received));
+	ADC_StartSampling(samples, 10, FALSE);
+	CHECK(ADC_spillActive, "long capture not active");
+	HOST_adcStream(words, samples+1, per_tick);
+}
+
+
+int main(void)
+{
+	unsigned int n, count, blocks, sent = 0, stale = 0;
+	double deadline;
+
+	TEST_boot();
+	OpMode = MODE_IQ;
+	DSP_blockSize = 0;
+	for(n = 0; n <= TEST_STALLED; n++){
+		words[n] = TEST_ifWord(n, 0.0123, 0.8, 0.1, 0.05);
+	}
+
+	// Drained while sampling, as the main loop does
+	start(TEST_SAMPLES, 32);
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	deadline = TEST_seconds() + 30;
+	while(ADC_spillActive && TEST_seconds() < deadline){
+		sent += ADC_spillDrain() == TRUE;
+	}
+	HOST_usbDrainAll();
+	count = collect(&blocks);
+	for(n = 0; n < count; n++){
+		stale += received[n] == HOST_SDRAM_GARBAGE;
+	}
+	printf("long capture of %u words: %u blocks, %u words received, %u overruns\n",
+		TEST_SAMPLES+1, blocks, count, ADC_spillOverruns);
+	CHECK(!ADC_spillActive, "long capture still active after the drain");
+	CHECK(ADC_spillDrain() == FALSE, "block sent after the end of the capture");
+	CHECK(ADC_spillOverruns == 0, "%u overruns", ADC_spillOverruns);
+	CHECK(sent == blocks && blocks == TEST_SAMPLES/ADC_SPILL_BLOCK + 1, "%u blocks sent, %u received", sent, blocks);
+	for(n = 0; n < blocks; n++){
+		CHECK(sequence[n] == n, "block %u has sequence %u", n, sequence[n]);
+	}
+	CHECK(count == TEST_SAMPLES+1, "%u words received for a run of %u", count, TEST_SAMPLES+1);
+	CHECK(stale == 0, "%u words of uninitialised SDRAM sent", stale);
+	CHECK(memcmp(received, words, count*sizeof(unsigned int)) == 0, "words changed on the way");
+	CHECK(HOST_sdramWritten == TEST_SAMPLES+1, "%u words written to SDRAM", HOST_sdramWritten);
+	CHECK(HOST_sdramBadAccess == 0, "%u SDRAM accesses outside the ring", HOST_sdramBadAccess);
+
+	// USB stalled: the ring keeps ADC_SPILL_BLOCKS blocks, the rest are dropped
+	start(TEST_STALLED, 32);
+	deadline = TEST_seconds() + 60;
+	while(ADC_sampling && TEST_seconds() < deadline);
+	CHECK(ADC_sampling == FALSE, "stalled capture did not end");
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	while(ADC_spillActive && TEST_seconds() < deadline){
+		ADC_spillDrain();
+	}
+	HOST_usbDrainAll();
+	count = collect(&blocks);
+	printf("stalled long capture of %u words: %u blocks, %u words received, %u overruns\n",
+		TEST_STALLED+1, blocks, count, ADC_spillOverruns);
+	CHECK(!ADC_spillActive, "stalled capture still active after the drain");
+	CHECK(blocks == ADC_SPILL_BLOCKS && sequence[blocks-1] == ADC_SPILL_BLOCKS-1,
+		"%u blocks received, last sequence %u", blocks, sequence[blocks-1]);
+	CHECK(ADC_spillOverruns == TEST_STALLED/ADC_SPILL_BLOCK + 1 - ADC_SPILL_BLOCKS,
+		"%u overruns", ADC_spillOverruns);
+	CHECK(count == ADC_SPILL_BLOCKS*ADC_SPILL_BLOCK
+		&& memcmp(received, words, count*sizeof(unsigned int)) == 0, "stored blocks changed on the way");
+	CHECK(HOST_sdramBadAccess == 0, "%u SDRAM accesses outside the ring", HOST_sdramBadAccess);
+
+	return TEST_report("test_spill");
+}
@@ -0,0 +1,118 @@
+/***************************************************************
+	Filename:	test_timestamp.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Sample times rebuilt on the PC from the timestamp
+		packets (DECODE_times). A long capture with timestamps on
+		sends the run start and one stamp per SDRAM block: every
+		word must get a time, the block start at its stamp and the
+		others one sample period apart. Move timestamps must decode
+		to the values sent. On the host DSP_timestamp counts
+		nanoseconds, so only times within a block are compared to
+		the period.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	(12*ADC_SPILL_BLOCK + 500)
+
+static unsigned int words[TEST_SAMPLES+1];
+static unsigned long long times[TEST_SAMPLES+1];
+static DECODE_stamp stamps[64];
+
+
+/************************************************************
+	Function:	static unsigned int collectStamps (void)
+	Return:		Timestamps in the capture, in stamps[]
+************************************************************/
+static unsigned int collectStamps(void)
+{
+	unsigned int offset = 0, size, count = 0;
+	const unsigned char * packet;
+
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size) && count < 64){
+		count += DECODE_timestamp(packet, size, &stamps[count]);
+	}
+	return count;
+}
+
+
+int main(void)
+{
+	unsigned char spill[USB_MSG_SPILL_SIZE] = {USB_MSG_SPILL, 1};
+	unsigned char timestamps[USB_MSG_TIMESTAMPS_SIZE] = {USB_MSG_TIMESTAMPS, 1};
+	unsigned int n, k, count, blocks, bad = 0;
+	unsigned long long before, after;
+	double deadline;
+
+	TEST_boot();
+	OpMode = MODE_IQ;
+	DSP_blockSize = 0;
+	for(n = 0; n <= TEST_SAMPLES; n++){
+		words[n] = TEST_ifWord(n, 0.0123, 0.8, 0.1, 0.05);
+	}
+	TEST_command(spill, sizeof(spill));
+	TEST_command(timestamps, sizeof(timestamps));
+	CHECK(DSP_timestamps, "timestamps not enabled");
+
+	// Long capture drained as the main loop does, start stamp first
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	before = DSP_timestamp();
+	ADC_StartSampling(TEST_SAMPLES, 10, FALSE);
+	HOST_adcStream(words, TEST_SAMPLES+1, 32);
+	deadline = TEST_seconds() + 30;
+	while(ADC_spillActive && TEST_seconds() < deadline){
+		if(AR_timePending){
+			AR_timePending = FALSE;
+			process_sendTimestamp(TIMESTAMP_START, 0, AR_startTime);
+		}
+		ADC_spillDrain();
+	}
+	after = DSP_timestamp();
+	HOST_usbDrainAll();
+	CHECK(!ADC_spillActive, "long capture did not end");
+
+	blocks = collectStamps();
+	CHECK(blocks == TEST_SAMPLES/ADC_SPILL_BLOCK + 2, "%u timestamps", blocks);
+	CHECK(stamps[0].event == TIMESTAMP_START, "first timestamp is event %d", stamps[0].event);
+	for(k = 1; k < blocks; k++){
+		CHECK(stamps[k].event == TIMESTAMP_BLOCK && stamps[k].index == k-1,
+			"timestamp %u: event %d, index %u", k, stamps[k].event, stamps[k].index);
+		CHECK(stamps[k].time > stamps[k-1].time || k == 1, "block %u not after the previous one", k-1);
+		CHECK(stamps[k].period == ADC_fsDivider*CCLK_PER_PCG_TICK, "period %u", stamps[k].period);
+	}
+	CHECK(stamps[0].time >= before && stamps[blocks-1].time <= after, "timestamps outside the run");
+	// Run start and first block are stamped on the same sample
+	CHECK(stamps[1].time - stamps[0].time < 1000000, "start and block 0 %llu apart",
+		stamps[1].time - stamps[0].time);
+
+	count = DECODE_times(HOST_usbCapture, HOST_usbCaptured, USB_MSG_SENDSPILLDATA, 4, 4, 1,
+					times, TEST_SAMPLES+1);
+	printf("%u words timed from %u timestamps, period %u cycles (%.3f us)\n", count, blocks,
+		stamps[1].period, DECODE_seconds(stamps[1].period)*1e6);
+	CHECK(count == TEST_SAMPLES+1, "%u words timed for a run of %u", count, TEST_SAMPLES+1);
+	for(n = 0; n < count; n++){
+		k = n/ADC_SPILL_BLOCK;
+		bad += times[n] != stamps[k+1].time + (unsigned long long)(n%ADC_SPILL_BLOCK)*stamps[k+1].period;
+	}
+	CHECK(bad == 0, "%u words with the wrong time", bad);
+
+	// Move timestamps: event, steps and 64 bit time as sent
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	process_sendTimestamp(TIMESTAMP_MOVE_START, 1234, 0x123456789abcULL);
+	process_sendTimestamp(TIMESTAMP_MOVE_END, 1234, 0x123456789abcULL + 4000000);
+	HOST_usbDrainAll();
+	CHECK(collectStamps() == 2, "move timestamps missing");
+	CHECK(stamps[0].event == TIMESTAMP_MOVE_START && stamps[0].index == 1234
+		&& stamps[0].time == 0x123456789abcULL, "move start decoded wrong");
+	CHECK(stamps[1].event == TIMESTAMP_MOVE_END && stamps[1].time - stamps[0].time == 4000000,
+		"move end decoded wrong");
+	CHECK(DECODE_seconds(stamps[1].time - stamps[0].time) == 0.01, "4000000 cycles are not 10 ms");
+
+	return TEST_report("test_timestamp");
+}
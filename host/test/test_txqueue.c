@@ -0,0 +1,290 @@
+/***************************************************************
+	Filename:	test_txqueue.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	Transmit queue (USB_txQueue) under continuous
+		acquisition to a small FIFO the PC reads slowly. The main
+		loop ships the ring with ADC_RING_SENDS chunks queued at
+		once, between acknowledges and block data packets: in every
+		write mode the PC must read the packets in the order they
+		were sent, whole, with every sample either received in order
+		or counted as a ring overrun, and no packet dropped by the
+		queue. With the PC stalled the samples must wait in the ring,
+		and an acknowledge on a full queue must give up instead of
+		hanging the core.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_SAMPLES	(4*ADC_RING_SIZE + 37)
+#define TEST_FIFO		256			// Bytes, read at one byte per 5 accesses
+#define TEST_FAST		64			// Main loop passes per ADC sample, keeping up
+#define TEST_SLOW		8			// Falling behind the ADC
+#define TEST_ACK_EVERY	300			// Samples between acknowledges
+#define TEST_BLOCK_EVERY	1000	// Samples between block data packets
+#define TEST_BLOCK		100
+#define TEST_EVENTS		4096
+
+static int expected[TEST_EVENTS];				// Header of each packet sent
+static unsigned int expected_size[TEST_EVENTS];
+static unsigned int events;
+static unsigned int chunk_head[ADC_RING_SENDS+1];		// USB_txHead after each chunk queued
+static unsigned int chunks;
+static unsigned int overlap;							// Most chunks queued at once
+static float blockA[TEST_BLOCK];
+static float blockB[TEST_BLOCK];
+static float gotA[TEST_SAMPLES];
+static float gotB[TEST_SAMPLES];
+static const char * modes[] = {"single", "burst"};
+
+
+/************************************************************
+	Function:	static void record (int header, unsigned int size)
+	Description:	A packet the PC must read next.
+************************************************************/
+static void record(int header, unsigned int size)
+{
+	if(events < TEST_EVENTS){
+		expected[events] = header;
+		expected_size[events] = size;
+	}
+	events++;
+}
+
+
+/************************************************************
+	Function:	static void loop (unsigned int passes)
+	Description:	Main loop passes of a continuous point by point
+		acquisition, as the firmware main loop.
+************************************************************/
+static void loop(unsigned int passes)
+{
+	unsigned int level, k, queued;
+
+	while(passes--){
+		level = ADC_ringCount();
+		if(ADC_ringSend() == TRUE){
+			record(USB_MSG_SENDSAMPLEDATA, 1 + 8*(level - ADC_ringCount()));
+			chunk_head[chunks++%(ADC_RING_SENDS+1)] = USB_txHead;
+			for(k = 0, queued = 0; k <= ADC_RING_SENDS && k < chunks; k++){
+				queued += (int)(chunk_head[k] - USB_txTail) > 0;
+			}
+			if(queued > overlap) overlap = queued;
+		}
+		USB_txService();
+	}
+}
+
+
+/************************************************************
+	Function:	static void acknowledge (unsigned int n)
+	Description:	Queues an acknowledge with a header of its own.
+************************************************************/
+static void acknowledge(unsigned int n)
+{
+	int header = 0x40 + n%0x40;
+
+	CHECK(process_sendAcknowledge(header) == TRUE, "acknowledge %u not sent", n);
+	record(header, 1);
+}
+
+
+/************************************************************
+	Function:	static unsigned int check (const char * name, unsigned int produced)
+	Return:		Samples received
+	Description:	Walks what the PC read against the packets
+		sent. Sample k of the run has the values k and -k.
+************************************************************/
+static unsigned int check(const char * name, unsigned int produced)
+{
+	unsigned int offset = 0, size, n = 0, k, got, received = 0, next = 0, missing = 0;
+	unsigned int wrong = 0, torn = 0, backwards = 0, sequence = 0, bad_block = 0;
+	const unsigned char * packet;
+
+	HOST_usbDrainAll();
+	while(DECODE_next(HOST_usbCapture, HOST_usbCaptured, &offset, &packet, &size)){
+		if(n >= events || n >= TEST_EVENTS || packet[0] != expected[n] || size != expected_size[n]){
+			wrong++;
+		}else if(packet[0] == USB_MSG_SENDSAMPLEDATA){
+			got = DECODE_samples(&packet[1], size-1, ENCODE_FLOAT32, gotA, gotB, TEST_SAMPLES);
+			for(k = 0; k < got; k++){
+				if(gotB[k] != -gotA[k]){
+					torn++;
+				}
+				if(gotA[k] < next){
+					backwards++;
+				}else{
+					missing += (unsigned int)gotA[k] - next;
+					next = (unsigned int)gotA[k] + 1;
+				}
+			}
+			received += got;
+		}else if(packet[0] == USB_MSG_SENDBLOCKDATA){
+			got = DECODE_samples(&packet[5], size-5, ENCODE_FLOAT32, gotA, gotB, TEST_SAMPLES);
+			bad_block += DECODE_int(&packet[1]) != sequence++ || got != TEST_BLOCK
+				|| memcmp(gotA, blockA, sizeof(blockA)) != 0 || memcmp(gotB, blockB, sizeof(blockB)) != 0;
+		}
+		n++;
+	}
+	missing += produced - next;
+
+	printf("%-16s %5u samples received, %4u overruns, %3u packets, %u chunks queued at once\n",
+		name, received, ADC_ringOverruns, n, overlap);
+	CHECK(offset == HOST_usbCaptured, "%s: %u of %u bytes read as packets", name, offset, HOST_usbCaptured);
+	CHECK(n == events && wrong == 0, "%s: %u packets read, %u sent, %u not as sent", name, n, events, wrong);
+	CHECK(torn == 0 && backwards == 0, "%s: %u samples torn, %u out of order", name, torn, backwards);
+	CHECK(bad_block == 0, "%s: %u block packets changed", name, bad_block);
+	CHECK(missing == ADC_ringOverruns, "%s: %u samples missing, %u overruns", name, missing,
+		ADC_ringOverruns);
+	CHECK(HOST_usbLost == 0 && HOST_usbBadAccess == 0, "%s: %u bytes lost, %u bad accesses", name,
+		HOST_usbLost, HOST_usbBadAccess);
+	return received;
+}
+
+
+/************************************************************
+	Function:	static void start (int mode)
+	Description:	Empty queue, ring and FIFO before a run.
+************************************************************/
+static void start(int mode)
+{
+	USB_writeMode = mode;
+	USB_txFlush();
+	HOST_usbReset(TEST_FIFO, 1, 5);
+	ADC_ringReset();
+	events = 0;
+	chunks = 0;
+	overlap = 0;
+	ADC_sampling = TRUE;
+}
+
+
+/************************************************************
+	Function:	static void stream (int mode, unsigned int passes)
+	Argument:	passes - Main loop passes per ADC sample
+	Description:	TEST_SAMPLES through the ring with acknowledges
+		and block data in between, then what is left once
+		sampling stops.
+************************************************************/
+static void stream(int mode, unsigned int passes)
+{
+	char name[32];
+	unsigned int n, dropped = USB_txDropped, received;
+
+	start(mode);
+	for(n = 0; n < TEST_SAMPLES; n++){
+		ADC_ringPut((float)n, -(float)n);
+		loop(passes);
+		if(n%TEST_ACK_EVERY == TEST_ACK_EVERY-1){
+			acknowledge(n);
+		}
+		if(n%TEST_BLOCK_EVERY == TEST_BLOCK_EVERY-1){
+			CHECK(process_sendBlockData(n/TEST_BLOCK_EVERY, TEST_BLOCK, blockA, blockB) == TRUE,
+				"block %u not sent", n/TEST_BLOCK_EVERY);
+			record(USB_MSG_SENDBLOCKDATA, 1 + 4 + 8*TEST_BLOCK);
+		}
+	}
+	ADC_sampling = FALSE;
+	while(ADC_ringCount() > 0){
+		loop(1);
+	}
+	CHECK(USB_txFlush() == TRUE, "%s: queue not flushed", modes[mode]);
+
+	sprintf(name, "%s, %s", modes[mode], passes == TEST_FAST ? "keeping up" : "behind");
+	received = check(name, TEST_SAMPLES);
+	CHECK(USB_txDropped == dropped, "%s: %u packets dropped by the queue", name, USB_txDropped - dropped);
+	CHECK(overlap <= ADC_RING_SENDS, "%s: %u chunks queued at once", name, overlap);
+	if(passes == TEST_FAST){
+		CHECK(received == TEST_SAMPLES, "%s: %u samples received", name, received);
+	}else{
+		// Behind, the next chunks are queued while the first goes out
+		CHECK(ADC_ringOverruns > 0 && overlap >= 2, "%s: %u overruns, up to %u chunks queued",
+			name, ADC_ringOverruns, overlap);
+	}
+}
+
+
+/************************************************************
+	Function:	static void stall (int mode)
+	Description:	The PC stops reading. The ring fills behind
+		ADC_RING_SENDS queued chunks, an acknowledge that finds the
+		queue full gives up, and once the PC reads again everything
+		queued and left in the ring arrives in order.
+************************************************************/
+static void stall(int mode)
+{
+	unsigned int n, queued, dropped = USB_txDropped;
+	double seconds;
+
+	start(mode);
+	HOST_usbRate(0, 1);
+	for(n = 0; n < 2*ADC_RING_SIZE; n++){
+		ADC_ringPut((float)n, -(float)n);
+		loop(2);
+	}
+	queued = USB_txHead - USB_txTail;
+	CHECK(queued == ADC_RING_SENDS && overlap == ADC_RING_SENDS, "%s: %u chunks queued", modes[mode], queued);
+	CHECK(ADC_ringCount() == ADC_RING_SIZE && ADC_ringOverruns > 0, "%s: ring at %u, %u overruns",
+		modes[mode], ADC_ringCount(), ADC_ringOverruns);
+
+	for(n = queued; n < USB_TX_DEPTH; n++){
+		acknowledge(n);
+	}
+	seconds = TEST_seconds();
+	n = process_sendAcknowledge(0x7f);
+	seconds = TEST_seconds() - seconds;
+	printf("%-16s acknowledge on a full queue: %s after %.3f ms\n", modes[mode],
+		n == USB_ERROR_FLAG ? "error" : "sent", 1e3*seconds);
+	CHECK(n == USB_ERROR_FLAG && USB_txHead - USB_txTail == USB_TX_DEPTH,
+		"%s: acknowledge on a full queue returned %d", modes[mode], n);
+
+	HOST_usbRate(1, 5);
+	ADC_sampling = FALSE;
+	while(ADC_ringCount() > 0){
+		loop(1);
+	}
+	CHECK(USB_txFlush() == TRUE, "%s: queue not flushed", modes[mode]);
+	check(modes[mode], 2*ADC_RING_SIZE);
+	CHECK(USB_txDropped == dropped, "%s: %u packets dropped by the queue", modes[mode],
+		USB_txDropped - dropped);
+}
+
+
+int main(void)
+{
+	unsigned char command[USB_MSG_TXQUEUE_SIZE] = {USB_MSG_TXQUEUE, 1};
+	unsigned int k;
+	int mode;
+
+	TEST_boot();
+	for(k = 0; k < TEST_BLOCK; k++){
+		blockA[k] = 0.5 + k;
+		blockB[k] = -0.25 - k;
+	}
+
+	// Its own ID, not one of the messages to the host
+	HOST_usbReset(HOST_USB_TX_SIZE, 1, 1);
+	CHECK(TEST_command(command, sizeof(command)) == TRUE && USB_txEnabled, "queue not turned on");
+	CHECK(USB_txFlush() == TRUE, "acknowledge not sent");
+	HOST_usbDrainAll();
+	CHECK(HOST_usbCaptured == 6 && HOST_usbCapture[5] == USB_MSG_TXQUEUE, "acknowledge of %u bytes, header %d",
+		HOST_usbCaptured, HOST_usbCapture[5]);
+
+	for(mode = USB_WRITE_SINGLE; mode <= USB_WRITE_BURST; mode++){
+		stream(mode, TEST_FAST);
+		stream(mode, TEST_SLOW);
+		stall(mode);
+	}
+
+	command[1] = 0;
+	TEST_command(command, sizeof(command));
+	ADC_ringReset();
+	USB_writeMode = USB_WRITE_SINGLE;
+
+	return TEST_report("test_txqueue");
+}
@@ -0,0 +1,90 @@
+/***************************************************************
+	Filename:	test_usbwrite.c
+	Date:		October 2026
+	Version:	v1.0
+
+	Purpose:	FIFO write modes (USB_writeMode) on the FT2232H
+		model. Every mode must put the same bytes on the wire, all
+		on D0-7, with the PC keeping up and with a small FIFO the PC
+		reads slowly, where a burst written after one status poll
+		would lose bytes. Prints the throughput of each mode: bus
+		accesses and chip selects per byte, and the host rate.
+
+***************************************************************/
+
+#include <string.h>
+#include "hostTest.h"
+#include "hostDecode.h"
+#include "h/general.h"
+
+#define TEST_WORDS		16384		// 64 KB of sample words
+#define TEST_HEADER		11			// Odd, as packet headers can be
+
+static unsigned int words[TEST_WORDS];
+static unsigned char header[TEST_HEADER];
+static unsigned char expected[TEST_HEADER + 4*TEST_WORDS];
+static const char * names[] = {"single", "burst"};
+
+
+/************************************************************
+	Function:	static void send (int mode, unsigned int tx_size,
+					unsigned int num, unsigned int den)
+	Description:	A header and the sample words, as a data packet
+		goes out, in the given mode. Checks what the PC read.
+************************************************************/
+static void send(int mode, unsigned int tx_size, unsigned int num, unsigned int den)
+{
+	unsigned int bytes = sizeof(expected);
+	double seconds;
+	int status;
+
+	USB_writeMode = mode;
+	HOST_usbReset(tx_size, num, den);
+	seconds = TEST_seconds();
+	status = USB_writeBuffer(TEST_HEADER, header);
+	if(USB_sendADCData(TEST_WORDS, words) == USB_ERROR_FLAG){
+		status = USB_ERROR_FLAG;
+	}
+	seconds = TEST_seconds() - seconds;
+	HOST_usbDrainAll();
+
+	printf("%-6s FIFO %4u, PC %u/%u: %.2f accesses/byte, %.3f selects/byte, %.2f MB/s on the host\n",
+		names[mode], tx_size, num, den, (double)HOST_usbAccesses/bytes, (double)HOST_usbSelects/bytes,
+		bytes/seconds/1e6);
+	CHECK(status == TRUE, "%s: send failed", names[mode]);
+	CHECK(HOST_usbLost == 0, "%s: %u bytes lost", names[mode], HOST_usbLost);
+	CHECK(HOST_usbChannelB == 0, "%s: %u accesses with data on D8-15", names[mode], HOST_usbChannelB);
+	CHECK(HOST_usbBadAccess == 0, "%s: %u bad accesses", names[mode], HOST_usbBadAccess);
+	CHECK(HOST_usbCaptured == bytes && memcmp(HOST_usbCapture, expected, bytes) == 0,
+		"%s: %u bytes read by the PC, %u sent", names[mode], HOST_usbCaptured, bytes);
+}
+
+
+int main(void)
+{
+	unsigned int n;
+	int mode;
+
+	TEST_boot();
+	for(n = 0; n < TEST_HEADER; n++){
+		header[n] = expected[n] = 0xa0 + n;
+	}
+	for(n = 0; n < TEST_WORDS; n++){
+		words[n] = n*2654435761u;
+		expected[TEST_HEADER+4*n] = words[n]&0xff;
+		expected[TEST_HEADER+4*n+1] = (words[n]>>8)&0xff;
+		expected[TEST_HEADER+4*n+2] = (words[n]>>16)&0xff;
+		expected[TEST_HEADER+4*n+3] = words[n]>>24;
+	}
+
+	// PC keeping up, then a 256 byte FIFO read at one byte per 5 accesses
+	for(mode = USB_WRITE_SINGLE; mode <= USB_WRITE_BURST; mode++){
+		send(mode, HOST_USB_TX_SIZE, 1, 1);
+	}
+	for(mode = USB_WRITE_SINGLE; mode <= USB_WRITE_BURST; mode++){
+		send(mode, 256, 1, 5);
+	}
+	USB_writeMode = USB_WRITE_SINGLE;
+
+	return TEST_report("test_usbwrite");
+}
@@ -57,13 +57,89 @@ union Samples {
 	unsigned char Char[MAXSAMPLES*4];
 } SAMPLES_MEMORY;
 */
-unsigned int * SAMPLES_MEMORY;
-
 unsigned int sample_buffer_1[MAXSAMPLES];
 unsigned int sample_buffer_2[MAXSAMPLES];
 
+// Raw samples ring used in block processing mode
+unsigned int * SAMPLES_MEMORY = sample_buffer_1;
+
+// Sample rate of the current acquisition, ADC_FS/ADC_rateFactor
+unsigned int ADC_rateFactor = 1;
+unsigned int ADC_fsDivider = ADC_FS_DIVIDER;
+
+// DMA receive mode, requested by USB and active for block mode runs
+bool ADC_dmaMode = FALSE;
+bool ADC_dmaActive = FALSE;
+
+// Oversampling factor requested by USB and the one of the current run.
+// Oversampled runs receive into two staging blocks instead of the ring.
+unsigned int ADC_oversampling = 1;
+unsigned int ADC_osr = 1;
+unsigned int ADC_osrShift;
+unsigned int ADC_osrHalf;
+unsigned int ADC_osrBuffer[2][ADC_DMA_BLOCK];
+
+// Raw ring format of the current run, see ADC_RAW_VOLTS_B. Oversampled runs
+// are never continuous, so channel A takes the second ping-pong buffer.
+unsigned int ADC_rawShift = 16;
+int ADC_rawZeroA = CAL_CHA_DECIMAL;
+int ADC_rawZeroB = CAL_CHB_DECIMAL;
+float ADC_rawScale = 2.5/65536;
+unsigned int * ADC_osrRingA = sample_buffer_2;
+
+// TCB chain around the raw samples ring, same layout as initSPORT.c:
+// { next TCB | PCI, count, modifier, index }
+int ADC_DMA_TCB[ADC_DMA_TCBS][4];
+
+// Continuous acquisition ring. The ADC interrupt is the only producer and
+// the main loop the only consumer. Each side writes only its own free
+// running index, so neither has to wait for or lock out the other.
+float ADC_ringA[ADC_RING_SIZE];
+float ADC_ringB[ADC_RING_SIZE];
+volatile unsigned int ADC_ringHead;		// Outputs written
+volatile unsigned int ADC_ringTail;		// Outputs read
+unsigned int ADC_ringOverruns;			// Outputs dropped on a full ring
+unsigned int ADC_ringHighWater;			// Highest ring level reached
+// Chunks on their way to the USB. A queued packet points at its buffer
+// until USB_txTail passes the USB_txHead value recorded after queuing it.
+float ADC_ringSendA[ADC_RING_SENDS][ADC_RING_CHUNK];
+float ADC_ringSendB[ADC_RING_SENDS][ADC_RING_CHUNK];
+unsigned int ADC_ringSendTail[ADC_RING_SENDS];
+unsigned int ADC_ringSendNext = 0;
+volatile bool ADC_sampling = FALSE;		// CNV generation running
+
+// Long capture through SDRAM. The ADC interrupt fills one staging block
+// while the external port DMA writes the other to the SDRAM ring; the
+// main loop sends the written blocks to USB. Block counters run free:
+// queued (DMA started) >= head (DMA done) >= tail (sent). The 2 MB ring
+// is not cleared at boot: only blocks the DMA has written are sent.
+#pragma section("seg_sdram", NO_INIT)
+unsigned int ADC_spillSDRAM[ADC_SPILL_BLOCKS*ADC_SPILL_BLOCK];
+unsigned int ADC_spillStage[2][ADC_SPILL_BLOCK];
+unsigned int ADC_spillWords[ADC_SPILL_BLOCKS];		// Words in each SDRAM block
+unsigned int ADC_spillSequence[ADC_SPILL_BLOCKS];	// Sequence number of each SDRAM block
+unsigned long long ADC_spillTime[ADC_SPILL_BLOCKS];	// Timestamp of each SDRAM block
+unsigned long long ADC_spillStageTime;
+unsigned int ADC_spillStageIndex;
+unsigned int ADC_spillWordIndex;
+unsigned int ADC_spillBlocks;					// Blocks filled, dropped ones included
+unsigned int ADC_spillQueued;
+volatile unsigned int ADC_spillHead;
+unsigned int ADC_spillTail;
+unsigned int ADC_spillOverruns;					// Blocks dropped
+bool ADC_spillMode = FALSE;
+bool ADC_spillActive = FALSE;
+
 unsigned int samples_memory_index;	// Current index in the samples memory
 
+// Continuous block mode: sequence numbers of the ping-pong buffers and
+// buffers lost because the main loop still had the other one
+unsigned int adc_sample_buffer_sequence;
+unsigned int ADC_bufferSequence;
+unsigned int ADC_buffersDropped;
+unsigned long long adc_sample_buffer_time;
+unsigned long long ADC_bufferTime;
+
 unsigned int adc_number_of_samples;	// Total number of samples in acquisition run
 
 
@@ -261,6 +337,8 @@ void InitADC_IO(void){
 	Argument:	sample_period - in microseconds, minimum is 6
 		for no sample loss
 	Description:	Configures SPORT3 to be used for ADC
+		The CNV period is ADC_fsDivider, set from sample_period
+		by ADC_setSamplePeriod.
 	Action:	Configures the SPORT3 as standard serial and
 		Receive Master with DMA.
 		#!			
@@ -304,8 +382,14 @@ void ADC_init(unsigned int sample_period)
     *pDAI_IRPTL_RE |= SRU_EXTMISCB0_INT;
 */    
     // Interrupt Dispatchers
-   	interrupts(SIG_P0,IRQ_ADC_SampleReady);
-    interruptf(SIG_SP3,IRQ_ADC_SampleDone);
+    if(ADC_dmaActive){
+    	// No per sample interrupts, SPORT3 is framed by PCG C
+    	interrupts(SIG_P0,SIG_IGN);
+    	ADC_initDMA();
+    }else{
+	   	interrupts(SIG_P0,IRQ_ADC_SampleReady);
+	    interruptf(SIG_SP3,IRQ_ADC_SampleDone);
+    }
 
 	DDS_init();
 	DDS_init();
@@ -314,7 +398,8 @@ void ADC_init(unsigned int sample_period)
 	DDS_WriteData(DDS3_frequency, DDS3_phase, 0, DDS_ch3);
 		
 	// updates the internal DDS lut increment for the specified frequency
-	iDDS_lut_inc = (DDS_inc_Fex - DDS_inc_Flo)*1200;
+	// at the running sample rate
+	iDDS_lut_inc = (DDS_inc_Fex - DDS_inc_Flo)*1200*ADC_rateFactor;
 	// Resets the internal DDS lut accumulator
 	iDDS_lut_acc = 0;
 	
@@ -331,7 +416,13 @@ void ADC_init(unsigned int sample_period)
 //	*pPCG_PW2 = ((sample_period*PCG_TICKS_PER_uSEC)-1)<<16;
 	
 	DDS_update_frequency();	
-	*pPCG_CTLD0 =  250 | ENFSD | ENCLKD ;
+	if(ADC_dmaActive){
+		// PCG C frame sync, same period as CNV and ADC_DMA_FS_DELAY later.
+		// Enabled just before PCG D so both count from the same tick.
+		*pPCG_CTLC1 = PCG_CLKD_DIVIDER | ((ADC_DMA_FS_DELAY & 0x3ff)<<20);
+		*pPCG_CTLC0 = (ADC_fsDivider/ADC_osr) | (((ADC_DMA_FS_DELAY>>10) & 0x3ff)<<20) | ENFSC | ENCLKC;
+	}
+	*pPCG_CTLD0 =  (ADC_fsDivider/ADC_osr) | ENFSD | ENCLKD ;
 //	*pPCG_CTLD0 =  (1*PCG_TICKS_PER_uSEC) | ENFSD | ENCLKD ;
 
 //printf("ticks: %d\n",sample_period*	PCG_TICKS_PER_uSEC);		
@@ -381,6 +472,11 @@ void ADC_StopSampling(void)
 //			
 //		}else{
 			*pPCG_CTLD0 = 0;
+			ADC_sampling = FALSE;
+			if(ADC_dmaActive){
+				*pPCG_CTLC0 = 0;
+				*pSPCTL3 = 0;
+			}
 			//#! *pTM0STAT = TIM0DIS;
 //			adc_end_of_sampling = 1;
 //		}
@@ -396,14 +492,30 @@ void ADC_StopSampling(void)
 	Argument:		
 	Description:	Is triggered when a SAMPLES_MEMORY buffer
 		is full and swaps it to the next one.
-#!		Also signals a adc_samples_buffer_full to possibly send to USB
-		
-	Action:	
+		Also signals a adc_samples_buffer_full to possibly send to USB
 		
+	Action:	In continuous block mode the full buffer is handed to
+		the main loop (adc_sample_buffer_full_ptr) and sampling goes
+		on in the other one. If the main loop has not released the
+		other buffer yet, the full buffer is dropped and refilled.
+		Every buffer gets a sequence number, dropped ones included,
+		so the host sees the gap.
 		
 ************************************************************/
 void ADC_SwapBuffer(void)
 {
+	if(adc_sample_buffer_full){
+		ADC_buffersDropped++;
+	}else{
+		adc_sample_buffer_full_ptr = SAMPLES_MEMORY;
+		adc_sample_buffer_full_number_of_samples = samples_memory_index;
+		adc_sample_buffer_sequence = ADC_bufferSequence;
+		adc_sample_buffer_time = ADC_bufferTime;
+		adc_sample_buffer_full = 1;
+		SAMPLES_MEMORY = (SAMPLES_MEMORY == sample_buffer_1) ? sample_buffer_2 : sample_buffer_1;
+	}
+	ADC_bufferSequence++;
+	samples_memory_index = 0;
 
 /*	
 	AR_bufferIndex=0;
@@ -461,6 +573,31 @@ void ADC_FinishedAR(void)
 }
 
 
+/************************************************************
+	Function:		ADC_setSamplePeriod(unsigned int sample_period)
+	Argument:		sample_period - in microseconds
+	Description:	Sets the CNV period of the next acquisition.
+	Action:	The period is rounded down to a whole multiple of the
+		ADC_FS period (10 us), from ADC_FS down to
+		ADC_FS/ADC_RATE_MAX, and the low pass for that rate is
+		loaded. The LO increments are scaled by ADC_init and
+		Init_Bank. A period of 0 keeps ADC_FS.
+		
+************************************************************/
+void ADC_setSamplePeriod(unsigned int sample_period)
+{
+	unsigned int rate_factor;
+	
+	rate_factor = (sample_period*PCG_TICKS_PER_uSEC)/ADC_FS_DIVIDER;
+	if(rate_factor < 1) rate_factor = 1;
+	if(rate_factor > ADC_RATE_MAX) rate_factor = ADC_RATE_MAX;
+	
+	ADC_rateFactor = rate_factor;
+	ADC_fsDivider = rate_factor*ADC_FS_DIVIDER;
+	Init_FIR_LPrate(rate_factor);
+}
+
+
 /************************************************************
 	Function:		ADC_StartSampling(int number_samples, int sample_period, char continuous_sampling)
 	Argument:		number_samples
@@ -477,17 +614,120 @@ void ADC_FinishedAR(void)
 ************************************************************/
 void ADC_StartSampling(unsigned int number_samples, unsigned int sample_period, char continuous_sampling)
 {
+	unsigned int osr;
+	
+	// Queued packets may still point at the sample buffers
+	USB_txFlush();
+	
 	AR_bufferIndex=0;
 	AR_totalSamples = number_samples;
 	
+	// Sample rate first, the filters below are built for it
+	ADC_setSamplePeriod(sample_period);
+	
 	if(OpMode == MODE_IF){
 		//Init_FIR_BPsoft();
 		Init_IIR_BPsoft();
+		Init_FIR_pair();
+		Init_FIR_LPdecimator(DSP_decimationRequest);
 //		AR_totalSamples +=50;
+	}else if(OpMode == MODE_DFT){
+		Init_DFT();
 	}
 	
 	AR_continuousSampling = continuous_sampling;
 	
+	// Long capture streams the raw words of point by point runs through SDRAM
+	ADC_spillActive = (ADC_spillMode && DSP_blockSize == 0) ? TRUE : FALSE;
+	if(ADC_spillActive){
+		ADC_spillReset();
+	}
+	
+	// Packed raw capture replaces the interrupt conversion of finite runs.
+	// The buffers hold twice as many packed words as converted samples.
+	AR_rawCapture = (DSP_blockSize == 0 && !continuous_sampling && !ADC_spillActive) ? AR_rawCaptureMode : RAW_CAPTURE_OFF;
+	if(AR_rawCapture == RAW_CAPTURE_HOST && number_samples > RAW_CAPTURE_MAX-1){
+		number_samples = RAW_CAPTURE_MAX-1;
+	}else if(AR_rawCapture == RAW_CAPTURE_VOLTS && number_samples > MAX_SAMPLES_BUFFER_SIZE-1){
+		number_samples = MAX_SAMPLES_BUFFER_SIZE-1;
+	}
+	AR_totalSamples = number_samples;
+	AR_rawCapturePtr = (unsigned int*)AR_bufferChA;
+	
+	// DMA reception only feeds the finite block processing mode
+	ADC_dmaActive = (ADC_dmaMode && DSP_blockSize && !continuous_sampling) ? TRUE : FALSE;
+	
+	// Oversampling needs DMA reception, and the CNV period can not go
+	// below ADC_FS_DIVIDER_MIN
+	osr = ADC_dmaActive ? ADC_oversampling : 1;
+	while(osr > 1 && ADC_fsDivider/osr < ADC_FS_DIVIDER_MIN){
+		osr >>= 1;
+	}
+	ADC_osrSet(osr);
+	
+	if(AR_continuousSampling){
+		ADC_ringReset();
+	}
+	
+	// Continuous block mode starts on the first ping-pong buffer
+	SAMPLES_MEMORY = sample_buffer_1;
+	samples_memory_index = 0;
+	adc_sample_buffer_full = 0;
+	ADC_bufferSequence = 0;
+	ADC_buffersDropped = 0;
+	
+	// The first sample of the run is timestamped by the ADC interrupt
+	AR_timePending = FALSE;
+	AR_timeArmed = DSP_timestamps;
+	ADC_sampling = TRUE;
+	
+	// Profiler deadlines: one CNV period per sample interrupt,
+	// one DMA block per block interrupt
+	DSP_profileRestart(PROF_ADC_SAMPLE, ADC_fsDivider*CCLK_PER_PCG_TICK);
+	DSP_profileRestart(PROF_ADC_BLOCK, ADC_DMA_BLOCK*(ADC_fsDivider/ADC_osr)*CCLK_PER_PCG_TICK);
+	
+	// The demodulation bank runs in block mode only. Each output sample
+	// holds BANK_lanes values, so fewer samples fit in the buffers.
+	BANK_lanes = BANK_lanesRequest;
+	BANK_active = (DSP_blockSize && OpMode == MODE_IF && BANK_lanes > 0
+					&& !continuous_sampling) ? TRUE : FALSE;
+	
+	// The FIR accelerator filters finite IF block runs only
+	DSP_firOffloadActive = (DSP_firOffload && DSP_blockSize && OpMode == MODE_IF
+					&& !BANK_active && !continuous_sampling) ? TRUE : FALSE;
+	if(BANK_active){
+		if(number_samples > MAX_SAMPLES_BUFFER_SIZE/BANK_lanes - 1){
+			number_samples = MAX_SAMPLES_BUFFER_SIZE/BANK_lanes - 1;
+		}
+		AR_totalSamples = number_samples;
+		Init_Bank();
+	}
+	
+	// Block processing mode stores (number_samples+1) output samples
+	// worth of raw words, as the interrupt mode does. The outputs go
+	// to the sample buffers, so a run holds at most MAX_SAMPLES_BUFFER_SIZE.
+	if(DSP_blockSize){
+		if(number_samples > MAX_SAMPLES_BUFFER_SIZE-1){
+			number_samples = MAX_SAMPLES_BUFFER_SIZE-1;
+			AR_totalSamples = number_samples;
+		}
+		AR_rawIndex = 0;
+		AR_rawFinished = FALSE;
+		AR_rawTotal = number_samples+1;
+		if(OpMode == MODE_IF){
+			AR_rawTotal *= DSP_decimation;
+		}else if(OpMode == MODE_DFT){
+			AR_rawTotal *= DFT_outputRate;
+		}
+		Init_DemodulateBlock();
+		if(OpMode == MODE_IF){
+			Init_OLS();
+		}
+		if(DSP_firOffloadActive){
+			Init_FIR_offload();
+		}
+	}
+	
 //	Init_IIR_soft();
 	
 //	printf("StartSampling!\n");
@@ -565,16 +805,453 @@ void IRQ_ADC_SampleReady(int sig_int)
 
 
 
+/**********************************************************
+	Function:		ADC_initDMA()
+	Argument:	
+	Description:	Configures SPORT3 for chained DMA reception
+		into the raw samples ring (SAMPLES_MEMORY).
+	Action:	Builds a closed chain of ADC_DMA_TCBS TCBs, each one
+		filling the next ADC_DMA_BLOCK samples of the ring and
+		raising the SPORT3 interrupt when done, as the rotating
+		blocks of initSPORT.c. SPORT3 is a receive master with
+		external frame sync from PCG C, so every CNV period one
+		32 bit word is received without core intervention.
+		When oversampling, a chain of two TCBs alternates between
+		the ADC_osrBuffer blocks instead.
+		
+************************************************************/
+void ADC_initDMA(void)
+{
+	int k, tcbs;
+	
+	*pSPCTL3 = 0;
+	
+	tcbs = (ADC_osr > 1) ? 2 : ADC_DMA_TCBS;
+	for(k = 0; k < tcbs; k++){
+		ADC_DMA_TCB[k][0] = (int) ADC_DMA_TCB[(k+1)%tcbs] + 3 - ADC_DMA_OFFSET + ADC_DMA_PCI;
+		ADC_DMA_TCB[k][1] = ADC_DMA_BLOCK;
+		ADC_DMA_TCB[k][2] = 1;
+		if(ADC_osr > 1){
+			ADC_DMA_TCB[k][3] = (unsigned int) ADC_osrBuffer[k] - ADC_DMA_OFFSET;
+		}else{
+			ADC_DMA_TCB[k][3] = (unsigned int) &SAMPLES_MEMORY[k*ADC_DMA_BLOCK] - ADC_DMA_OFFSET;
+		}
+	}
+	ADC_osrHalf = 0;
+	
+	*pDIV3 = ADC_SPORT_CLK_DIV;
+	SRU(PCG_FSC_O, SPORT3_FS_I);
+	interrupt(SIG_SP3,IRQ_ADC_BlockDone);
+	
+	// Receive master, external frame sync, DMA chaining
+	*pSPCTL3 = (FSR | ICLK | SLEN32 | SPEN_A | SCHEN_A | SDEN_A);
+	// The first block fills the start of the ring
+	*pCPSP3A = (unsigned int) ADC_DMA_TCB[0] - ADC_DMA_OFFSET + 3;
+}
+
+
+/************************************************************
+	Function:		IRQ_ADC_BlockDone(int sig_int)
+	Argument:		sig_int
+	Description:	End of a DMA block in DMA receive mode.
+	Action:	Publishes the block to DSP_ProcessBlocks by advancing
+		AR_rawIndex. Once AR_rawTotal samples have been received
+		the sampling stops; the rest of the last block is
+		discarded. When oversampling, the block is first averaged
+		into the ring by ADC_oversampleBlock.
+			
+************************************************************/
+void IRQ_ADC_BlockDone(int sig_int)
+{
+	PROF_ENTER(PROF_ADC_BLOCK);
+	
+	// No per sample interrupt: the first sample is ADC_DMA_BLOCK-1 CNV periods back
+	if(AR_timeArmed){
+		AR_startTime = DSP_timestamp() - (ADC_DMA_BLOCK-1)*(ADC_fsDivider/ADC_osr)*CCLK_PER_PCG_TICK;
+		AR_timeArmed = FALSE;
+		AR_timePending = TRUE;
+	}
+	if(ADC_osr > 1){
+		AR_rawIndex += ADC_oversampleBlock(ADC_osrBuffer[ADC_osrHalf]);
+		ADC_osrHalf ^= 1;
+	}else{
+		AR_rawIndex += ADC_DMA_BLOCK;
+	}
+	
+	if(AR_rawIndex >= AR_rawTotal){
+		ADC_StopSampling();
+		AR_rawIndex = AR_rawTotal;
+		AR_rawFinished = TRUE;
+	}else if(AR_rawIndex + 2*ADC_DMA_BLOCK - DSP_blockIndex > MAXSAMPLES){
+		// The block being received is the last one free in the ring
+		ADC_rawOverrun();
+	}
+	PROF_EXIT(PROF_ADC_BLOCK);
+}
+
+
+/************************************************************
+	Function:		ADC_rawOverrun()
+	Argument:	
+	Description:	The block processing has fallen a ring behind
+		the ADC: the next samples would overwrite raw words that
+		DSP_ProcessBlocks has not read yet.
+	Action:	Ends the run on the samples already in the ring, so
+		the outputs stay contiguous and the host gets a shorter
+		run. Counted in AR_rawOverruns.
+			
+************************************************************/
+void ADC_rawOverrun(void)
+{
+	ADC_StopSampling();
+	AR_rawTotal = AR_rawIndex;
+	AR_rawFinished = TRUE;
+	AR_rawOverruns++;
+}
+
+
+/************************************************************
+	Function:		ADC_osrSet(unsigned int osr)
+	Argument:		osr - Oversampling factor of the run, a power
+					of two up to ADC_OSR_MAX
+	Description:	Sets the factor and the raw ring format that
+		goes with it.
+	Action:	ADC_oversampleBlock keeps the whole sum of osr samples,
+		log2(osr) bits more than a sample, and ADC_RAW_VOLTS_B
+		scales it back to volts in float.
+			
+************************************************************/
+void ADC_osrSet(unsigned int osr)
+{
+	ADC_osr = osr;
+	for(ADC_osrShift = 0; (1<<ADC_osrShift) < osr; ADC_osrShift++);
+	ADC_rawShift = 16 - ADC_osrShift;
+	ADC_rawZeroA = CAL_CHA_DECIMAL*osr;
+	ADC_rawZeroB = CAL_CHB_DECIMAL*osr;
+	ADC_rawScale = 2.5/65536/osr;
+}
+
+
+/************************************************************
+	Function:		ADC_oversampleBlock(unsigned int * raw_buffer)
+	Argument:		raw_buffer - ADC_DMA_BLOCK words received at
+					ADC_osr times the output rate
+	Return:			Number of words written to the ring
+	Description:	Boxcar decimation of an oversampled DMA block.
+		Every ADC_osr words of each channel are summed into one
+		output at AR_rawIndex: channel B in the raw samples ring,
+		channel A in ADC_osrRingA.
+	Action:	The averaging is the first stage of a CIC decimator.
+		It removes the noise above the output Nyquist rate before
+		decimating, which is the noise that would otherwise fold
+		into the demodulation band. The sum is not rounded back to
+		16 bits: shifted up by ADC_rawShift it fills the word, its
+		high 16 bits are the mean and the low bits the resolution
+		gained.
+			
+************************************************************/
+unsigned int ADC_oversampleBlock(unsigned int * raw_buffer)
+{
+	unsigned int n, k, sumA, sumB, sample, index;
+	unsigned int outputs = ADC_DMA_BLOCK>>ADC_osrShift;
+	
+	for(n = 0; n < outputs; n++){
+		sumA = 0;
+		sumB = 0;
+		for(k = 0; k < ADC_osr; k++){
+			sample = *raw_buffer++;
+			sumA += sample&0xffff;
+			sumB += (sample>>16)&0xffff;
+		}
+		index = (AR_rawIndex+n)&(MAXSAMPLES-1);
+		SAMPLES_MEMORY[index] = sumB<<ADC_rawShift;
+		ADC_osrRingA[index] = sumA<<ADC_rawShift;
+	}
+	
+	return outputs;
+}
+
+
+/************************************************************
+	Function:		ADC_ringReset()
+	Argument:	
+	Description:	Empties the continuous acquisition ring,
+		clears its counters and frees the send buffers. Called
+		before sampling starts, with the transmit queue flushed.
+			
+************************************************************/
+void ADC_ringReset(void)
+{
+	int k;
+	
+	ADC_ringHead = 0;
+	ADC_ringTail = 0;
+	ADC_ringOverruns = 0;
+	ADC_ringHighWater = 0;
+	for(k = 0; k < ADC_RING_SENDS; k++){
+		ADC_ringSendTail[k] = USB_txTail;
+	}
+}
+
+
+/************************************************************
+	Function:		ADC_ringPut(float sampleA, float sampleB)
+	Argument:		sampleA, sampleB - Output sample of each channel
+	Return:			TRUE if stored, FALSE if the ring was full
+	Description:	Producer side of the continuous acquisition
+		ring, called from the ADC interrupt.
+	Action:	A full ring drops the sample and counts an overrun.
+		The data is written before the head index so the main
+		loop never reads an incomplete sample.
+			
+************************************************************/
+int ADC_ringPut(float sampleA, float sampleB)
+{
+	unsigned int head = ADC_ringHead;
+	unsigned int level = head - ADC_ringTail;
+	
+	if(level >= ADC_RING_SIZE){
+		ADC_ringOverruns++;
+		return FALSE;
+	}
+	
+	ADC_ringA[head&(ADC_RING_SIZE-1)] = sampleA;
+	ADC_ringB[head&(ADC_RING_SIZE-1)] = sampleB;
+	ADC_RING_FENCE();
+	ADC_ringHead = head + 1;
+	
+	if(level + 1 > ADC_ringHighWater){
+		ADC_ringHighWater = level + 1;
+	}
+	
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:		ADC_ringCount()
+	Argument:	
+	Return:			Number of samples waiting in the ring
+			
+************************************************************/
+unsigned int ADC_ringCount(void)
+{
+	return ADC_ringHead - ADC_ringTail;
+}
+
+
+/************************************************************
+	Function:		ADC_ringGet(float * bufferA, float * bufferB, unsigned int max_samples)
+	Argument:		bufferA, bufferB - Destination of each channel
+					max_samples - Maximum number of samples to read
+	Return:			Number of samples read
+	Description:	Consumer side of the continuous acquisition
+		ring, called from the main loop.
+	Action:	The tail index is only advanced after the samples
+		have been copied out.
+			
+************************************************************/
+unsigned int ADC_ringGet(float * bufferA, float * bufferB, unsigned int max_samples)
+{
+	unsigned int k;
+	unsigned int tail = ADC_ringTail;
+	unsigned int count = ADC_ringHead - tail;
+	
+	if(count > max_samples){
+		count = max_samples;
+	}
+	ADC_RING_FENCE();
+	for(k = 0; k < count; k++){
+		bufferA[k] = ADC_ringA[(tail+k)&(ADC_RING_SIZE-1)];
+		bufferB[k] = ADC_ringB[(tail+k)&(ADC_RING_SIZE-1)];
+	}
+	ADC_RING_FENCE();
+	ADC_ringTail = tail + count;
+	
+	return count;
+}
+
+
+/************************************************************
+	Function:		ADC_ringSend()
+	Argument:	
+	Return:			TRUE if a chunk was sent or queued, FALSE if
+		there was nothing to send or no room for it.
+		USB_ERROR_FLAG if there was an error
+	Description:	Ships the ring to the USB from the main loop,
+		ADC_RING_CHUNK samples while sampling goes on and what is
+		left once it stops.
+	Action:	Each chunk is copied to the next of ADC_RING_SENDS
+		buffers, so it can be queued while the previous ones are
+		still being sent. If that buffer is still queued, or the
+		transmit queue is full, the samples wait in the ring.
+			
+************************************************************/
+int ADC_ringSend(void)
+{
+	unsigned int count = ADC_ringCount();
+	unsigned int k = ADC_ringSendNext;
+	int result;
+	
+	if(count == 0 || (count < ADC_RING_CHUNK && ADC_sampling)){
+		return FALSE;
+	}
+	if((int)(ADC_ringSendTail[k] - USB_txTail) > 0
+		|| (USB_txEnabled && USB_txHead - USB_txTail >= USB_TX_DEPTH)){
+		return FALSE;
+	}
+	
+	count = ADC_ringGet(ADC_ringSendA[k], ADC_ringSendB[k], ADC_RING_CHUNK);
+	result = process_sendSampleData(count, ADC_ringSendA[k], ADC_ringSendB[k]);
+	ADC_ringSendTail[k] = USB_txHead;
+	ADC_ringSendNext = (k + 1)%ADC_RING_SENDS;
+	
+	return result;
+}
+
+
+/************************************************************
+	Function:		ADC_spillReset()
+	Argument:	
+	Description:	Empties the SDRAM ring and the staging blocks,
+		clears the counters and hooks the external port DMA
+		interrupt. Called before a long capture starts.
+			
+************************************************************/
+void ADC_spillReset(void)
+{
+	*pDMAC0 = DFLSH;
+	ADC_spillStageIndex = 0;
+	ADC_spillWordIndex = 0;
+	ADC_spillBlocks = 0;
+	ADC_spillQueued = 0;
+	ADC_spillHead = 0;
+	ADC_spillTail = 0;
+	ADC_spillOverruns = 0;
+	
+	interrupt(SIG_EP0I, IRQ_ADC_SpillDone);
+}
+
+
+/************************************************************
+	Function:		ADC_spillBlock()
+	Argument:	
+	Description:	Spills the current staging block to the SDRAM
+		ring through external port DMA channel 0 and switches
+		the ADC interrupt to the other staging block.
+	Action:	If the previous transfer has not finished, or the
+		SDRAM ring is full because USB fell behind, the block is
+		dropped and counted in ADC_spillOverruns. Its sequence
+		number is skipped, so the host sees the gap.
+			
+************************************************************/
+void ADC_spillBlock(void)
+{
+	unsigned int block = ADC_spillQueued;
+	unsigned int slot = block&(ADC_SPILL_BLOCKS-1);
+	
+	if(block != ADC_spillHead || block - ADC_spillTail >= ADC_SPILL_BLOCKS){
+		ADC_spillOverruns++;
+	}else{
+		ADC_spillWords[slot] = ADC_spillWordIndex;
+		ADC_spillSequence[slot] = ADC_spillBlocks;
+		ADC_spillTime[slot] = ADC_spillStageTime;
+		
+		*pDMAC0 = DFLSH;
+		*pIIEP0 = (unsigned int) ADC_spillStage[ADC_spillStageIndex];
+		*pIMEP0 = 1;
+		*pICEP0 = ADC_spillWordIndex;
+		*pEIEP0 = (unsigned int) &ADC_spillSDRAM[slot*ADC_SPILL_BLOCK];
+		*pEMEP0 = 1;
+		*pECEP0 = ADC_spillWordIndex;
+		ADC_spillQueued = block + 1;
+		*pDMAC0 = DMAEN | TRAN;		// Internal to external
+		
+		ADC_spillStageIndex ^= 1;
+	}
+	ADC_spillBlocks++;
+	ADC_spillWordIndex = 0;
+}
+
+
+/************************************************************
+	Function:		IRQ_ADC_SpillDone(int sig_int)
+	Argument:		sig_int
+	Description:	End of an external port DMA transfer to SDRAM.
+	Action:	Publishes the block to ADC_spillDrain.
+			
+************************************************************/
+void IRQ_ADC_SpillDone(int sig_int)
+{
+	ADC_spillHead = ADC_spillQueued;
+}
+
+
+/************************************************************
+	Function:		ADC_spillDrain()
+	Argument:	
+	Return:			TRUE if a block was sent
+	Description:	Consumer side of the long capture, called from
+		the main loop. Sends the oldest SDRAM block to USB while
+		acquisition goes on.
+	Action:	Once sampling stops, the partial staging block is
+		spilled as well, after the last transfer has finished.
+		When the last block has been sent the long capture ends
+		and ADC_spillActive is cleared.
+			
+************************************************************/
+int ADC_spillDrain(void)
+{
+	unsigned int slot;
+	
+	if(ADC_sampling == FALSE && ADC_spillWordIndex > 0 && ADC_spillQueued == ADC_spillHead){
+		ADC_spillBlock();
+	}
+	if(ADC_spillHead == ADC_spillTail){
+		if(ADC_sampling == FALSE && ADC_spillWordIndex == 0 && ADC_spillQueued == ADC_spillHead){
+			ADC_spillActive = FALSE;
+		}
+		return FALSE;
+	}
+	
+	slot = ADC_spillTail&(ADC_SPILL_BLOCKS-1);
+	if(DSP_timestamps){
+		process_sendTimestamp(TIMESTAMP_BLOCK, ADC_spillSequence[slot], ADC_spillTime[slot]);
+	}
+	process_sendSpillData(ADC_spillSequence[slot], ADC_spillWords[slot],
+						&ADC_spillSDRAM[slot*ADC_SPILL_BLOCK]);
+	ADC_spillTail++;
+	
+	return TRUE;
+}
+
+
 /************************************************************
 	Function:		IRQ_ADC_SampleDone(int sig_int)
 	Argument:		sig_int
 	Description:	End of SPORT sample reception.
+	Action:	Runs ADC_SampleDone between the profiler stamps.
+			
+************************************************************/
+void IRQ_ADC_SampleDone(int sig_int)
+{
+	PROF_ENTER(PROF_ADC_SAMPLE);
+	
+	ADC_SampleDone();
+	PROF_EXIT(PROF_ADC_SAMPLE);
+}
+
+
+/************************************************************
+	Function:		ADC_SampleDone(void)
+	Argument:		
+	Description:	Body of IRQ_ADC_SampleDone.
 	Action:	After receiving a full sample, this interrupt
 		should stop the SPORT interface and save the sample
 		in memory.
 			
 ************************************************************/
-void IRQ_ADC_SampleDone(int sig_int)
+void ADC_SampleDone(void)
 {
 	//*pSPCTL4 = 0;
 	unsigned int k,i,sample;
@@ -590,7 +1267,75 @@ void IRQ_ADC_SampleDone(int sig_int)
 	// Disables the SPORT interface.
 	*pSPCTL3 = 0;
 
+	// Timestamp of the first sample of the run, sent by the main loop
+	if(AR_timeArmed){
+		AR_startTime = DSP_timestamp();
+		AR_timeArmed = FALSE;
+		AR_timePending = TRUE;
+	}
+
+	// Continuous block mode: raw words fill the ping-pong buffers,
+	// DSP_ProcessFullBuffer demodulates each full one from the main loop.
+	if(DSP_blockSize && AR_continuousSampling){
+		if(samples_memory_index == 0 && DSP_timestamps){
+			ADC_bufferTime = DSP_timestamp();
+		}
+		SAMPLES_MEMORY[samples_memory_index++] = sample;
+		if(samples_memory_index == ADC_PINGPONG_SIZE){
+			ADC_SwapBuffer();
+		}
+		return;
+	}
+	
+	// Block processing mode: only the raw word is stored, DSP_ProcessBlocks
+	// demodulates it later from the main loop.
+	if(DSP_blockSize){
+		if(AR_rawIndex < AR_rawTotal){
+			// The ring is full of words not demodulated yet
+			if(AR_rawIndex - DSP_blockIndex >= MAXSAMPLES){
+				ADC_rawOverrun();
+				return;
+			}
+			SAMPLES_MEMORY[AR_rawIndex&(MAXSAMPLES-1)] = sample;
+			AR_rawIndex++;
+			if(AR_rawIndex == AR_rawTotal){
+				ADC_StopSampling();
+				AR_rawFinished = TRUE;
+			}
+		}
+		return;
+	}
 
+	// Long capture: the raw word goes to the staging block, which is spilled
+	// to SDRAM when full. Finite runs keep the usual number_samples+1 samples.
+	if(ADC_spillActive){
+		if(ADC_spillWordIndex == 0 && DSP_timestamps){
+			ADC_spillStageTime = DSP_timestamp();
+		}
+		ADC_spillStage[ADC_spillStageIndex][ADC_spillWordIndex++] = sample;
+		if(ADC_spillWordIndex == ADC_SPILL_BLOCK){
+			ADC_spillBlock();
+		}
+		// ADC_spillDrain spills the last, partial block
+		if(AR_continuousSampling == FALSE && AR_bufferIndex++ == AR_totalSamples){
+			ADC_StopSampling();
+		}
+		return;
+	}
+	
+	// Packed raw capture: a single store, converted after the run or by the host
+	if(AR_rawCapture){
+		*AR_rawCapturePtr++ = sample;
+		if(AR_bufferIndex == AR_totalSamples){
+			ADC_FinishedAR();
+		}else{
+			AR_bufferIndex++;
+			if(AR_bufferIndex == MAX_SAMPLES_BUFFER_SIZE){
+				AR_rawCapturePtr = (unsigned int*)AR_bufferChB;
+			}
+		}
+		return;
+	}
 	
 	// Saves to current Acquisition Run samples buffer memory
 //	AR_buffer[AR_bufferIndex%MAX_SAMPLES_BUFFER_SIZE] = sample;
@@ -605,8 +1350,16 @@ void IRQ_ADC_SampleDone(int sig_int)
 	// In IF Mode only Channel A is needed.
 	// In IQ Mode both ADC channels are used.
 	if(OpMode == MODE_IF){
-		signal_QuadratureDemodulation_InternalLO_PtbyPt(AR_bufferChA,AR_bufferChB,AR_bufferIndex);
+		// When decimating, only every DSP_decimation samples is there a new output
+		if(signal_QuadratureDemodulation_InternalLO_PtbyPt(AR_bufferChA,AR_bufferChB,AR_bufferIndex) == FALSE){
+			return;
+		}
 //		signalIIR_bandpassfilter(&AR_bufferChA[AR_bufferIndex%(MAX_SAMPLES_BUFFER_SIZE)],&AR_bufferChB[AR_bufferIndex%MAX_SAMPLES_BUFFER_SIZE]);
+	}else if(OpMode == MODE_DFT){
+		// Single bin sliding DFT, one output every DFT_outputRate samples
+		if(signal_QuadratureDemodulation_DFT_PtbyPt(AR_bufferChA,AR_bufferChB,AR_bufferIndex) == FALSE){
+			return;
+		}
 	}else{
 		AR_bufferChB[AR_bufferIndex%(MAX_SAMPLES_BUFFER_SIZE)] = (((int)sample&0xffff)-CAL_CHA_DECIMAL)*2.5/65536;// - CAL_chA_calibration;
 		
@@ -616,6 +1369,14 @@ void IRQ_ADC_SampleDone(int sig_int)
 
 	
 	
+	// Continuous acquisition hands every output to the main loop
+	// through the ring and runs until stopped.
+	if(AR_continuousSampling){
+		ADC_ringPut(AR_bufferChA[AR_bufferIndex%MAX_SAMPLES_BUFFER_SIZE],
+					AR_bufferChB[AR_bufferIndex%MAX_SAMPLES_BUFFER_SIZE]);
+		return;
+	}
+	
 	// If the expected number of samples has been reached.
 	if(AR_bufferIndex==AR_totalSamples){
 	//	ADC_StopSampling();
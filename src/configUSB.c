@@ -26,6 +26,23 @@
 			LOCAL USB GLOBAL VARIABLES
 ***************************************************************/
 
+int USB_writeMode = USB_WRITE_SINGLE;
+
+// Transmit queue: packet descriptors drained by USB_txService. The
+// header is copied, the data segments are sent from where they are.
+bool USB_txEnabled = FALSE;
+unsigned char USB_txHeader[USB_TX_DEPTH][USB_TX_HEADER];
+int USB_txHeaderSize[USB_TX_DEPTH];
+unsigned int * USB_txData[USB_TX_DEPTH][2];
+unsigned int USB_txWords[USB_TX_DEPTH][2];
+unsigned int USB_txHead = 0;				// Packets queued
+unsigned int USB_txTail = 0;				// Packets sent
+int USB_txSegment = -1;					// Of the oldest packet, -1 is the header
+unsigned int USB_txIndex = 0;				// Next byte of the segment
+unsigned int USB_txBytes = 0;				// Bytes written, to see progress
+unsigned int USB_txHighWater = 0;
+unsigned int USB_txDropped = 0;			// Droppable packets refused on a full queue
+unsigned int USB_txSent = 0;
 
 
 #define NOP asm("nop;")
@@ -97,7 +114,7 @@ int usb_access(bool op,int val)
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 	//	val = decode16(val);
-		*USBADDR = val;
+		USB_PORT_WRITE(val);
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 		
@@ -127,7 +144,7 @@ int usb_access(bool op,int val)
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 
-		data = *USBADDR;
+		data = USB_PORT_READ();
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 		NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 
@@ -183,7 +200,7 @@ void USB_init(void)
 	
 	*pSYSCTL |= MSEN;
 	*pEPCTL &= ~B2SD;
-	*pAMICTL2 = AMIEN | BW16 | WS20 |PREDIS | IC5 | RHC5 | HC5 | PKDIS | AMIFLSH;
+	*pAMICTL2 = USB_AMICTL2;
 	// Bus width = 16
 	// HC5 Bus Hold Cycle
 	// IC5 Bus Idle Cycle
@@ -230,9 +247,9 @@ int USB_access(char access, char readwrite, char data)
 	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
 	
 	if( readwrite == USB_READ) {
-		byte = *USBADDR;
+		byte = USB_PORT_READ();
 	} else {
-		*USBADDR = data;	
+		USB_PORT_WRITE(data);	
 		
 	}	
 	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
@@ -488,21 +505,47 @@ int USB_readPayload(unsigned short usb_size, unsigned char * payload_buffer)
 int USB_sendADCData(int buffer_size, unsigned int * buffer)
 {
 	int temp, index;	
-	int k;
+	int k, run;
+	unsigned int word;
 	
-	 //printf("send adc data! %d\n",buffer);
-	//k = adc_number_of_samples*4;
-	for (index = 0; index< buffer_size ; index++){
-		for(k = 0; k < 4; k++){
+	// Queued packets go first
+	if(USB_txHead != USB_txTail){
+		USB_txFlush();
+	}
+	
+	if(USB_writeMode == USB_WRITE_SINGLE){
+		 //printf("send adc data! %d\n",buffer);
+		//k = adc_number_of_samples*4;
+		for (index = 0; index< buffer_size ; index++){
+			for(k = 0; k < 4; k++){
+		
+				// Poll for space available
+				if( USB_pollSpaceAvailable() == FALSE ){
+					return USB_ERROR_FLAG;
+				}
+				//printf("buffer: %d\n",(buffer[index]>>(k*8))&0xff);
+				USB_access(USB_DATA_PIPE, USB_WRITE, (buffer[index]>>(k*8))&0xff);
+			}
+		}	
+		return TRUE;
+	}
 	
-			// Poll for space available
-			if( USB_pollSpaceAvailable() == FALSE ){
+	// Burst: chip select held for a run, a status read before each byte.
+	// Same byte order on the wire in every mode, least significant first.
+	for (index = 0; index < buffer_size; index += run){
+		run = buffer_size - index;
+		if(run > USB_BURST_BYTES/4) run = USB_BURST_BYTES/4;
+		
+		USB_burstStart();
+		for(k = 0; k < 4*run; k++){
+			word = buffer[index+(k>>2)]>>(8*(k&3));
+			if(USB_burstWrite(word&0xff) == USB_ERROR_FLAG){
+				USB_burstEnd();
 				return USB_ERROR_FLAG;
 			}
-			//printf("buffer: %d\n",(buffer[index]>>(k*8))&0xff);
-			USB_access(USB_DATA_PIPE, USB_WRITE, (buffer[index]>>(k*8))&0xff);
 		}
-	}	
+		USB_burstEnd();
+	}
 
 	return TRUE;
 }
@@ -521,7 +564,30 @@ int USB_sendADCData(int buffer_size, unsigned int * buffer)
 int USB_writeBuffer(int buffer_size, unsigned char * buffer)
 {
 	int temp, index;	
-	int k;
+	int k, run;
+	
+	// Queued packets go first
+	if(USB_txHead != USB_txTail){
+		USB_txFlush();
+	}
+	
+	// Burst modes: chip select held for a run, a status read before each byte
+	if(USB_writeMode != USB_WRITE_SINGLE){
+		for (index = 0; index < buffer_size; index += run){
+			run = buffer_size - index;
+			if(run > USB_BURST_BYTES) run = USB_BURST_BYTES;
+			
+			USB_burstStart();
+			for(k = 0; k < run; k++){
+				if(USB_burstWrite(buffer[index+k]&0xff) == USB_ERROR_FLAG){
+					USB_burstEnd();
+					return USB_ERROR_FLAG;
+				}
+			}
+			USB_burstEnd();
+		}
+		return TRUE;
+	}
 	
 	 //printf("send adc data! %d\n",buffer);
 	//k = adc_number_of_samples*4;
@@ -539,6 +605,254 @@ int USB_writeBuffer(int buffer_size, unsigned char * buffer)
 
 
 
+/************************************************************
+	Function:	void USB_burstStart (void)
+	Argument:	
+	Return:		
+	Description:	Selects the data pipe for a run of writes
+		to USBADDR. The AMI wait and hold cycles set in USB_init
+		time each access, so the writes go back to back.
+	Action:		
+	
+************************************************************/
+void USB_burstStart(void)
+{
+	A0_LOW();
+	CSUSB_LOW(); // CS_FTDI
+	
+	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
+	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
+}
+
+
+/************************************************************
+	Function:	int USB_burstStatus (void)
+	Argument:	
+	Return:		The FIFO status register
+	Description:	Status read inside a run started by
+		USB_burstStart: A0 goes high for the read only.
+	Action:		
+	
+************************************************************/
+int USB_burstStatus(void)
+{
+	int status;
+	
+	A0_HIGH();
+	status = USB_PORT_READ();
+	A0_LOW();
+	
+	return status;
+}
+
+
+/************************************************************
+	Function:	int USB_burstWrite (int value)
+	Argument:	int value - Byte to send
+	Return:		TRUE if the byte was written.
+				USB_ERROR_FLAG on timeout
+	Description:	Writes one byte inside a run started by
+		USB_burstStart, once a status read shows space. A status
+		read only guarantees room for one byte.
+	Action:		Gives up after USB_READ_TIMEOUT reads, as
+		USB_pollSpaceAvailable does.
+	
+************************************************************/
+int USB_burstWrite(int value)
+{
+	int temp = USB_READ_TIMEOUT;
+	
+	while(!(USB_burstStatus() & USB_SPACE_AVAILABLE)){
+		temp--;
+		if(temp == 0){
+			return USB_ERROR_FLAG;
+		}
+	}
+	USB_PORT_WRITE(value);
+	
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:	void USB_burstEnd (void)
+	Argument:	
+	Return:		
+	Description:	Ends a run of writes started by
+		USB_burstStart.
+	Action:		
+	
+************************************************************/
+void USB_burstEnd(void)
+{
+	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
+	NOP;NOP;NOP;NOP;NOP;NOP;NOP;NOP;
+	
+	//Deasserts the Chip Select
+	CSUSB_HIGH(); // CS_FTDI
+	A0_LOW();	// A0
+}
+
+
+/************************************************************
+	Function:	int USB_txQueue (int header_size, unsigned char * header,
+					unsigned int words_a, unsigned int * buffer_a,
+					unsigned int words_b, unsigned int * buffer_b, bool droppable)
+	Argument:	int header_size - Header bytes, up to USB_TX_HEADER
+				unsigned char * header - Header, copied
+				unsigned int words_a, words_b - Words of each data segment
+				unsigned int * buffer_a, * buffer_b - Data segments, not copied
+				bool droppable - TRUE to drop the packet on a full queue
+	Return:		TRUE if queued.
+				USB_ERROR_FLAG if dropped, or on timeout
+	Description:	Queues a packet for USB_txService and returns.
+		The data buffers must not change until the packet is out,
+		that is until USB_txTail passes the USB_txHead value seen
+		on return; USB_txFlush waits for all of them.
+	Action:		A packet that is not droppable, as an acknowledge,
+		flushes a full queue instead, and is not queued if the
+		PC stops reading (USB_txFlush times out).
+	
+************************************************************/
+int USB_txQueue(int header_size, unsigned char * header, unsigned int words_a, unsigned int * buffer_a,
+				unsigned int words_b, unsigned int * buffer_b, bool droppable)
+{
+	unsigned int slot;
+	int k;
+	
+	if(USB_txHead - USB_txTail >= USB_TX_DEPTH){
+		if(droppable){
+			USB_txDropped++;
+			return USB_ERROR_FLAG;
+		}
+		if(USB_txFlush() == USB_ERROR_FLAG){
+			return USB_ERROR_FLAG;
+		}
+	}
+	
+	slot = USB_txHead&(USB_TX_DEPTH-1);
+	if(header_size > USB_TX_HEADER) header_size = USB_TX_HEADER;
+	for(k = 0; k < header_size; k++){
+		USB_txHeader[slot][k] = header[k];
+	}
+	USB_txHeaderSize[slot] = header_size;
+	USB_txData[slot][0] = buffer_a;
+	USB_txWords[slot][0] = words_a;
+	USB_txData[slot][1] = buffer_b;
+	USB_txWords[slot][1] = words_b;
+	USB_txHead++;
+	
+	if(USB_txHead - USB_txTail > USB_txHighWater){
+		USB_txHighWater = USB_txHead - USB_txTail;
+	}
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:	int USB_txNextByte (void)
+	Argument:	
+	Return:		Next byte of the oldest queued packet
+	Description:	Walks the header, then the data segments,
+		words least significant byte first as USB_sendADCData.
+	Action:		Retires the packet after its last byte. Only
+		called with a packet queued.
+	
+************************************************************/
+int USB_txNextByte(void)
+{
+	unsigned int slot = USB_txTail&(USB_TX_DEPTH-1);
+	int byte;
+	
+	if(USB_txSegment < 0){
+		byte = USB_txHeader[slot][USB_txIndex++];
+		if(USB_txIndex < USB_txHeaderSize[slot]){
+			return byte;
+		}
+	}else{
+		byte = (USB_txData[slot][USB_txSegment][USB_txIndex>>2]>>(8*(USB_txIndex&3)))&0xff;
+		USB_txIndex++;
+		if(USB_txIndex < 4*USB_txWords[slot][USB_txSegment]){
+			return byte;
+		}
+	}
+	
+	// Next non empty segment, or the next packet
+	USB_txIndex = 0;
+	do{
+		USB_txSegment++;
+	}while(USB_txSegment < 2 && USB_txWords[slot][USB_txSegment] == 0);
+	if(USB_txSegment == 2){
+		USB_txSegment = -1;
+		USB_txTail++;
+		USB_txSent++;
+	}
+	return byte;
+}
+
 
+/************************************************************
+	Function:	void USB_txService (void)
+	Argument:	
+	Return:		
+	Description:	Background side of the transmit queue, called
+		from the main loop. Writes while the FIFO has space, at
+		most USB_TX_POLLS status polls, and never waits.
+	Action:		A status read before every byte. Runs of one
+		byte in USB_WRITE_SINGLE mode, USB_BURST_BYTES in the
+		burst modes; stops at the first read without space. The
+		bytes on the wire are the same in every mode: one byte per
+		write on D0-7, in USB_txNextByte order.
+	
+************************************************************/
+void USB_txService(void)
+{
+	int polls, run;
+	
+	for(polls = 0; polls < USB_TX_POLLS && USB_txHead != USB_txTail; polls++){
+		run = (USB_writeMode == USB_WRITE_SINGLE) ? 1 : USB_BURST_BYTES;
+		
+		USB_burstStart();
+		while(run > 0 && USB_txHead != USB_txTail && (USB_burstStatus() & USB_SPACE_AVAILABLE)){
+			USB_PORT_WRITE(USB_txNextByte());
+			USB_txBytes++;
+			run--;
+		}
+		USB_burstEnd();
+		if(run > 0 && USB_txHead != USB_txTail){
+			return;
+		}
+	}
+}
 
 
+/************************************************************
+	Function:	int USB_txFlush (void)
+	Argument:	
+	Return:		TRUE when the queue is empty.
+				USB_ERROR_FLAG on timeout
+	Description:	Waits for every queued packet to be sent.
+	Action:		Gives up after USB_READ_TIMEOUT services in a row
+		without progress, as USB_pollSpaceAvailable does. The
+		packets stay queued.
+	
+************************************************************/
+int USB_txFlush(void)
+{
+	int temp = USB_READ_TIMEOUT;
+	unsigned int bytes;
+	
+	while(USB_txHead != USB_txTail){
+		bytes = USB_txBytes;
+		USB_txService();
+		if(USB_txBytes == bytes){
+			temp--;
+			if(temp == 0){
+				return USB_ERROR_FLAG;
+			}
+		}else{
+			temp = USB_READ_TIMEOUT;
+		}
+	}
+	return TRUE;
+}
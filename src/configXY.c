@@ -27,6 +27,14 @@
 ***************************************************************/
 
 int xy_allow_step;
+unsigned long long XY_moveStartTime;
+unsigned long long XY_moveEndTime;
+
+bool XY_triggerMode = FALSE;
+unsigned int XY_triggerSettle = 0;		// Settle delay after each step, in us
+unsigned int XY_triggerSamples = 0;		// Samples per capture
+unsigned int XY_triggerPeriod = 0;		// Sample period of the captures, in us
+unsigned int XY_triggerStep = 0;		// Index of the next step, from the trigger command
 
 
 /************************************************************
@@ -136,6 +144,7 @@ void IRQ_stepperTimer(int sigint)
 {
 	int i;
 	static int onoff=0;
+	PROF_ENTER(PROF_STEPPER);
 	// Clears Timer interrupt
 	*pTMSTAT &= TIM0IRQ;
 
@@ -148,7 +157,7 @@ void IRQ_stepperTimer(int sigint)
 	}
 */
 	xy_allow_step =TRUE;
-
+	PROF_EXIT(PROF_STEPPER);
 }
 
 /************************************************************
@@ -170,7 +179,7 @@ void XY_timer_init (char move_xy)
     *pTM0PRD = move_xy ? MOVE_Y_DELAY : MOVE_X_DELAY;
     *pTM0W = *pTM0PRD/2;//(CNV_uSEC * TICKS_PER_uSEC-3); // 10% pulse
 	*pTM0STAT = TIM0EN;
-
+	DSP_profileRestart(PROF_STEPPER, *pTM0PRD*CCLK_PER_TIMER_TICK);
 	
     //*pDAI_IRPTL_PRI |= SRU_EXTMISCB0_INT;
     //*pDAI_IRPTL_RE |= SRU_EXTMISCB0_INT;
@@ -205,6 +214,62 @@ void XY_timer_set (char move_xy)
 
 
 
+/************************************************************
+	Function:		XY_triggeredCapture 
+	Argument:	
+				
+	Description:
+			Position locked measurement of the step just made.
+	Action:		
+			Waits XY_triggerSettle us for the probe to settle,
+			runs a finite capture of XY_triggerSamples samples and
+			sends its last sample, tagged with the step index. In
+			block mode the blocks are processed here, since the
+			main loop is held by the move. Raw capture and SDRAM
+			spill are not used for triggered captures.
+				
+************************************************************/
+void XY_triggeredCapture(void)
+{
+	unsigned int start, lanes;
+	char raw_mode;
+	bool spill_mode;
+	
+	start = DSP_cycles();
+	while(DSP_cycles() - start < XY_triggerSettle*CCLK_PER_uSEC);
+	
+	raw_mode = AR_rawCaptureMode;
+	spill_mode = ADC_spillMode;
+	AR_rawCaptureMode = RAW_CAPTURE_OFF;
+	ADC_spillMode = FALSE;
+	
+	AR_finishedFlag = FALSE;
+	ADC_StartSampling(XY_triggerSamples, XY_triggerPeriod, FALSE);
+	while(AR_finishedFlag == FALSE){
+		if(DSP_blockSize){
+			DSP_ProcessBlocks();
+		}
+	}
+	AR_finishedFlag = FALSE;
+	
+	AR_rawCaptureMode = raw_mode;
+	ADC_spillMode = spill_mode;
+	
+	if(AR_timePending){
+		AR_timePending = FALSE;
+		process_sendTimestamp(TIMESTAMP_START, XY_triggerStep, AR_startTime);
+	}
+	if(BANK_active){
+		// A run ended before its first output has no lanes to send
+		lanes = (AR_bufferIndex+1 >= BANK_lanes) ? BANK_lanes : 0;
+		process_sendStepData(XY_triggerStep, lanes,
+			&AR_bufferChA[AR_bufferIndex+1-lanes], &AR_bufferChB[AR_bufferIndex+1-lanes]);
+	}else{
+		process_sendStepData(XY_triggerStep, 1, &AR_bufferChA[AR_bufferIndex], &AR_bufferChB[AR_bufferIndex]);
+	}
+	XY_triggerStep++;
+}
+
 /************************************************************
 	Function:		X_move 
 	Argument:	int steps;
@@ -221,17 +286,22 @@ void X_move(int steps)
 	int i,k;
 //	X_ENABLE;
 	XY_timer_set(MOVE_X);
+	XY_moveStartTime = DSP_timestamp();
 	for(k=steps; k>0; k--){
 		X_STEP_HIGH;
 		for(i=0;i<MOVE_XY_CLK_DELAY;i++);
 		X_STEP_LOW;
 		xy_allow_step=FALSE;
+		if(XY_triggerMode){
+			XY_triggeredCapture();
+		}
 		asm("nop;");
 		while(xy_allow_step==FALSE);
 		xy_allow_step=FALSE;
 
 		//for(i=0;i<MOVE_X_DELAY;i++);
 	}
+	XY_moveEndTime = DSP_timestamp();
 //	X_DISABLE;
 	
 	
@@ -253,18 +323,23 @@ void Y_move(int steps)
 	int i,k;
 //	Y_ENABLE;
 	XY_timer_set(MOVE_Y);
+	XY_moveStartTime = DSP_timestamp();
 	
 	for(k=steps; k>0; k--){
 		
 		Y_STEP_HIGH;
 		for(i=0;i<MOVE_XY_CLK_DELAY;i++);
 		Y_STEP_LOW;
-		//for(i=0;i<MOVE_Y_DELAY;i++);
 		xy_allow_step=FALSE;
+		if(XY_triggerMode){
+			XY_triggeredCapture();
+		}
+		//for(i=0;i<MOVE_Y_DELAY;i++);
 		asm("nop;");
 		while(xy_allow_step==FALSE);
 		xy_allow_step=FALSE;
 	}
+	XY_moveEndTime = DSP_timestamp();
 //	Y_DISABLE;
 		
 }
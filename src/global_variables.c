@@ -26,10 +26,59 @@ unsigned int AR_bufferIndex=0;
 float *AR_bufferChA=memSamplesBufferChA;
 float *AR_bufferChB=memSamplesBufferChB;
 
+// Raw samples ring (SAMPLES_MEMORY) written by the ADC interrupt in block mode
+volatile unsigned int AR_rawIndex=0;
+unsigned int AR_rawTotal=0;
+volatile bool AR_rawFinished=0;
+unsigned int AR_rawOverruns=0;		// Runs cut short by a full raw ring
+
+// Packed raw capture mode requested by USB, and the one of the current run.
+// Words fill memSamplesBufferChA and then memSamplesBufferChB.
+char AR_rawCaptureMode = RAW_CAPTURE_OFF;
+char AR_rawCapture = RAW_CAPTURE_OFF;
+unsigned int *AR_rawCapturePtr;
+
+// Sample packet encoding (signal_EncodeSamples), converted ENCODE_CHUNK
+// samples at a time through these buffers
+char DSP_sampleEncoding = ENCODE_FLOAT32;
+int ENC_quantized[ENCODE_CHUNK];
+unsigned int ENC_packed[ENCODE_CHUNK];
+
+// Lossless codec of float sample packets, set with each acquisition.
+// Statistics for USB_MSG_CODECSTATUS; CODEC_cycles counts the sizing
+// and coding passes and leaves out the USB writes, counted in
+// CODEC_sendCycles.
+bool AR_compress = FALSE;
+unsigned int CODEC_samples = 0;
+unsigned int CODEC_rawBytes = 0;
+unsigned int CODEC_packedBytes = 0;
+unsigned int CODEC_cycles = 0;
+unsigned int CODEC_sendCycles = 0;
+
+// Timestamps, requested by USB. The ADC interrupt stamps the first sample
+// of each run when armed and the main loop sends it (AR_timePending).
+bool DSP_timestamps = FALSE;
+unsigned long long AR_startTime;
+volatile bool AR_timeArmed = FALSE;
+volatile bool AR_timePending = FALSE;
+
+// ISR profiler (DSP_profile), in core cycles. An ISR misses its deadline
+// when it runs longer than PROF_deadline or is entered more than 1.5
+// deadlines after the previous entry. A deadline of 0 is not checked.
+unsigned int PROF_count[PROF_ISRS];
+unsigned int PROF_min[PROF_ISRS];
+unsigned int PROF_max[PROF_ISRS];
+unsigned int PROF_maxGap[PROF_ISRS];
+unsigned int PROF_missed[PROF_ISRS];
+unsigned int PROF_deadline[PROF_ISRS];
+unsigned int PROF_hist[PROF_ISRS][PROF_BUCKETS];
+unsigned int PROF_lastEntry[PROF_ISRS];
+bool PROF_gapValid[PROF_ISRS];
+
 unsigned char AR_continuousSampling=0;
 char OpMode = MODE_IF;
 
-bool DSP_processingFIR =0;
+volatile bool DSP_processingFIR =0;
 
 // Move XY speed global variables
 int move_x_speed = 300000;
@@ -84,10 +133,88 @@ float pm LP_FIR_coeffs[TAPS_FIR_LP] =
 {
 	#include "fir_coeff_LP.dat"
 };
+
+// Low pass as designed, for ADC_FS. LP_FIR_coeffs is derived from it for
+// the sample rate of each acquisition by Init_FIR_LPrate.
+float pm LP_FIR_design[TAPS_FIR_LP] =
+{
+	#include "fir_coeff_LP.dat"
+};
 	
 float dm FIR_LPstatesChA[TAPS_FIR_LP];
 float dm FIR_LPstatesChB[TAPS_FIR_LP];
 
+// Paired FIR filters. Coefficients are duplicated (h0,h0,h1,h1,...) and the
+// A/B states interleaved so each SIMD fetch feeds both processing elements.
+// Filled by Init_FIR_pair.
+float pm BP_FIR_coeffs2[2*TAPS_FIR];
+float dm FIR_BPstatesAB[4*TAPS_FIR];
+int FIR_BPindexAB;
+float pm LP_FIR_coeffs2[2*TAPS_FIR_LP];
+float dm FIR_LPstatesAB[4*TAPS_FIR_LP];
+int FIR_LPindexAB;
+
+// Polyphase decimating low pass filter. Decimation of 1 keeps the per sample fir().
+// Coefficients are LP_FIR_coeffs reordered by Init_FIR_LPdecimator.
+// The requested decimation becomes the active one when a run starts.
+unsigned int DSP_decimation = 1;
+unsigned int DSP_decimationRequest = 1;
+float pm POLY_LP_coeffs[TAPS_FIR_LP_POLY];
+float dm POLY_LPstatesChA[2*TAPS_FIR_LP_POLY];
+float dm POLY_LPstatesChB[2*TAPS_FIR_LP_POLY];
+
+// Block demodulation. Block size 0 keeps the demodulation in the ADC interrupt.
+// The block buffers keep the last TAPS_FIR_LP-1 mixed samples in front of each block.
+unsigned int DSP_blockSize = 0;
+unsigned int DSP_blockIndex = 0;
+unsigned int DSP_outputOverflows = 0;	// Block runs ended early by full sample buffers
+float dm DSP_blockI[TAPS_FIR_LP-1+DSP_BLOCK_MAX];
+float dm DSP_blockQ[TAPS_FIR_LP-1+DSP_BLOCK_MAX];
+
+// FIR accelerator offload of the block low pass. Window sets are double
+// buffered: the core mixes one set while the accelerator filters the other.
+// The offload serves finite IF block runs; requested by USB, active per run.
+bool DSP_firOffload = FALSE;
+bool DSP_firOffloadActive = FALSE;
+volatile int FIR_ACCstate[FIR_ACC_SETS];
+int FIR_ACCwindow[FIR_ACC_SETS];
+int FIR_ACCphase[FIR_ACC_SETS];
+float FIR_ACCinI[FIR_ACC_SETS][FIR_ACC_INPUT];
+float FIR_ACCinQ[FIR_ACC_SETS][FIR_ACC_INPUT];
+float FIR_ACCoutI[FIR_ACC_SETS][FIR_ACC_WINDOW];
+float FIR_ACCoutQ[FIR_ACC_SETS][FIR_ACC_WINDOW];
+
+// Overlap-save FFT convolution. I and Q are filtered together as one complex
+// signal, interleaved (re,im). Engine chosen by Init_OLS from the filter cost.
+char DSP_filterEngine = DSP_ENGINE_DIRECT;
+float dm OLS_in[2*OLS_FFT_SIZE];
+float dm OLS_work[2*OLS_FFT_SIZE];
+float pm OLS_H[2*OLS_FFT_SIZE];
+float pm OLS_twiddles[OLS_FFT_SIZE];
+
+// Single bin sliding DFT. The rings keep the last DFT_window mixed samples,
+// one I/Q output is produced every DFT_outputRate input samples.
+// The requested window and rate become the active ones when a run starts.
+unsigned int DFT_window = 256;
+unsigned int DFT_outputRate = 1;
+unsigned int DFT_windowRequest = 256;
+unsigned int DFT_outputRateRequest = 1;
+float dm DFT_ringI[DFT_WINDOW_MAX];
+float dm DFT_ringQ[DFT_WINDOW_MAX];
+
+// Multi frequency demodulation bank. Each lane has its own software LO and
+// shares the decimating low pass. The delay line holds, for every tap, the
+// I/Q of all the lanes side by side so one tap is applied to every lane in
+// a single inner loop. Outputs are interleaved by lane in AR_bufferChA/B.
+// The requested lanes become the active ones when a run starts.
+unsigned int BANK_lanes = 0;
+unsigned int BANK_lanesRequest = 0;
+bool BANK_active = FALSE;
+unsigned int BANK_if_inc[BANK_LANES_MAX];		// LO increments at ADC_FS
+unsigned int BANK_lut_inc[BANK_LANES_MAX];		// LO increments at the running rate
+unsigned int BANK_lut_acc[BANK_LANES_MAX];
+float dm BANK_states[2*TAPS_FIR_LP*BANK_STRIDE];
+
 
 float  pm IIR_coeffs[2*TAPS_IIR] =
 {
@@ -133,8 +260,16 @@ unsigned int DDS_inc_Flo;
 // internal DDS look up table increment and accumulator for the running frequency. Updated by ADC start sampling and read by ADC_sampleDone
 unsigned int iDDS_lut_inc;
 unsigned int iDDS_lut_acc;
-float sine_values_lut[] = {
-	#include "sine4096.txt"	
+// CORDIC angles atan(2^-i) with 2^32 = 360 degrees, as the LO phase accumulator
+unsigned int pm CORDIC_atan[CORDIC_ITERATIONS] = {
+	0x20000000, 0x12e4051e, 0x09fb385b, 0x051111d4, 0x028b0d43, 0x0145d7e1,
+	0x00a2f61e, 0x00517c55, 0x0028be53, 0x00145f2f, 0x000a2f98, 0x000517cc,
+	0x00028be6, 0x000145f3, 0x0000a2fa, 0x0000517d, 0x000028be, 0x0000145f,
+	0x00000a30, 0x00000518, 0x0000028c, 0x00000146, 0x000000a3, 0x00000051
+};
+
+float pm sine_quarter_lut[SINE_QUARTER_SIZE+1] = {
+	#include "sine_quarter1025.txt"	
 	
 };
 	
@@ -102,3 +102,47 @@ int i, pmctlsetting;
 
 }
 
+
+
+/********************************************************************************************
+**
+**  Function: InitSDRAM
+**  Use:      Enables the SDRAM on bank 0 of the external port, where seg_ext_dmda lives.
+**            Used by the long capture mode (ADC_spillSDRAM).
+**  Note:     Bank 2 stays asynchronous, it is the USB FIFO (USB_init). MSEN is also set
+**            by USB_init.
+**
+*********************************************************************************************/
+void InitSDRAM(){
+
+    // SDRAM refresh rate, for the highest SDCLK of 166 MHz so that it holds for
+    // any PLL setting
+    // RDIV = ((f SDCLK X t REF )/NRA) - (tRAS + tRP )
+    // (166*(10^6)*64*(10^-3)/4096) - (7+3) = 2583
+    *pSDRRC= (0xA17)|(SDMODIFY<<17)|SDROPT;
+
+    //===================================================================
+    //
+    // Configure SDRAM Control Register (SDCTL) for the 16-bit SDRAM
+    //
+    //  SDCL3  : SDRAM CAS Latency= 3 cycles
+    //  DSDCLK1: Disable SDRAM Clock 1
+    //  SDPSS  : Start SDRAM Power up Sequence
+    //  SDCAW9 : SDRAM Bank Column Address Width= 9 bits
+    //  SDRAW13: SDRAM Row Address Width= 13 bits
+    //  SDTRAS7: SDRAM tRAS Specification. Active Command delay = 7 cycles
+    //  SDTRP3 : SDRAM tRP Specification. Precharge delay = 3 cycles.
+    //  SDTWR2 : SDRAM tWR Specification. tWR = 2 cycles.
+    //  SDTRCD3: SDRAM tRCD Specification. tRCD = 3 cycles.
+    //  X16DE  : 16-bit SDRAM data bus, 32-bit words are packed in two accesses
+    //
+    //--------------------------------------------------------------------
+
+    *pSDCTL= SDCL3|DSDCLK1|SDPSS|SDCAW9|SDRAW13|SDTRAS7|SDTRP3|SDTWR2|SDTRCD3|X16DE;
+
+    *pSYSCTL |=MSEN;
+
+    // Mapping Bank 0 to SDRAM
+    *pEPCTL |=B0SD;
+    *pEPCTL &= ~(B1SD|B2SD|B3SD);
+}
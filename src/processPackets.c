@@ -26,6 +26,13 @@
 			LOCAL PACKET GLOBAL VARIABLES
 ***************************************************************/
 
+// Bit writer of the delta codec (process_putBits)
+unsigned int codec_bits;		// Pending bits, from the least significant
+int codec_fill;					// Number of pending bits
+int codec_words;				// Words waiting in ENC_packed
+unsigned int codec_total;		// Words of the channel so far
+int codec_error;
+
 
 
 
@@ -65,7 +72,8 @@ int USB_processPayload(unsigned short payload_size, unsigned char * payload_buff
 			break;
 		case USB_MSG_ADC_SAMPLING:
 //			printf("payload size:%d\n",payload_size);
-			if(payload_size != USB_MSG_ADC_SAMPLING_SIZE) return USB_WRONG_CMD_SIZE;
+			if(payload_size != USB_MSG_ADC_SAMPLING_SIZE
+				&& payload_size != USB_MSG_ADC_SAMPLING_CODEC_SIZE) return USB_WRONG_CMD_SIZE;
 			
 			processADCStartSampling(payload_size, payload_buffer);
 			break;
@@ -111,6 +119,96 @@ int USB_processPayload(unsigned short payload_size, unsigned char * payload_buff
 			
 			processADCSingleSample(payload_size, payload_buffer);
 			break;
+		case USB_MSG_DECIMATION:
+			if(payload_size != USB_MSG_DECIMATION_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processDecimation(payload_size, payload_buffer);
+			break;
+		case USB_MSG_BLOCKSIZE:
+			if(payload_size != USB_MSG_BLOCKSIZE_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processBlockSize(payload_size, payload_buffer);
+			break;
+		case USB_MSG_FIROFFLOAD:
+			if(payload_size != USB_MSG_FIROFFLOAD_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processFIROffload(payload_size, payload_buffer);
+			break;
+		case USB_MSG_DFT:
+			if(payload_size != USB_MSG_DFT_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processDFT(payload_size, payload_buffer);
+			break;
+		case USB_MSG_BANK:
+			if(payload_size != USB_MSG_BANK_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processBank(payload_size, payload_buffer);
+			break;
+		case USB_MSG_ADCDMA:
+			if(payload_size != USB_MSG_ADCDMA_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processADCDMA(payload_size, payload_buffer);
+			break;
+		case USB_MSG_RINGSTATUS:
+			if(payload_size != USB_MSG_RINGSTATUS_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processRingStatus(payload_size, payload_buffer);
+			break;
+		case USB_MSG_RAWCAPTURE:
+			if(payload_size != USB_MSG_RAWCAPTURE_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processRawCapture(payload_size, payload_buffer);
+			break;
+		case USB_MSG_SPILL:
+			if(payload_size != USB_MSG_SPILL_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processSpill(payload_size, payload_buffer);
+			break;
+		case USB_MSG_TIMESTAMPS:
+			if(payload_size != USB_MSG_TIMESTAMPS_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processTimestamps(payload_size, payload_buffer);
+			break;
+		case USB_MSG_OVERSAMPLING:
+			if(payload_size != USB_MSG_OVERSAMPLING_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processOversampling(payload_size, payload_buffer);
+			break;
+		case USB_MSG_PROFILE:
+			if(payload_size != USB_MSG_PROFILE_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processProfile(payload_size, payload_buffer);
+			break;
+		case USB_MSG_TRIGGER:
+			if(payload_size != USB_MSG_TRIGGER_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processTrigger(payload_size, payload_buffer);
+			break;
+		case USB_MSG_USBMODE:
+			if(payload_size != USB_MSG_USBMODE_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processUSBMode(payload_size, payload_buffer);
+			break;
+		case USB_MSG_ENCODING:
+			if(payload_size != USB_MSG_ENCODING_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processEncoding(payload_size, payload_buffer);
+			break;
+		case USB_MSG_CODECSTATUS:
+			if(payload_size != USB_MSG_CODECSTATUS_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processCodecStatus(payload_size, payload_buffer);
+			break;
+		case USB_MSG_TXQUEUE:
+			if(payload_size != USB_MSG_TXQUEUE_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processTxQueue(payload_size, payload_buffer);
+			break;
+		case USB_MSG_TXSTATUS:
+			if(payload_size != USB_MSG_TXSTATUS_SIZE) return USB_WRONG_CMD_SIZE;
+			
+			processTxStatus(payload_size, payload_buffer);
+			break;
 		default:
 			return USB_ERROR_FLAG;
 		
@@ -298,6 +396,8 @@ int processSetCurrentScale(unsigned short msg_size, unsigned char * msg_buffer)
 	Description: Processes an ADC Sampling message
 		
 	Extra:	#!
+			byte compress, optional - non zero sends the float
+			sample packets of this acquisition with the delta codec
 
 ************************************************************/
 int processADCStartSampling(unsigned short msg_size, unsigned char * msg_buffer)
@@ -309,7 +409,7 @@ int processADCStartSampling(unsigned short msg_size, unsigned char * msg_buffer)
 	unsigned int number_of_samples;
 		
 	// Checks if this message corresponds to a Change Frequency command
-	if(msg_size != USB_MSG_ADC_SAMPLING_SIZE 
+	if(msg_size != USB_MSG_ADC_SAMPLING_SIZE && msg_size != USB_MSG_ADC_SAMPLING_CODEC_SIZE
 		&& msg_buffer[0] != USB_MSG_ADC_SAMPLING) {
 			return USB_WRONG_CMD;
 	}
@@ -327,6 +427,15 @@ int processADCStartSampling(unsigned short msg_size, unsigned char * msg_buffer)
 	number_of_samples |= msg_buffer[9];
 	
 	SweepMode = msg_buffer[10]&0xff;
+	
+	// The FIR accelerator offload only serves finite block runs
+	if(continuous_sampling && DSP_firOffload && DSP_blockSize && OpMode == MODE_IF){
+		printf("error ADC Sampling: FIR offload in continuous mode!\n");
+		return USB_WRONG_CMD;
+	}
+	
+	// Optional byte: lossless codec for this acquisition
+	AR_compress = (msg_size == USB_MSG_ADC_SAMPLING_CODEC_SIZE && (msg_buffer[11]&0xff)) ? TRUE : FALSE;
 //	DRIVER_ENABLE;
 	ADC_StartSampling(number_of_samples, sampling_period, continuous_sampling);
 	
@@ -442,6 +551,9 @@ int process_sendAcknowledge(unsigned char header)
 	
 //	printf("sent acknowledge: %x\n",header);
 
+	if(USB_txEnabled){
+		return USB_txQueue(acknowledge_payload_size, &USB_ACK_BUFFER[0], 0, NULL, 0, NULL, FALSE);
+	}
 	if(USB_writeBuffer(acknowledge_payload_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
 		return USB_ERROR_FLAG;	
 	} 
@@ -450,6 +562,277 @@ int process_sendAcknowledge(unsigned char header)
 }
 
 
+/************************************************************
+	Function:	unsigned int process_sampleBytes (unsigned int sample_size, float * bufferChA, float * bufferChB)
+	Argument:	unsigned int sample_size - Samples per channel
+				float * bufferChA, * bufferChB - Samples to send
+	Return:		Bytes process_sendSamples sends.
+			
+	Description: Payload size of both channels in the current
+		DSP_sampleEncoding, encoding fields included. With the
+		delta codec the size depends on the samples.
+		
+	Extra:	
+
+************************************************************/
+unsigned int process_sampleBytes(unsigned int sample_size, float * bufferChA, float * bufferChB)
+{
+	if(DSP_sampleEncoding == ENCODE_FLOAT32 && AR_compress){
+		return 1 + 4 + 4*process_deltaWords(sample_size, (unsigned int*)bufferChA)
+					+ 4*process_deltaWords(sample_size, (unsigned int*)bufferChB);
+	}
+	if(DSP_sampleEncoding == ENCODE_FLOAT32){
+		return sample_size*2*4;
+	}
+	return 1 + 4 + 4 + 2*4*signal_EncodeWords(sample_size, DSP_sampleEncoding);
+}
+
+
+
+/************************************************************
+	Function:	unsigned int process_deltaWords (unsigned int sample_size, unsigned int * buffer)
+	Argument:	unsigned int sample_size - Words of the channel
+				unsigned int * buffer - Channel, float bit patterns
+	Return:		Words process_sendDelta sends for the channel.
+			
+	Description: Sizing pass of the delta codec.
+		
+	Extra:	Counted in CODEC_cycles, as the coding pass.
+
+************************************************************/
+unsigned int process_deltaWords(unsigned int sample_size, unsigned int * buffer)
+{
+	unsigned int start, block, bits, time;
+	unsigned int previous = 0;
+	int width;
+	
+	if(sample_size == 0){
+		return 0;
+	}
+	time = DSP_cycles();
+	bits = 32;
+	previous = buffer[0];
+	for(start = 1; start < sample_size; start += block){
+		block = sample_size - start;
+		if(block > CODEC_BLOCK) block = CODEC_BLOCK;
+		width = signal_DeltaBlock(block, &buffer[start], previous);
+		bits += CODEC_WIDTH_BITS + width*block;
+		previous = buffer[start+block-1];
+	}
+	CODEC_cycles += DSP_cycles() - time;
+	
+	return (bits+31)/32;
+}
+
+
+
+/************************************************************
+	Function:	void process_putBits (unsigned int value, int width)
+	Argument:	unsigned int value - Bits to append, from the least significant
+				int width - Number of bits, 0 to 32
+	Return:		
+			
+	Description: Bit writer of the delta codec. Full words go to
+		ENC_packed, which is sent whenever it fills up.
+		
+	Extra:	Errors are kept in codec_error.
+
+************************************************************/
+void process_putBits(unsigned int value, int width)
+{
+	unsigned int start;
+	
+	if(width == 0){
+		return;
+	}
+	if(width < 32){
+		value &= (1u<<width)-1;
+	}
+	codec_bits |= value<<codec_fill;
+	if(codec_fill + width < 32){
+		codec_fill += width;
+		return;
+	}
+	
+	ENC_packed[codec_words++] = codec_bits;
+	codec_total++;
+	codec_bits = codec_fill ? value>>(32-codec_fill) : 0;
+	codec_fill = codec_fill + width - 32;
+	
+	if(codec_words == ENCODE_CHUNK){
+		start = DSP_cycles();
+		if(USB_sendADCData(codec_words, ENC_packed) == USB_ERROR_FLAG){
+			codec_error = TRUE;
+		}
+		CODEC_sendCycles += DSP_cycles() - start;
+		codec_words = 0;
+	}
+}
+
+
+
+/************************************************************
+	Function:	int process_sendDelta (unsigned int sample_size, unsigned int * buffer)
+	Argument:	unsigned int sample_size - Words of the channel
+				unsigned int * buffer - Channel, float bit patterns
+	Return:		TRUE if the channel was sent.
+				USB_ERROR_FLAG if there was an error
+			
+	Description: Sends one channel with the lossless delta codec,
+		process_deltaWords words in all.
+		
+	Extra:	
+			Little endian bit stream, least significant bit first:
+			32 bits of the first word, then for every CODEC_BLOCK
+			words a CODEC_WIDTH_BITS width and the zig-zag codes of
+			the differences (signal_DeltaBlock) in that many bits.
+			The last word is zero padded.
+
+************************************************************/
+int process_sendDelta(unsigned int sample_size, unsigned int * buffer)
+{
+	unsigned int start, block, time, send_time;
+	unsigned int previous;
+	int width, i;
+	
+	if(sample_size == 0){
+		return TRUE;
+	}
+	time = DSP_cycles();
+	send_time = CODEC_sendCycles;
+	codec_bits = 0;
+	codec_fill = 0;
+	codec_words = 0;
+	codec_total = 0;
+	codec_error = FALSE;
+	
+	process_putBits(buffer[0], 32);
+	previous = buffer[0];
+	for(start = 1; start < sample_size; start += block){
+		block = sample_size - start;
+		if(block > CODEC_BLOCK) block = CODEC_BLOCK;
+		width = signal_DeltaBlock(block, &buffer[start], previous);
+		process_putBits(width, CODEC_WIDTH_BITS);
+		for(i = 0; i < block; i++){
+			process_putBits(ENC_quantized[i], width);
+		}
+		previous = buffer[start+block-1];
+	}
+	if(codec_fill){
+		ENC_packed[codec_words++] = codec_bits;
+		codec_total++;
+	}
+	
+	CODEC_samples += sample_size;
+	CODEC_rawBytes += 4*sample_size;
+	CODEC_packedBytes += 4*codec_total;
+	CODEC_cycles += DSP_cycles() - time - (CODEC_sendCycles - send_time);
+	
+	if(codec_words && USB_sendADCData(codec_words, ENC_packed) == USB_ERROR_FLAG){
+		codec_error = TRUE;
+	}
+	
+	return codec_error ? USB_ERROR_FLAG : TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int process_sendSamples (unsigned int sample_size, float * bufferChA, float * bufferChB)
+	Argument:	unsigned int sample_size - Samples per channel
+				float * bufferChA, * bufferChB - Samples to send
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sends the samples of a sample packet, after its
+		header, in the current DSP_sampleEncoding.
+		
+	Extra:	
+			ENCODE_FLOAT32: channel A floats, then channel B floats.
+			ENCODE_INT16, ENCODE_INT24: byte encoding, int sample_size
+			and float scale, most significant byte first, then each
+			channel as a little endian stream of codes, zero padded to
+			a whole word. A sample is its code times scale.
+			ENCODE_FLOAT32 with AR_compress: byte ENCODE_DELTA and int
+			sample_size, then each channel as in process_sendDelta.
+
+************************************************************/
+int process_sendSamples(unsigned int sample_size, float * bufferChA, float * bufferChB)
+{
+	unsigned char fields[1+4+4];
+	float * channel[2];
+	float scale, inv_scale;
+	unsigned int scale_bits, start, chunk, words;
+	int ch;
+	
+	if(DSP_sampleEncoding == ENCODE_FLOAT32 && AR_compress){
+		fields[0] = ENCODE_DELTA;
+		fields[1] = (sample_size>>24&0xff);
+		fields[2] = (sample_size>>16&0xff);
+		fields[3] = (sample_size>>8&0xff);
+		fields[4] = sample_size&0xff;
+		if(USB_writeBuffer(5, fields) == USB_ERROR_FLAG){
+			return USB_ERROR_FLAG;	
+		} 
+		if(process_sendDelta(sample_size, (unsigned int*)bufferChA) == USB_ERROR_FLAG){
+			printf("error sending channel A\n");
+			return USB_ERROR_FLAG;	
+		}
+		if(process_sendDelta(sample_size, (unsigned int*)bufferChB) == USB_ERROR_FLAG){
+			printf("error sending channel B\n");
+			return USB_ERROR_FLAG;	
+		}
+		return TRUE;
+	}
+	if(DSP_sampleEncoding == ENCODE_FLOAT32){
+		if(USB_sendADCData(sample_size, (unsigned int*)bufferChA) == USB_ERROR_FLAG){
+			printf("error sending channel A\n");
+			return USB_ERROR_FLAG;	
+		} 
+		if(USB_sendADCData(sample_size, (unsigned int*)bufferChB) == USB_ERROR_FLAG){
+			printf("error sending channel B\n");
+			return USB_ERROR_FLAG;	
+		} 
+		return TRUE;
+	}
+	
+	scale = signal_EncodeScale(sample_size, bufferChA, bufferChB, DSP_sampleEncoding);
+	inv_scale = 1.0/scale;
+	scale_bits = *(unsigned int*)&scale;
+	
+	fields[0] = DSP_sampleEncoding;
+	fields[1] = (sample_size>>24&0xff);
+	fields[2] = (sample_size>>16&0xff);
+	fields[3] = (sample_size>>8&0xff);
+	fields[4] = sample_size&0xff;
+	fields[5] = (scale_bits>>24&0xff);
+	fields[6] = (scale_bits>>16&0xff);
+	fields[7] = (scale_bits>>8&0xff);
+	fields[8] = scale_bits&0xff;
+	if(USB_writeBuffer(sizeof(fields), fields) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	
+	channel[0] = bufferChA;
+	channel[1] = bufferChB;
+	for(ch = 0; ch < 2; ch++){
+		for(start = 0; start < sample_size; start += chunk){
+			chunk = sample_size - start;
+			if(chunk > ENCODE_CHUNK) chunk = ENCODE_CHUNK;
+			words = signal_EncodeSamples(chunk, &channel[ch][start], inv_scale, DSP_sampleEncoding);
+			if(USB_sendADCData(words, ENC_packed) == USB_ERROR_FLAG){
+				printf("error sending channel %d\n", ch);
+				return USB_ERROR_FLAG;	
+			} 
+		}
+	}
+	
+	return TRUE;
+}
+
+
+
 /************************************************************
 	Function:	int process_sendSampleData (unsigned char header)
 	Argument:	unsigned char header - Same header as received packet
@@ -472,7 +855,7 @@ int process_sendSampleData(unsigned short sample_size, float * bufferChA, float
 	
 	
 	packet_size = sizeof(float);
-	packet_size = 1 + sample_size*2*4;//sizeof(float);
+	packet_size = 1 + process_sampleBytes(sample_size, bufferChA, bufferChB);//sizeof(float);
 	payload_size = sample_size+1;
 	
 	USB_ACK_BUFFER[0] = USB_START_OF_PACKET_TO_HOST;
@@ -483,147 +866,408 @@ int process_sendSampleData(unsigned short sample_size, float * bufferChA, float
 	
 	USB_ACK_BUFFER[5] = USB_MSG_SENDSAMPLEDATA; // header
 	
-	
+	// Queued float samples are sent from the caller's buffers,
+	// dropped if the queue is full
+	if(USB_txEnabled && DSP_sampleEncoding == ENCODE_FLOAT32 && !AR_compress){
+		return USB_txQueue(sendSampleData_header_size, &USB_ACK_BUFFER[0],
+				sample_size, (unsigned int*)bufferChA, sample_size, (unsigned int*)bufferChB, TRUE);
+	}
 	
 	if(USB_writeBuffer(sendSampleData_header_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
 		return USB_ERROR_FLAG;	
 	} 
-	if(USB_sendADCData(sample_size*sizeof(float), (unsigned char*)bufferChA) == USB_ERROR_FLAG){
-		printf("error sending channel A\n");
-		return USB_ERROR_FLAG;	
-	} 
-	if(USB_sendADCData(sample_size*sizeof(float), (unsigned char*)bufferChB) == USB_ERROR_FLAG){
-		printf("error sending channel B\n");
-		return USB_ERROR_FLAG;	
-	} 
 	
-	return TRUE;
+	return process_sendSamples(sample_size, bufferChA, bufferChB);
 }
 
 
+
 /************************************************************
-	Function:	int processMoveXY (unsigned short msg_size, unsigned char * msg_buffer)
-	Argument:	unsigned short msg_size - Payload message size for confirmation
- 				unsigned char * msg_buffer - Payload buffer with message to process
+	Function:	int process_sendBlockData (unsigned int sequence, unsigned short sample_size,
+						float * bufferChA, float * bufferChB)
+	Argument:	unsigned int sequence - Sequence number of the ping-pong buffer
+				unsigned short sample_size - Number of samples of each channel
+				float * bufferChA, bufferChB - Samples
 	Return:		TRUE if message has been processed without errors.
 				USB_ERROR_FLAG if there was an error
 			
 			
-	Description: Moves probe a number of steps on the X or Y axis.
+	Description: Sends the samples of one continuous block mode
+		buffer. Same as process_sendSampleData with the buffer
+		sequence number after the header.
 		
 	Extra:	
-			byte XY
-			int steps
+			int sequence, most significant byte first
+
 ************************************************************/
-int processMoveXY(unsigned short msg_size, unsigned char * msg_buffer)
+int process_sendBlockData(unsigned int sequence, unsigned short sample_size,
+						float * bufferChA, float * bufferChB)
 {
-	int i;	
-	int steps;
-	char cw_ccw;
-	char half_full;
-	char XY;
-	int speed;
-	// Checks if this message corresponds to a Change Frequency command
-	if(msg_size != USB_MSG_MOVEXY_SIZE 
-		&& msg_buffer[0] != USB_MSG_MOVEXY) {
-			printf("error XY!\n");//#!
-			return USB_WRONG_CMD;
-	}
-	 
-	XY = msg_buffer[1];
-	half_full = msg_buffer[2];
-	cw_ccw = msg_buffer[3];
-	steps = (msg_buffer[4]<<24|msg_buffer[5]<<16|msg_buffer[6]<<8 | msg_buffer[7])&0xffffffff;
-	speed = (msg_buffer[8]<<24|msg_buffer[9]<<16|msg_buffer[10]<<8 | msg_buffer[11])&0xffffffff;
-//	printf("move: %d \n", speed);
-
-	if(XY == MOVE_X){
-		X_init( half_full,  cw_ccw);
-		move_x_speed = speed;
-		X_move(steps);
-	}else if(XY == MOVE_Y){
-		Y_init( half_full,  cw_ccw);
-		move_y_speed = speed;
-		Y_move(steps);	
-		move_y_speed = speed;
-		
-	}
-	process_sendAcknowledge(msg_buffer[0]);
-
-	return TRUE;
+	unsigned int packet_size;
+	unsigned short sendBlockData_header_size=10;
+	
+	packet_size = 1 + 4 + process_sampleBytes(sample_size, bufferChA, bufferChB);
+	
+	USB_ACK_BUFFER[0] = USB_START_OF_PACKET_TO_HOST;
+	USB_ACK_BUFFER[1] = (packet_size>>24&0xff);
+	USB_ACK_BUFFER[2] = (packet_size>>16&0xff);
+	USB_ACK_BUFFER[3] = (packet_size>>8&0xff);
+	USB_ACK_BUFFER[4] = packet_size&0xff;
+	
+	USB_ACK_BUFFER[5] = USB_MSG_SENDBLOCKDATA; // header
+	USB_ACK_BUFFER[6] = (sequence>>24&0xff);
+	USB_ACK_BUFFER[7] = (sequence>>16&0xff);
+	USB_ACK_BUFFER[8] = (sequence>>8&0xff);
+	USB_ACK_BUFFER[9] = sequence&0xff;
+	
+	if(USB_writeBuffer(sendBlockData_header_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	
+	return process_sendSamples(sample_size, bufferChA, bufferChB);
 }
 
 
 
 /************************************************************
-	Function:	int processDriverEnable (unsigned short msg_size, unsigned char * msg_buffer)
-	Argument:	unsigned short msg_size - Payload message size for confirmation
- 				unsigned char * msg_buffer - Payload buffer with message to process
+	Function:	int process_sendStepData (unsigned int step, unsigned short sample_size, float * bufferChA, float * bufferChB)
+	Argument:	unsigned int step - Step index of the capture
+				unsigned short sample_size - Samples per channel
+				float * bufferChA, * bufferChB - Samples to send
 	Return:		TRUE if message has been processed without errors.
 				USB_ERROR_FLAG if there was an error
 			
 			
-	Description: Enables or Disables the driver
+	Description: Sends the result of a triggered acquisition.
+		Same as process_sendSampleData with the step index after
+		the header.
 		
 	Extra:	
-			byte ENABLE/DISABLE
-			
+			int step, most significant byte first
+
 ************************************************************/
-int processDriverEn(unsigned short msg_size, unsigned char * msg_buffer)
+int process_sendStepData(unsigned int step, unsigned short sample_size,
+						float * bufferChA, float * bufferChB)
 {
-	int temp;	
-	// Checks if this message corresponds to a Change Frequency command
-	if(msg_size != USB_MSG_DRIVER_EN_SIZE 
-		&& msg_buffer[0] != USB_MSG_DRIVER_EN) {
-			printf("error Driver EN!\n");//#!
-			return USB_WRONG_CMD;
-	}
-	temp = msg_buffer[1]& 0xff;
-	printf("DRIVER %d\n", temp);
+	unsigned int packet_size;
+	unsigned short sendStepData_header_size=10;
+	
+	packet_size = 1 + 4 + process_sampleBytes(sample_size, bufferChA, bufferChB);
+	
+	USB_ACK_BUFFER[0] = USB_START_OF_PACKET_TO_HOST;
+	USB_ACK_BUFFER[1] = (packet_size>>24&0xff);
+	USB_ACK_BUFFER[2] = (packet_size>>16&0xff);
+	USB_ACK_BUFFER[3] = (packet_size>>8&0xff);
+	USB_ACK_BUFFER[4] = packet_size&0xff;
+	
+	USB_ACK_BUFFER[5] = USB_MSG_SENDSTEPDATA; // header
+	USB_ACK_BUFFER[6] = (step>>24&0xff);
+	USB_ACK_BUFFER[7] = (step>>16&0xff);
+	USB_ACK_BUFFER[8] = (step>>8&0xff);
+	USB_ACK_BUFFER[9] = step&0xff;
+	
+	if(USB_writeBuffer(sendStepData_header_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	
+	return process_sendSamples(sample_size, bufferChA, bufferChB);
+}
 
-	if(temp == 0){
-		DRIVER_DISABLE ;
-	}else{
-		DRIVER_ENABLE;
-	}			
-	process_sendAcknowledge(msg_buffer[0]);
 
-	return TRUE;
-}
 
 /************************************************************
-	Function:	int processStepperEnable (unsigned short msg_size, unsigned char * msg_buffer)
-	Argument:	unsigned short msg_size - Payload message size for confirmation
- 				unsigned char * msg_buffer - Payload buffer with message to process
+	Function:	int process_sendRawData (unsigned int sample_size)
+	Argument:	unsigned int sample_size - Number of packed samples
 	Return:		TRUE if message has been processed without errors.
 				USB_ERROR_FLAG if there was an error
 			
 			
-	Description: Enables or Disables the stepper
+	Description: Sends a packed raw capture. The words are in
+		AR_bufferChA and, past MAX_SAMPLES_BUFFER_SIZE, in AR_bufferChB.
 		
 	Extra:	
-			byte ENABLE/DISABLE
-			
+			Each word is (chB<<16 | chA) as read from SPORT3. The
+			host converts with (code - CAL_CHx_DECIMAL)*2.5/65536.
+
 ************************************************************/
-int processStepperEn(unsigned short msg_size, unsigned char * msg_buffer)
+int process_sendRawData(unsigned int sample_size)
 {
-	int temp,stepper;	
-	// Checks if this message corresponds to a Change Frequency command
-	if(msg_size != USB_MSG_STEPPER_EN_SIZE 
-		&& msg_buffer[0] != USB_MSG_STEPPER_EN) {
-			printf("error Stepper EN!\n");//#!
-			return USB_WRONG_CMD;
-	}
-	temp = msg_buffer[1]& 0xff;
-	stepper = msg_buffer[2]& 0xff;
-
-
-	if(temp == 0){
-		if(stepper) Y_DISABLE; else X_DISABLE ;
-	}else{
-		if(stepper) Y_ENABLE ; else X_ENABLE ;
-	}			
-	process_sendAcknowledge(msg_buffer[0]);
+	unsigned int packet_size, first;
+	unsigned short sendRawData_header_size=6;
+	
+	packet_size = 1 + sample_size*4;
+	first = (sample_size > MAX_SAMPLES_BUFFER_SIZE) ? MAX_SAMPLES_BUFFER_SIZE : sample_size;
+	
+	USB_ACK_BUFFER[0] = USB_START_OF_PACKET_TO_HOST;
+	USB_ACK_BUFFER[1] = (packet_size>>24&0xff);
+	USB_ACK_BUFFER[2] = (packet_size>>16&0xff);
+	USB_ACK_BUFFER[3] = (packet_size>>8&0xff);
+	USB_ACK_BUFFER[4] = packet_size&0xff;
+	
+	USB_ACK_BUFFER[5] = USB_MSG_SENDRAWDATA; // header
+	
+	if(USB_writeBuffer(sendRawData_header_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	if(USB_sendADCData(first, (unsigned int*)AR_bufferChA) == USB_ERROR_FLAG){
+		printf("error sending raw data\n");
+		return USB_ERROR_FLAG;	
+	} 
+	if(sample_size > first){
+		if(USB_sendADCData(sample_size-first, (unsigned int*)AR_bufferChB) == USB_ERROR_FLAG){
+			printf("error sending raw data\n");
+			return USB_ERROR_FLAG;	
+		} 
+	}
+	
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int process_sendSpillData (unsigned int sequence, unsigned int sample_size,
+						unsigned int * buffer)
+	Argument:	unsigned int sequence - Sequence number of the SDRAM block
+				unsigned int sample_size - Number of packed samples
+				unsigned int * buffer - Packed samples, in SDRAM
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sends one block of a long capture. Same words as
+		process_sendRawData with the block sequence number after
+		the header.
+		
+	Extra:	
+			int sequence, most significant byte first
+
+************************************************************/
+int process_sendSpillData(unsigned int sequence, unsigned int sample_size,
+						unsigned int * buffer)
+{
+	unsigned int packet_size;
+	unsigned short sendSpillData_header_size=10;
+	
+	packet_size = 1 + 4 + sample_size*4;
+	
+	USB_ACK_BUFFER[0] = USB_START_OF_PACKET_TO_HOST;
+	USB_ACK_BUFFER[1] = (packet_size>>24&0xff);
+	USB_ACK_BUFFER[2] = (packet_size>>16&0xff);
+	USB_ACK_BUFFER[3] = (packet_size>>8&0xff);
+	USB_ACK_BUFFER[4] = packet_size&0xff;
+	
+	USB_ACK_BUFFER[5] = USB_MSG_SENDSPILLDATA; // header
+	USB_ACK_BUFFER[6] = (sequence>>24&0xff);
+	USB_ACK_BUFFER[7] = (sequence>>16&0xff);
+	USB_ACK_BUFFER[8] = (sequence>>8&0xff);
+	USB_ACK_BUFFER[9] = sequence&0xff;
+	
+	if(USB_writeBuffer(sendSpillData_header_size, &USB_ACK_BUFFER[0]) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	if(USB_sendADCData(sample_size, (unsigned int*)buffer) == USB_ERROR_FLAG){
+		printf("error sending spill data\n");
+		return USB_ERROR_FLAG;	
+	} 
+	
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int process_sendTimestamp (char event, unsigned int index, unsigned long long time)
+	Argument:	char event - TIMESTAMP_START, TIMESTAMP_BLOCK, TIMESTAMP_MOVE_START
+						or TIMESTAMP_MOVE_END
+				unsigned int index - Block sequence number, or steps of a move
+				unsigned long long time - Core cycles (DSP_timestamp)
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sends a timestamp. Acquisition timestamps are sent
+		before the data they refer to; sample k of that data was
+		taken at time + k*period.
+		
+	Extra:	
+			byte event
+			int index
+			int time high, int time low
+			int period - Sample period in core cycles
+			All most significant byte first
+
+************************************************************/
+int process_sendTimestamp(char event, unsigned int index, unsigned long long time)
+{
+	unsigned char buffer[23];
+	unsigned int packet_size, high, low, period;
+	
+	packet_size = 18;
+	high = time>>32;
+	low = time&0xffffffff;
+	period = ADC_fsDivider*CCLK_PER_PCG_TICK;
+	
+	buffer[0] = USB_START_OF_PACKET_TO_HOST;
+	buffer[1] = (packet_size>>24&0xff);
+	buffer[2] = (packet_size>>16&0xff);
+	buffer[3] = (packet_size>>8&0xff);
+	buffer[4] = packet_size&0xff;
+	
+	buffer[5] = USB_MSG_SENDTIMESTAMP; // header
+	buffer[6] = event;
+	buffer[7] = (index>>24&0xff);
+	buffer[8] = (index>>16&0xff);
+	buffer[9] = (index>>8&0xff);
+	buffer[10] = index&0xff;
+	buffer[11] = (high>>24&0xff);
+	buffer[12] = (high>>16&0xff);
+	buffer[13] = (high>>8&0xff);
+	buffer[14] = high&0xff;
+	buffer[15] = (low>>24&0xff);
+	buffer[16] = (low>>16&0xff);
+	buffer[17] = (low>>8&0xff);
+	buffer[18] = low&0xff;
+	buffer[19] = (period>>24&0xff);
+	buffer[20] = (period>>16&0xff);
+	buffer[21] = (period>>8&0xff);
+	buffer[22] = period&0xff;
+	
+	if(USB_writeBuffer(23, buffer) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+	
+	return TRUE;
+}
+
+
+/************************************************************
+	Function:	int processMoveXY (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Moves probe a number of steps on the X or Y axis.
+		
+	Extra:	
+			byte XY
+			int steps
+************************************************************/
+int processMoveXY(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int i;	
+	int steps;
+	char cw_ccw;
+	char half_full;
+	char XY;
+	int speed;
+	// Checks if this message corresponds to a Change Frequency command
+	if(msg_size != USB_MSG_MOVEXY_SIZE 
+		&& msg_buffer[0] != USB_MSG_MOVEXY) {
+			printf("error XY!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	 
+	XY = msg_buffer[1];
+	half_full = msg_buffer[2];
+	cw_ccw = msg_buffer[3];
+	steps = (msg_buffer[4]<<24|msg_buffer[5]<<16|msg_buffer[6]<<8 | msg_buffer[7])&0xffffffff;
+	speed = (msg_buffer[8]<<24|msg_buffer[9]<<16|msg_buffer[10]<<8 | msg_buffer[11])&0xffffffff;
+//	printf("move: %d \n", speed);
+
+	if(XY == MOVE_X){
+		X_init( half_full,  cw_ccw);
+		move_x_speed = speed;
+		X_move(steps);
+	}else if(XY == MOVE_Y){
+		Y_init( half_full,  cw_ccw);
+		move_y_speed = speed;
+		Y_move(steps);	
+		move_y_speed = speed;
+		
+	}
+	if(DSP_timestamps){
+		process_sendTimestamp(TIMESTAMP_MOVE_START, steps, XY_moveStartTime);
+		process_sendTimestamp(TIMESTAMP_MOVE_END, steps, XY_moveEndTime);
+	}
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processDriverEnable (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the driver
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processDriverEn(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Change Frequency command
+	if(msg_size != USB_MSG_DRIVER_EN_SIZE 
+		&& msg_buffer[0] != USB_MSG_DRIVER_EN) {
+			printf("error Driver EN!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("DRIVER %d\n", temp);
+
+	if(temp == 0){
+		DRIVER_DISABLE ;
+	}else{
+		DRIVER_ENABLE;
+	}			
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int processStepperEnable (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the stepper
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processStepperEn(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp,stepper;	
+	// Checks if this message corresponds to a Change Frequency command
+	if(msg_size != USB_MSG_STEPPER_EN_SIZE 
+		&& msg_buffer[0] != USB_MSG_STEPPER_EN) {
+			printf("error Stepper EN!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	stepper = msg_buffer[2]& 0xff;
+
+
+	if(temp == 0){
+		if(stepper) Y_DISABLE; else X_DISABLE ;
+	}else{
+		if(stepper) Y_ENABLE ; else X_ENABLE ;
+	}			
+	process_sendAcknowledge(msg_buffer[0]);
 
 	return TRUE;
 }
@@ -637,7 +1281,8 @@ int processStepperEn(unsigned short msg_size, unsigned char * msg_buffer)
 				USB_ERROR_FLAG if there was an error
 			
 			
-	Description: Changes operation mode to IF or IQ
+	Description: Changes operation mode to IF, IQ or DFT (single
+		bin sliding DFT at the IF)
 		
 	Extra:	
 			byte OpMode
@@ -653,10 +1298,12 @@ int processOpMode(unsigned short msg_size, unsigned char * msg_buffer)
 			return USB_WRONG_CMD;
 	}
 	temp = msg_buffer[1]& 0xff;
-	printf("OpMode %s\n", temp? "IF":"IQ");
+	printf("OpMode %s\n", (temp == MODE_DFT)? "DFT" : (temp? "IF":"IQ"));
 
 	if(temp == MODE_IF){
 		OpMode = MODE_IF ;
+	}else if(temp == MODE_DFT){
+		OpMode = MODE_DFT ;
 	}else{
 		OpMode = MODE_IQ ;
 	}			
@@ -701,3 +1348,822 @@ int processADCSingleSample(unsigned short msg_size, unsigned char * msg_buffer)
 }
 
 
+
+/************************************************************
+	Function:	int processDecimation (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the decimation factor of the IF mode low pass filter.
+		Takes effect on the next acquisition run: the running one keeps
+		its decimation, polyphase tables and buffer sizes.
+		
+	Extra:	
+			byte decimation (1 - no decimation, up to DECIMATION_MAX)
+			
+************************************************************/
+int processDecimation(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Decimation command
+	if(msg_size != USB_MSG_DECIMATION_SIZE 
+		&& msg_buffer[0] != USB_MSG_DECIMATION) {
+			printf("error Decimation!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	
+	if(temp < 1) temp = 1;
+	if(temp > DECIMATION_MAX) temp = DECIMATION_MAX;
+	DSP_decimationRequest = temp;
+	printf("Decimation %d\n", temp);
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processBlockSize (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the block size of the demodulation pipeline.
+		A block size of 0 demodulates each sample in the ADC interrupt.
+		Otherwise the interrupt only stores raw samples and the main
+		loop demodulates them in blocks of this size.
+		
+	Extra:	
+			short block size (0 or 1 to DSP_BLOCK_MAX)
+			
+************************************************************/
+int processBlockSize(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Block Size command
+	if(msg_size != USB_MSG_BLOCKSIZE_SIZE 
+		&& msg_buffer[0] != USB_MSG_BLOCKSIZE) {
+			printf("error BlockSize!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = (msg_buffer[1]<<8 | msg_buffer[2])&0xffff;
+	
+	if(temp > DSP_BLOCK_MAX) temp = DSP_BLOCK_MAX;
+	DSP_blockSize = temp;
+	printf("BlockSize %d\n", temp);
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processFIROffload (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the FIR accelerator for the
+		low pass filter of the block demodulation (block size > 0).
+		Finite IF runs only: a continuous block mode run is refused
+		while it is enabled.
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processFIROffload(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a FIR Offload command
+	if(msg_size != USB_MSG_FIROFFLOAD_SIZE 
+		&& msg_buffer[0] != USB_MSG_FIROFFLOAD) {
+			printf("error FIR Offload!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("FIR Offload %d\n", temp);
+
+	DSP_firOffload = temp ? TRUE : FALSE;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processDFT (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the window length and output rate of the
+		single bin sliding DFT (OpMode DFT) for the next acquisition run.
+		
+	Extra:	A run in progress keeps its window and rate.
+			short window (1 to DFT_WINDOW_MAX)
+			short output rate (input samples per output)
+			
+************************************************************/
+int processDFT(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int window, rate;	
+	// Checks if this message corresponds to a DFT command
+	if(msg_size != USB_MSG_DFT_SIZE 
+		&& msg_buffer[0] != USB_MSG_DFT) {
+			printf("error DFT!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	window = (msg_buffer[1]<<8 | msg_buffer[2])&0xffff;
+	rate = (msg_buffer[3]<<8 | msg_buffer[4])&0xffff;
+	
+	if(window < 1) window = 1;
+	if(window > DFT_WINDOW_MAX) window = DFT_WINDOW_MAX;
+	if(rate < 1) rate = 1;
+	DFT_windowRequest = window;
+	DFT_outputRateRequest = rate;
+	printf("DFT window %d rate %d\n", window, rate);
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processBank (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Configures the multi frequency demodulation bank.
+		With 1 or more lanes, block mode IF acquisitions demodulate
+		every lane IF and send the lanes interleaved (lane 0, lane 1,
+		... for each sample). 0 lanes disables the bank.
+		
+	Extra:	The lanes and frequencies apply from the next acquisition run.
+			byte lanes (0 to BANK_LANES_MAX)
+			int IF frequency, one per lane (BANK_LANES_MAX), same
+				units as the Change Frequency message
+			
+************************************************************/
+int processBank(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int k, lanes, freq;	
+	// Checks if this message corresponds to a Bank command
+	if(msg_size != USB_MSG_BANK_SIZE 
+		&& msg_buffer[0] != USB_MSG_BANK) {
+			printf("error Bank!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	lanes = msg_buffer[1]&0xff;
+	if(lanes > BANK_LANES_MAX) lanes = BANK_LANES_MAX;
+	
+	for(k = 0; k < BANK_LANES_MAX; k++){
+		freq = msg_buffer[2+4*k] <<24;
+		freq |= msg_buffer[3+4*k] <<16;
+		freq |= msg_buffer[4+4*k] <<8;
+		freq |= msg_buffer[5+4*k];
+		freq = (int) freq * DDS_FREQUENCY_MULTIPLIER_FLOAT;
+		BANK_if_inc[k] = freq*1200;
+	}
+	BANK_lanesRequest = lanes;
+	printf("Bank lanes %d\n", lanes);
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processADCDMA (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the DMA reception of the ADC
+		samples. Only used with block processing (block size > 0),
+		otherwise every sample is read by the ADC interrupts.
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processADCDMA(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to an ADC DMA command
+	if(msg_size != USB_MSG_ADCDMA_SIZE 
+		&& msg_buffer[0] != USB_MSG_ADCDMA) {
+			printf("error ADC DMA!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("ADC DMA %d\n", temp);
+
+	ADC_dmaMode = temp ? TRUE : FALSE;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processRingStatus (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Replies with the continuous acquisition ring
+		telemetry, instead of an acknowledge.
+		
+	Extra:	
+			Reply: header, then int overruns, int high water mark
+			and int current level, most significant byte first
+			
+************************************************************/
+int processRingStatus(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	unsigned char reply[6+1+3*4];
+	unsigned int values[3];
+	unsigned int packet_size = 1+3*4;
+	int k;
+	
+	// Checks if this message corresponds to a Ring Status command
+	if(msg_size != USB_MSG_RINGSTATUS_SIZE 
+		&& msg_buffer[0] != USB_MSG_RINGSTATUS) {
+			printf("error Ring Status!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	
+	values[0] = ADC_ringOverruns;
+	values[1] = ADC_ringHighWater;
+	values[2] = ADC_ringCount();
+	
+	reply[0] = USB_START_OF_PACKET_TO_HOST;
+	reply[1] = (packet_size>>24&0xff);
+	reply[2] = (packet_size>>16&0xff);
+	reply[3] = (packet_size>>8&0xff);
+	reply[4] = packet_size&0xff;
+	reply[5] = msg_buffer[0];
+	for(k = 0; k < 3; k++){
+		reply[6+4*k] = (values[k]>>24&0xff);
+		reply[7+4*k] = (values[k]>>16&0xff);
+		reply[8+4*k] = (values[k]>>8&0xff);
+		reply[9+4*k] = values[k]&0xff;
+	}
+	
+	if(USB_writeBuffer(sizeof(reply), reply) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processRawCapture (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Selects the packed raw capture mode of finite,
+		point by point acquisitions.
+		
+	Extra:	
+			byte RAW_CAPTURE_OFF, RAW_CAPTURE_HOST or RAW_CAPTURE_VOLTS
+			
+************************************************************/
+int processRawCapture(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Raw Capture command
+	if(msg_size != USB_MSG_RAWCAPTURE_SIZE 
+		&& msg_buffer[0] != USB_MSG_RAWCAPTURE) {
+			printf("error Raw Capture!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	if(temp > RAW_CAPTURE_VOLTS){
+		printf("error Raw Capture mode %d\n", temp);
+		return USB_WRONG_CMD;
+	}
+	printf("Raw Capture %d\n", temp);
+
+	AR_rawCaptureMode = temp;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processSpill (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the long capture mode. Point by
+		point acquisitions then stream packed raw words through
+		the external SDRAM, without the internal buffer limit.
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processSpill(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Spill command
+	if(msg_size != USB_MSG_SPILL_SIZE 
+		&& msg_buffer[0] != USB_MSG_SPILL) {
+			printf("error Spill!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("Spill %d\n", temp);
+
+	ADC_spillMode = temp ? TRUE : FALSE;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processTimestamps (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Enables or Disables the timestamp packets
+		(USB_MSG_SENDTIMESTAMP) of acquisitions and XY moves.
+		
+	Extra:	
+			byte ENABLE/DISABLE
+			
+************************************************************/
+int processTimestamps(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Timestamps command
+	if(msg_size != USB_MSG_TIMESTAMPS_SIZE 
+		&& msg_buffer[0] != USB_MSG_TIMESTAMPS) {
+			printf("error Timestamps!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("Timestamps %d\n", temp);
+
+	DSP_timestamps = temp ? TRUE : FALSE;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processOversampling (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the ADC oversampling factor of DMA receive
+		mode runs. The output sample rate is unchanged.
+		
+	Extra:	
+			byte factor - 1 to ADC_OSR_MAX, rounded down to a power of two.
+			It is also lowered at start if the CNV period would fall
+			below ADC_FS_DIVIDER_MIN.
+			
+************************************************************/
+int processOversampling(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp, factor;	
+	// Checks if this message corresponds to an Oversampling command
+	if(msg_size != USB_MSG_OVERSAMPLING_SIZE 
+		&& msg_buffer[0] != USB_MSG_OVERSAMPLING) {
+			printf("error Oversampling!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	if(temp > ADC_OSR_MAX) temp = ADC_OSR_MAX;
+	for(factor = 1; factor*2 <= temp; factor *= 2);
+	printf("Oversampling %d\n", factor);
+
+	ADC_oversampling = factor;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processProfile (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Replies with the ISR profiler statistics, instead
+		of an acknowledge.
+		
+	Extra:	
+			byte clear - non zero clears the statistics after the reply.
+			Reply: header, then for PROF_ADC_SAMPLE, PROF_ADC_BLOCK,
+			PROF_STEPPER and PROF_ALIVE: int count, int min, int max,
+			int max gap between entries, int missed deadlines,
+			int deadline and PROF_BUCKETS int histogram counts, all in
+			core cycles and most significant byte first.
+			
+************************************************************/
+int processProfile(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	unsigned char reply[6+1+PROF_ISRS*(6+PROF_BUCKETS)*4];
+	unsigned int values[6+PROF_BUCKETS];
+	unsigned int packet_size = 1+PROF_ISRS*(6+PROF_BUCKETS)*4;
+	unsigned char * ptr;
+	int isr, k;
+	
+	// Checks if this message corresponds to a Profile command
+	if(msg_size != USB_MSG_PROFILE_SIZE 
+		&& msg_buffer[0] != USB_MSG_PROFILE) {
+			printf("error Profile!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	
+	reply[0] = USB_START_OF_PACKET_TO_HOST;
+	reply[1] = (packet_size>>24&0xff);
+	reply[2] = (packet_size>>16&0xff);
+	reply[3] = (packet_size>>8&0xff);
+	reply[4] = packet_size&0xff;
+	reply[5] = msg_buffer[0];
+	ptr = &reply[6];
+	for(isr = 0; isr < PROF_ISRS; isr++){
+		values[0] = PROF_count[isr];
+		values[1] = PROF_min[isr];
+		values[2] = PROF_max[isr];
+		values[3] = PROF_maxGap[isr];
+		values[4] = PROF_missed[isr];
+		values[5] = PROF_deadline[isr];
+		for(k = 0; k < PROF_BUCKETS; k++){
+			values[6+k] = PROF_hist[isr][k];
+		}
+		for(k = 0; k < 6+PROF_BUCKETS; k++){
+			*ptr++ = (values[k]>>24&0xff);
+			*ptr++ = (values[k]>>16&0xff);
+			*ptr++ = (values[k]>>8&0xff);
+			*ptr++ = values[k]&0xff;
+		}
+	}
+	
+	if(msg_buffer[1]& 0xff){
+		DSP_profileClear();
+	}
+	
+	if(USB_writeBuffer(sizeof(reply), reply) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processTrigger (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the triggered acquisition mode. While it is
+		on, every step of a move is followed by a capture, sent
+		with USB_MSG_SENDSTEPDATA before the move acknowledge.
+		
+	Extra:	
+			byte enable - also restarts the step index at 0
+			int settle - delay from step to capture, in us
+			int samples - samples per capture
+			int period - sample period, in us
+			
+************************************************************/
+int processTrigger(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	unsigned int settle, samples, period;
+	// Checks if this message corresponds to a Trigger command
+	if(msg_size != USB_MSG_TRIGGER_SIZE 
+		&& msg_buffer[0] != USB_MSG_TRIGGER) {
+			printf("error Trigger!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	settle = (msg_buffer[2]<<24|msg_buffer[3]<<16|msg_buffer[4]<<8 | msg_buffer[5])&0xffffffff;
+	samples = (msg_buffer[6]<<24|msg_buffer[7]<<16|msg_buffer[8]<<8 | msg_buffer[9])&0xffffffff;
+	period = (msg_buffer[10]<<24|msg_buffer[11]<<16|msg_buffer[12]<<8 | msg_buffer[13])&0xffffffff;
+	if(settle > XY_TRIGGER_SETTLE_MAX) settle = XY_TRIGGER_SETTLE_MAX;
+	if(samples > MAX_SAMPLES_BUFFER_SIZE-1) samples = MAX_SAMPLES_BUFFER_SIZE-1;
+	printf("Trigger %d: %d us, %d samples\n", msg_buffer[1]&0xff, settle, samples);
+
+	XY_triggerMode = (msg_buffer[1]&0xff) ? TRUE : FALSE;
+	XY_triggerSettle = settle;
+	XY_triggerSamples = samples;
+	XY_triggerPeriod = period;
+	XY_triggerStep = 0;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processUSBMode (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets how packets are written to the USB FIFO.
+		The acknowledge is still sent in the previous mode.
+		
+	Extra:	
+			byte mode - USB_WRITE_SINGLE or USB_WRITE_BURST. Both
+			write one byte per access on D0-7.
+			
+************************************************************/
+int processUSBMode(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a USB Mode command
+	if(msg_size != USB_MSG_USBMODE_SIZE 
+		&& msg_buffer[0] != USB_MSG_USBMODE) {
+			printf("error USB Mode!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	if(temp > USB_WRITE_BURST) temp = USB_WRITE_SINGLE;
+	printf("USB Mode %d\n", temp);
+
+	process_sendAcknowledge(msg_buffer[0]);
+	
+	USB_writeMode = temp;
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processEncoding (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Sets the wire encoding of the sample, block and
+		step data packets, see process_sendSamples.
+		
+	Extra:	
+			byte encoding - ENCODE_FLOAT32, ENCODE_INT16 or ENCODE_INT24.
+			Unknown values select ENCODE_FLOAT32.
+			
+************************************************************/
+int processEncoding(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to an Encoding command
+	if(msg_size != USB_MSG_ENCODING_SIZE 
+		&& msg_buffer[0] != USB_MSG_ENCODING) {
+			printf("error Encoding!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	if(temp > ENCODE_INT24) temp = ENCODE_FLOAT32;
+	printf("Encoding %d\n", temp);
+
+	DSP_sampleEncoding = temp;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processCodecStatus (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Replies with the delta codec statistics, instead
+		of an acknowledge. Compression ratio is raw bytes over
+		packed bytes, encode cost is cycles over samples.
+		
+	Extra:	
+			byte clear - non zero clears the statistics after the reply.
+			Reply: header, then int samples, int raw bytes, int packed
+			bytes and int encode cycles, most significant byte first
+			
+************************************************************/
+int processCodecStatus(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	unsigned char reply[6+1+4*4];
+	unsigned int values[4];
+	unsigned int packet_size = 1+4*4;
+	int k;
+	
+	// Checks if this message corresponds to a Codec Status command
+	if(msg_size != USB_MSG_CODECSTATUS_SIZE 
+		&& msg_buffer[0] != USB_MSG_CODECSTATUS) {
+			printf("error Codec Status!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	
+	values[0] = CODEC_samples;
+	values[1] = CODEC_rawBytes;
+	values[2] = CODEC_packedBytes;
+	values[3] = CODEC_cycles;
+	if(msg_buffer[1]& 0xff){
+		CODEC_samples = 0;
+		CODEC_rawBytes = 0;
+		CODEC_packedBytes = 0;
+		CODEC_cycles = 0;
+		CODEC_sendCycles = 0;
+	}
+	
+	reply[0] = USB_START_OF_PACKET_TO_HOST;
+	reply[1] = (packet_size>>24&0xff);
+	reply[2] = (packet_size>>16&0xff);
+	reply[3] = (packet_size>>8&0xff);
+	reply[4] = packet_size&0xff;
+	reply[5] = msg_buffer[0];
+	for(k = 0; k < 4; k++){
+		reply[6+4*k] = (values[k]>>24&0xff);
+		reply[7+4*k] = (values[k]>>16&0xff);
+		reply[8+4*k] = (values[k]>>8&0xff);
+		reply[9+4*k] = values[k]&0xff;
+	}
+	
+	if(USB_writeBuffer(sizeof(reply), reply) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processTxQueue (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Turns the transmit queue on or off. With it on,
+		acknowledges and float sample packets are queued and sent
+		by USB_txService while the main loop goes on.
+		
+	Extra:	
+			byte enable
+			
+************************************************************/
+int processTxQueue(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	int temp;	
+	// Checks if this message corresponds to a Tx Queue command
+	if(msg_size != USB_MSG_TXQUEUE_SIZE 
+		&& msg_buffer[0] != USB_MSG_TXQUEUE) {
+			printf("error Tx Queue!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	temp = msg_buffer[1]& 0xff;
+	printf("Tx Queue %d\n", temp);
+
+	if(!temp){
+		USB_txFlush();
+	}
+	USB_txEnabled = temp ? TRUE : FALSE;
+	
+	process_sendAcknowledge(msg_buffer[0]);
+
+	return TRUE;
+}
+
+
+
+/************************************************************
+	Function:	int processTxStatus (unsigned short msg_size, unsigned char * msg_buffer)
+	Argument:	unsigned short msg_size - Payload message size for confirmation
+ 				unsigned char * msg_buffer - Payload buffer with message to process
+	Return:		TRUE if message has been processed without errors.
+				USB_ERROR_FLAG if there was an error
+			
+			
+	Description: Replies with the transmit queue telemetry, instead
+		of an acknowledge. The reply is sent after the queued
+		packets.
+		
+	Extra:	
+			byte clear - non zero clears the counters after the reply.
+			Reply: header, then int depth, int high water mark,
+			int dropped packets and int sent packets, most significant
+			byte first
+			
+************************************************************/
+int processTxStatus(unsigned short msg_size, unsigned char * msg_buffer)
+{
+	unsigned char reply[6+1+4*4];
+	unsigned int values[4];
+	unsigned int packet_size = 1+4*4;
+	int k;
+	
+	// Checks if this message corresponds to a Tx Status command
+	if(msg_size != USB_MSG_TXSTATUS_SIZE 
+		&& msg_buffer[0] != USB_MSG_TXSTATUS) {
+			printf("error Tx Status!\n");//#!
+			return USB_WRONG_CMD;
+	}
+	
+	values[0] = USB_txHead - USB_txTail;
+	values[1] = USB_txHighWater;
+	values[2] = USB_txDropped;
+	values[3] = USB_txSent;
+	if(msg_buffer[1]& 0xff){
+		USB_txHighWater = 0;
+		USB_txDropped = 0;
+		USB_txSent = 0;
+	}
+	
+	reply[0] = USB_START_OF_PACKET_TO_HOST;
+	reply[1] = (packet_size>>24&0xff);
+	reply[2] = (packet_size>>16&0xff);
+	reply[3] = (packet_size>>8&0xff);
+	reply[4] = packet_size&0xff;
+	reply[5] = msg_buffer[0];
+	for(k = 0; k < 4; k++){
+		reply[6+4*k] = (values[k]>>24&0xff);
+		reply[7+4*k] = (values[k]>>16&0xff);
+		reply[8+4*k] = (values[k]>>8&0xff);
+		reply[9+4*k] = values[k]&0xff;
+	}
+	
+	if(USB_writeBuffer(sizeof(reply), reply) == USB_ERROR_FLAG){
+		return USB_ERROR_FLAG;	
+	} 
+
+	return TRUE;
+}
@@ -14,6 +14,12 @@
 
 
 #include "../h/processSignal.h"
+#ifndef __ADSP21000__
+#include <time.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#endif
 
 /**************************************************************
 			EXTERNAL Signal GLOBAL VARIABLES
@@ -25,6 +31,34 @@
 			LOCAL Signal GLOBAL VARIABLES
 ***************************************************************/
 
+// Polyphase decimating low pass filter state
+unsigned int poly_phase_taps;	// Number of taps in each polyphase branch
+unsigned int poly_phase;		// Branch that receives the next input sample
+unsigned int poly_write;		// Delay line position shared by all branches
+float poly_accA, poly_accB;		// Partial sums of the output being computed
+
+// Block demodulation state
+unsigned int block_decim_phase;	// Position of the next decimated output in the next block
+
+// Overlap-save FFT convolution state
+int ols_fill;						// New samples in OLS_in after the filter history
+unsigned int ols_decim_phase;		// Position of the next decimated output in the next segment
+
+// Sliding DFT state
+float dft_sumI, dft_sumQ;			// Sums of the mixed samples in the rings
+float dft_freshI, dft_freshQ;		// Sums of the samples written since the rings last wrapped
+unsigned int dft_pos;				// Ring position of the next sample
+unsigned int dft_count;			// Input samples since the last output
+
+// Demodulation bank state
+int bank_write;					// Delay line position of the newest sample
+unsigned int bank_decim_phase;		// Input samples until the next output
+
+// FIR accelerator offload state
+int fir_acc_fill;			// Next window set to be filled by the core
+int fir_acc_read;			// Next window set to be read back by the core
+unsigned int fir_acc_pending;	// Outputs of the sets handed to the accelerator, not read back yet
+
 
 void Init_FIR();
 
@@ -41,6 +75,109 @@ extern float memProcessedBufferChB[];
 
 
 
+/************************************************************
+	Function:	void fir_pair (float* sampleA_ptr, float* sampleB_ptr, float pm * coeffs2,
+						float dm * states2, int * index, int taps)
+	Argument:	float* sampleA_ptr, sampleB_ptr - Input samples, replaced by the filter outputs
+				float pm * coeffs2 - 2*taps duplicated coefficients (h0,h0,h1,h1,...)
+				float dm * states2 - 4*taps interleaved A/B delay line
+				int * index - Delay line position, updated
+				int taps - Number of filter taps
+	
+	Return:	
+	
+	Description: Filters the A and B samples through the same FIR in lockstep.
+		With the A/B data interleaved the loop runs in SIMD mode: each
+		dual fetch gives the tap to PEx and PEy together with the A and B
+		states, so both channels cost one coefficient fetch and one loop
+		iteration per tap.
+		
+	Extra:	The delay line is written twice (at index and index+taps) so
+		the taps are read from a contiguous block, newest sample first,
+		in the same order as fir().
+		The host build with SSE keeps A and B in the two low lanes, as
+		PEx and PEy, and multiplies two taps at once. The products are
+		still added one tap at a time, so the outputs are bit identical
+		to fir().
+
+************************************************************/
+void fir_pair(float* sampleA_ptr, float* sampleB_ptr, float pm * coeffs2,
+						float dm * states2, int * index, int taps)
+{
+	int k;
+	float accA = 0.0;
+	float accB = 0.0;
+	float dm * x = &states2[2*(*index)];
+#if !defined(__ADSP21000__) && defined(__SSE__)
+	__m128 acc = _mm_setzero_ps();
+	__m128 products;
+	float out[4];
+#endif
+	
+	x[0] = x[2*taps] = *sampleA_ptr;
+	x[1] = x[2*taps+1] = *sampleB_ptr;
+	
+#if !defined(__ADSP21000__) && defined(__SSE__)
+	for(k = 0; k+4 <= 2*taps; k += 4){
+		products = _mm_mul_ps(_mm_loadu_ps(&coeffs2[k]), _mm_loadu_ps(&x[k]));
+		acc = _mm_add_ps(acc, products);
+		acc = _mm_add_ps(acc, _mm_movehl_ps(products, products));
+	}
+	_mm_storeu_ps(out, acc);
+	accA = out[0];
+	accB = out[1];
+	if(k < 2*taps){
+		accA += coeffs2[k]*x[k];
+		accB += coeffs2[k+1]*x[k+1];
+	}
+#else
+#pragma SIMD_for
+	for(k = 0; k < 2*taps; k += 2){
+		accA += coeffs2[k]*x[k];
+		accB += coeffs2[k+1]*x[k+1];
+	}
+#endif
+	
+	*sampleA_ptr = accA;
+	*sampleB_ptr = accB;
+	*index = (*index == 0) ? taps - 1 : *index - 1;
+}
+
+/************************************************************
+	Function:	int Init_FIR_pair (void)
+	Argument:	
+	
+	Return:	TRUE
+	
+	Description: Fills the duplicated coefficient tables of the paired
+		band pass and low pass filters and clears their delay lines.
+		
+	Extra:	
+
+************************************************************/
+int Init_FIR_pair(void)
+{
+	int k;
+	
+	for(k = 0; k < TAPS_FIR; k++){
+		BP_FIR_coeffs2[2*k] = BP_FIR_coeffs2[2*k+1] = BP_FIR_coeffs[k];
+	}
+	for(k = 0; k < 4*TAPS_FIR; k++){
+		FIR_BPstatesAB[k] = 0.0;
+	}
+	FIR_BPindexAB = 0;
+	
+	for(k = 0; k < TAPS_FIR_LP; k++){
+		LP_FIR_coeffs2[2*k] = LP_FIR_coeffs2[2*k+1] = LP_FIR_coeffs[k];
+	}
+	for(k = 0; k < 4*TAPS_FIR_LP; k++){
+		FIR_LPstatesAB[k] = 0.0;
+	}
+	FIR_LPindexAB = 0;
+	
+	return TRUE;
+}
+
 /************************************************************
 	Function:	int signalIIR_bandpassfilter (float* sampleA_ptr,float* sampleB_ptr)
 	Argument:	Pointer to current samples in the sample buffer
@@ -58,8 +195,12 @@ int signalIIR_bandpassfilter(float* sampleA_ptr,float* sampleB_ptr)
 //	*sampleA_ptr = iir(*sampleA_ptr, BP_ACoeffs, BP_BCoeffs, IIR_BPstatesChA, TAPS_IIR);
 //	*sampleB_ptr = iir(*sampleB_ptr, BP_ACoeffs, BP_BCoeffs, IIR_BPstatesChB, TAPS_IIR);
 
+#ifdef DSP_PAIRED_FIR
+	fir_pair(sampleA_ptr, sampleB_ptr, BP_FIR_coeffs2, FIR_BPstatesAB, &FIR_BPindexAB, TAPS_FIR);
+#else
 	*sampleA_ptr = fir(*sampleA_ptr, BP_FIR_coeffs, FIR_BPstatesChA, TAPS_FIR);
 	*sampleB_ptr = fir(*sampleB_ptr, BP_FIR_coeffs, FIR_BPstatesChB, TAPS_FIR);
+#endif
 	
 	return 0;	
 }
@@ -82,8 +223,12 @@ int signalIIR_lowpassfilter(float* sampleA_ptr,float* sampleB_ptr)
 //	*sampleB_ptr = iir(*sampleB_ptr, LP_ACoeffs, LP_BCoeffs, IIR_LPstatesChB, TAPS_IIR);
 
 // FIR #! 22/10/2013
+#ifdef DSP_PAIRED_FIR
+	fir_pair(sampleA_ptr, sampleB_ptr, LP_FIR_coeffs2, FIR_LPstatesAB, &FIR_LPindexAB, TAPS_FIR_LP);
+#else
 	*sampleA_ptr = fir(*sampleA_ptr, LP_FIR_coeffs, FIR_LPstatesChA, TAPS_FIR_LP);
 	*sampleB_ptr = fir(*sampleB_ptr, LP_FIR_coeffs, FIR_LPstatesChB, TAPS_FIR_LP);
+#endif
 
 // BIQUAD #! 22/10/2013
 //	*sampleA_ptr = biquad(*sampleA_ptr, BIQUAD_coeffs, BIQUAD_stateChA, NSECTIONS);
@@ -92,6 +237,220 @@ int signalIIR_lowpassfilter(float* sampleA_ptr,float* sampleB_ptr)
 	return 0;	
 }
 
+/************************************************************
+	Function:	int Init_FIR_LPrate (unsigned int rate_factor)
+	Argument:	unsigned int rate_factor - ADC_FS over the sample rate (1 to ADC_RATE_MAX)
+	
+	Return:	Number of non zero taps.
+	
+	Description: Fills LP_FIR_coeffs with the designed low pass
+		resampled to the running rate, so the cutoff stays the
+		same in Hz. Every new tap sums rate_factor designed taps,
+		h_R[k] = h[R*k] + ... + h[R*k+R-1], zero padded at the end.
+		
+	Extra:	The designed filter is below -70 dB past 1 kHz, so the
+		folding of this resampling stays at that level for rates
+		down to ADC_FS/8. The DC gain is kept.
+
+************************************************************/
+int Init_FIR_LPrate(unsigned int rate_factor)
+{
+	int k, j, taps;
+	float acc;
+	
+	if(rate_factor < 1) rate_factor = 1;
+	taps = (TAPS_FIR_LP + rate_factor - 1)/rate_factor;
+	
+	for(k = 0; k < TAPS_FIR_LP; k++){
+		acc = 0.0;
+		if(k < taps){
+			for(j = 0; j < rate_factor && k*rate_factor+j < TAPS_FIR_LP; j++){
+				acc += LP_FIR_design[k*rate_factor+j];
+			}
+		}
+		LP_FIR_coeffs[k] = acc;
+	}
+	
+	return taps;
+}
+
+/************************************************************
+	Function:	int Init_FIR_LPdecimator (unsigned int decimation)
+	Argument:	unsigned int decimation - Decimation factor M (1 to DECIMATION_MAX)
+	
+	Return:	TRUE
+	
+	Description: Splits LP_FIR_coeffs into M polyphase branches of
+		ceil(TAPS_FIR_LP/M) taps and clears the branch delay lines.
+		
+	Extra:	Branch p holds the taps h[q*M+p], zero padded at the end.
+		POLY_LP_coeffs[p*L+q] = h[q*M+p]
+
+************************************************************/
+int Init_FIR_LPdecimator(unsigned int decimation)
+{
+	int p, q, k;
+	
+	if(decimation < 1) decimation = 1;
+	if(decimation > DECIMATION_MAX) decimation = DECIMATION_MAX;
+	
+	DSP_decimation = decimation;
+	poly_phase_taps = (TAPS_FIR_LP + decimation - 1)/decimation;
+	
+	for(p = 0; p < decimation; p++){
+		for(q = 0; q < poly_phase_taps; q++){
+			k = q*decimation + p;
+			POLY_LP_coeffs[p*poly_phase_taps + q] = (k < TAPS_FIR_LP) ? LP_FIR_coeffs[k] : 0.0;
+		}
+	}
+	
+	for(k = 0; k < 2*TAPS_FIR_LP_POLY; k++){
+		POLY_LPstatesChA[k] = 0.0;
+		POLY_LPstatesChB[k] = 0.0;
+	}
+	
+	poly_phase = 0;
+	poly_write = 0;
+	poly_accA = 0.0;
+	poly_accB = 0.0;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int signalFIR_decimate_lowpass (float* sampleA_ptr,float* sampleB_ptr)
+	Argument:	Pointer to current samples in the sample buffer
+	
+	Return:	TRUE if a decimated output was written to sampleA_ptr and sampleB_ptr,
+		FALSE otherwise.
+	
+	Description: Polyphase decimating version of signalIIR_lowpassfilter.
+		Each input sample is pushed into its polyphase branch and
+		only that branch is convolved, so every sample costs
+		ceil(TAPS_FIR_LP/DSP_decimation) MACs per channel instead of TAPS_FIR_LP.
+		The branch sums add up to one output every DSP_decimation samples.
+		
+	Extra:	Branch delay lines are stored twice (at poly_write and poly_write+L)
+		so the taps are always read from a contiguous block without modulo.
+		Assumes Init_FIR_LPdecimator was called.
+
+************************************************************/
+int signalFIR_decimate_lowpass(float* sampleA_ptr,float* sampleB_ptr)
+{
+	int q;
+	unsigned int L = poly_phase_taps;
+	float pm * coeffs = &POLY_LP_coeffs[poly_phase*L];
+	float dm * statesA = &POLY_LPstatesChA[poly_phase*2*L + poly_write];
+	float dm * statesB = &POLY_LPstatesChB[poly_phase*2*L + poly_write];
+	float accA = 0.0;
+	float accB = 0.0;
+	
+	statesA[0] = statesA[L] = *sampleA_ptr;
+	statesB[0] = statesB[L] = *sampleB_ptr;
+	
+	for(q = 0; q < L; q++){
+		accA += coeffs[q]*statesA[q];
+		accB += coeffs[q]*statesB[q];
+	}
+	poly_accA += accA;
+	poly_accB += accB;
+	
+	if(poly_phase != 0){
+		poly_phase--;
+		return FALSE;
+	}
+	
+	// Every branch has contributed. Output the sample and advance the delay lines.
+	*sampleA_ptr = poly_accA;
+	*sampleB_ptr = poly_accB;
+	poly_accA = 0.0;
+	poly_accB = 0.0;
+	
+	poly_phase = DSP_decimation - 1;
+	poly_write = (poly_write == 0) ? L - 1 : poly_write - 1;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	void signal_SinCos (unsigned int phase, float * sin_ptr, float * cos_ptr)
+	Argument:	unsigned int phase - Software LO phase accumulator (2^32 = 360 degrees)
+				float * sin_ptr, cos_ptr - Sine and cosine of the phase
+	
+	Return:	
+	
+	Description: Software LO lookup in the quarter wave table. The two top
+		bits of the phase give the quadrant and the next SINE_QUARTER_BITS
+		the table index. The sine and cosine are read from the index and
+		its mirror, so no 90 degree offset or modulo is needed.
+		
+	Extra:	With SINE_INTERPOLATE the remaining phase bits interpolate
+		linearly between table entries.
+
+************************************************************/
+void signal_SinCos(unsigned int phase, float * sin_ptr, float * cos_ptr)
+{
+	unsigned int i = (phase>>SINE_QUARTER_SHIFT)&(SINE_QUARTER_SIZE-1);
+	float s = sine_quarter_lut[i];
+	float c = sine_quarter_lut[SINE_QUARTER_SIZE-i];
+#ifdef SINE_INTERPOLATE
+	float f = (phase&SINE_FRACTION_MASK)*(1.0/(SINE_FRACTION_MASK+1.0));
+	
+	s += f*(sine_quarter_lut[i+1]-s);
+	c += f*(sine_quarter_lut[SINE_QUARTER_SIZE-1-i]-c);
+#endif
+	
+	switch(phase>>30){
+		case 0:
+			*sin_ptr = s;
+			*cos_ptr = c;
+			break;
+		case 1:
+			*sin_ptr = c;
+			*cos_ptr = -s;
+			break;
+		case 2:
+			*sin_ptr = -s;
+			*cos_ptr = -c;
+			break;
+		default:
+			*sin_ptr = -c;
+			*cos_ptr = s;
+			break;
+	}
+}
+
+/************************************************************
+	Function:	void signal_RotatorSeed (unsigned int phase, unsigned int inc,
+						float * cos_ptr, float * sin_ptr, float * dcos_ptr, float * dsin_ptr)
+	Argument:	unsigned int phase - Software LO phase accumulator (2^32 = 360 degrees)
+				unsigned int inc - Phase increment per sample
+				float * cos_ptr, sin_ptr - Rotator start value
+				float * dcos_ptr, dsin_ptr - Rotation per sample
+	
+	Return:	
+	
+	Description: Seeds the complex rotator LO of the block paths (LO_ROTATOR).
+		The rotator advances by one complex multiply per sample and is
+		renormalized every LO_RENORM samples. Reseeding from the 32 bit
+		phase accumulator at each block keeps it phase coherent with the
+		table LO.
+		
+	Extra:	
+
+************************************************************/
+void signal_RotatorSeed(unsigned int phase, unsigned int inc,
+						float * cos_ptr, float * sin_ptr, float * dcos_ptr, float * dsin_ptr)
+{
+	float angle = phase*(2*DSP_PI/4294967296.0);
+	float step = inc*(2*DSP_PI/4294967296.0);
+	
+	*cos_ptr = cosf(angle);
+	*sin_ptr = sinf(angle);
+	*dcos_ptr = cosf(step);
+	*dsin_ptr = sinf(step);
+}
+
 /************************************************************
 	Function:	int signal_QuadratureDemodulation_InternalLO (float* bufferA,float* bufferB, int total_samples)
 	Argument:	
@@ -111,25 +470,27 @@ int signal_QuadratureDemodulation_InternalLO (float* bufferA,float* bufferB, int
 	float sampleA;
 	float sampleB;
 	float sampleC;
+	float lo_sin, lo_cos;
 //	static float aux[MAX_SAMPLES_BUFFER_SIZE];
 
 	// internal local oscillator incrementation
-	unsigned int inc_ilo = (DDS_inc_Fex - DDS_inc_Flo)*1200;// >> 20;
+	unsigned int inc_ilo = (DDS_inc_Fex - DDS_inc_Flo)*1200*ADC_rateFactor;// >> 20;
 	
 	unsigned int inc_ilo_accA = 0;
 //	unsigned int inc_ilo_accB = SINE_VALUES_SIZE/4;
 	
 	for (index = 0; index<total_samples;index++){
 		sampleA = bufferA[index];
+		signal_SinCos(inc_ilo_accA, &lo_sin, &lo_cos);
 
 		// Sample * Sine
-		bufferB[index] = 4*sampleA*sine_values_lut[((inc_ilo_accA>>20))];
+		bufferB[index] = 4*sampleA*lo_sin;
 
 //		bufferB[index] = 1*sine_values_lut[((inc_ilo_accA>>20)%SINE_VALUES_SIZE)];
 
 
 		// Sample * CoSine
-		bufferA[index] = 4*sampleA*sine_values_lut[((inc_ilo_accA>>20)+SINE_VALUES_90_DELAY)%SINE_VALUES_SIZE];
+		bufferA[index] = 4*sampleA*lo_cos;
 
 		inc_ilo_accA = inc_ilo_accA + inc_ilo;
 
@@ -142,60 +503,1097 @@ int signal_QuadratureDemodulation_InternalLO (float* bufferA,float* bufferB, int
 
 	}	
 	
-	return 0;	
+	return 0;	
+}
+
+
+/************************************************************
+	Function:	int signal_QuadratureDemodulation_InternalLO_PtbyPt (float* bufferA,float* bufferB, int total_samples)
+	Argument:	
+	
+	Return:	TRUE if bufferA[index] and bufferB[index] hold a new demodulated sample.
+			FALSE if the decimating low pass filter has not produced an output yet.
+	
+	Description: Processes the quadrature demodulation of the IF mode using an internal local oscillator
+		and the samples from channel A corresponding to the probe response data.
+		This demodulation occurs in run time during acquisition
+		It assumes iDDS_lut_inc and iDDS_lut_acc were set.
+	Extra:	With DSP_decimation > 1 the low pass runs as a polyphase decimator
+		and only one output is produced every DSP_decimation samples.
+
+************************************************************/
+int signal_QuadratureDemodulation_InternalLO_PtbyPt (float* bufferA,float* bufferB,int index)
+{
+
+	//int index = 0;
+	float sampleA;
+	float sampleB;
+	float sampleC;
+	float lo_sin, lo_cos;
+//	static float aux[MAX_SAMPLES_BUFFER_SIZE];
+
+
+//	unsigned int inc_ilo_accB = SINE_VALUES_SIZE/4;
+	
+		sampleA = bufferA[index];
+		signal_SinCos(iDDS_lut_acc, &lo_sin, &lo_cos);
+
+		// Sample * Sine
+		//Imaginary
+		bufferB[index] = 4*sampleA*lo_sin;
+
+//		bufferB[index] = 1*sine_values_lut[((inc_ilo_accA>>20)%SINE_VALUES_SIZE)];
+
+
+		// Sample * CoSine
+		// Real values
+		bufferA[index] = 4*sampleA*lo_cos;
+
+		iDDS_lut_acc = iDDS_lut_acc + iDDS_lut_inc;
+
+		//inc_ilo_accB = ((inc_ilo_accA + inc_ilo))+SINE_VALUES_SIZE/4)%SINE_VALUES_SIZE;
+	//	printf("inc: %d\n", inc_ilo_accA>>20);	
+		if(DSP_decimation > 1){
+			return signalFIR_decimate_lowpass(&bufferA[index], &bufferB[index]);
+		}
+		signalIIR_lowpassfilter(&bufferA[index], &bufferB[index]);
+
+	
+	return TRUE;	
+}
+
+
+
+/************************************************************
+	Function:	int Init_DemodulateBlock (void)
+	Argument:	
+	
+	Return:	TRUE
+	
+	Description: Clears the filter history kept in front of the
+		block buffers and restarts the decimation phase.
+		
+	Extra:	
+
+************************************************************/
+int Init_DemodulateBlock(void)
+{
+	int k;
+	
+	for(k = 0; k < TAPS_FIR_LP-1; k++){
+		DSP_blockI[k] = 0.0;
+		DSP_blockQ[k] = 0.0;
+	}
+	block_decim_phase = 0;
+	DSP_blockIndex = 0;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int signal_MixBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferI, float * bufferQ)
+	Argument:	unsigned int * raw_buffer - Ring of MAXSAMPLES raw SPORT3 words
+				unsigned int start - Index of the first sample of the block in the ring
+				unsigned int block_size - Number of samples in the block
+				float * bufferI, bufferQ - Mixed real and imaginary samples
+	
+	Return:	block_size
+	
+	Description: Converts channel A of a block of raw samples to volts
+		and mixes it with the internal local oscillator.
+		
+	Extra:	Uses and updates iDDS_lut_acc. With LO_ROTATOR the LO is a
+		complex rotator reseeded from iDDS_lut_acc at every block.
+
+************************************************************/
+int signal_MixBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferI, float * bufferQ)
+{
+	int i;
+	unsigned int acc = iDDS_lut_acc;
+	float sample, lo_sin, lo_cos;
+#ifdef LO_ROTATOR
+	float lo_dcos, lo_dsin, t;
+	
+	signal_RotatorSeed(acc, iDDS_lut_inc, &lo_cos, &lo_sin, &lo_dcos, &lo_dsin);
+	for(i = 0; i < block_size; i++){
+		sample = ADC_RAW_VOLTS_B(raw_buffer[(start+i)&(MAXSAMPLES-1)]);
+		// Sample * Sine - Imaginary
+		bufferQ[i] = 4*sample*lo_sin;
+		// Sample * CoSine - Real
+		bufferI[i] = 4*sample*lo_cos;
+		// Rotates the LO by one step
+		t = lo_cos*lo_dcos - lo_sin*lo_dsin;
+		lo_sin = lo_sin*lo_dcos + lo_cos*lo_dsin;
+		lo_cos = t;
+		if((i&(LO_RENORM-1)) == LO_RENORM-1){
+			t = 1.5 - 0.5*(lo_cos*lo_cos + lo_sin*lo_sin);
+			lo_cos *= t;
+			lo_sin *= t;
+		}
+	}
+	acc += block_size*iDDS_lut_inc;
+#else
+	
+	for(i = 0; i < block_size; i++){
+		sample = ADC_RAW_VOLTS_B(raw_buffer[(start+i)&(MAXSAMPLES-1)]);
+		signal_SinCos(acc, &lo_sin, &lo_cos);
+		// Sample * Sine - Imaginary
+		bufferQ[i] = 4*sample*lo_sin;
+		// Sample * CoSine - Real
+		bufferI[i] = 4*sample*lo_cos;
+		acc += iDDS_lut_inc;
+	}
+#endif
+	iDDS_lut_acc = acc;
+	
+	return block_size;
+}
+
+/************************************************************
+	Function:	int signal_DemodulateBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	unsigned int * raw_buffer - Ring of MAXSAMPLES raw SPORT3 words
+				unsigned int start - Index of the first sample of the block in the ring
+				unsigned int block_size - Number of samples in the block (up to DSP_BLOCK_MAX)
+				float * bufferA, bufferB - Real and imaginary outputs
+	
+	Return:	Number of output samples written to bufferA and bufferB.
+	
+	Description: Block version of signal_QuadratureDemodulation_InternalLO_PtbyPt.
+		The block goes through three tight loops:
+			1. Conversion to volts and mixing with the internal LO
+			2. Low pass filter, computed only for the samples kept by DSP_decimation
+			3. Copy of the last TAPS_FIR_LP-1 mixed samples as history for the next block
+		
+	Extra:	Uses and updates iDDS_lut_acc like the point by point version.
+		Outputs are taken at the same samples as signalFIR_decimate_lowpass.
+
+************************************************************/
+int signal_DemodulateBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	int i, k;
+	int outputs = 0;
+	float sumI, sumQ;
+	float dm * blockI = &DSP_blockI[TAPS_FIR_LP-1];
+	float dm * blockQ = &DSP_blockQ[TAPS_FIR_LP-1];
+	
+	// 1. Conversion and mixing
+	signal_MixBlock(raw_buffer, start, block_size, blockI, blockQ);
+	
+	// 2. Low pass filter at the decimated output rate
+	if(DSP_filterEngine == DSP_ENGINE_OLS){
+		return signal_OLS_filter(blockI, blockQ, block_size, bufferA, bufferB);
+	}
+	for(i = block_decim_phase; i < block_size; i += DSP_decimation){
+		sumI = 0.0;
+		sumQ = 0.0;
+		for(k = 0; k < TAPS_FIR_LP; k++){
+			sumI += LP_FIR_coeffs[k]*blockI[i-k];
+			sumQ += LP_FIR_coeffs[k]*blockQ[i-k];
+		}
+		bufferA[outputs] = sumI;
+		bufferB[outputs] = sumQ;
+		outputs++;
+	}
+	block_decim_phase = i - block_size;
+	
+	// 3. Filter history for the next block
+	for(k = 0; k < TAPS_FIR_LP-1; k++){
+		DSP_blockI[k] = DSP_blockI[block_size+k];
+		DSP_blockQ[k] = DSP_blockQ[block_size+k];
+	}
+	
+	return outputs;
+}
+
+/************************************************************
+	Function:	int signal_ConvertBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	Same as signal_DemodulateBlock
+	
+	Return:	Number of output samples written to bufferA and bufferB.
+	
+	Description: IQ mode block stage. Converts both ADC channels to volts.
+		
+	Extra:	Oversampled runs keep channel A in ADC_osrRingA.
+
+************************************************************/
+int signal_ConvertBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	int i;
+	unsigned int sample;
+	
+	for(i = 0; i < block_size; i++){
+		sample = raw_buffer[(start+i)&(MAXSAMPLES-1)];
+		bufferA[i] = ADC_RAW_VOLTS_B(sample);
+		if(ADC_osr > 1){
+			bufferB[i] = ADC_OSR_VOLTS_A(ADC_osrRingA[(start+i)&(MAXSAMPLES-1)]);
+		}else{
+			bufferB[i] = (((int)sample&0xffff)-CAL_CHA_DECIMAL)*2.5/65536;
+		}
+	}
+	
+	return block_size;
+}
+
+/************************************************************
+	Function:	int signal_ConvertRawCapture (unsigned int sample_size)
+	Argument:	unsigned int sample_size - Number of packed words in AR_bufferChA
+	
+	Return:	Number of samples converted.
+	
+	Description: Deferred conversion of a packed raw capture. Channel
+		A is converted in place over the packed words and channel
+		B goes to AR_bufferChB.
+		
+	Extra:	Same arithmetic as the ADC interrupt: the scale factor
+		is a power of two times 2.5, so the volts are identical.
+
+************************************************************/
+int signal_ConvertRawCapture(unsigned int sample_size)
+{
+	int i;
+	unsigned int * raw = (unsigned int*)AR_bufferChA;
+	float scale = RAW_VOLTS_PER_LSB;
+	
+	if(sample_size > MAX_SAMPLES_BUFFER_SIZE){
+		sample_size = MAX_SAMPLES_BUFFER_SIZE;
+	}
+	
+#pragma SIMD_for
+	for(i = 0; i < sample_size; i++){
+		AR_bufferChB[i] = (((int)raw[i]&0xffff)-CAL_CHA_DECIMAL)*scale;
+		AR_bufferChA[i] = (((int)(raw[i]>>16)&0xffff)-CAL_CHB_DECIMAL)*scale;
+	}
+	
+	return sample_size;
+}
+
+/************************************************************
+	Function:	float signal_EncodeScale (unsigned int sample_size, float * bufferA, float * bufferB, int encoding)
+	Argument:	unsigned int sample_size - Samples per channel
+				float * bufferA, * bufferB - Samples of the packet
+				int encoding - ENCODE_INT16 or ENCODE_INT24
+	
+	Return:	Value of one LSB of the encoded samples.
+	
+	Description: Per packet scale: the largest magnitude of both
+		channels maps to the largest code.
+		
+	Extra:	An all zero packet gets a scale of 1.
+
+************************************************************/
+float signal_EncodeScale(unsigned int sample_size, float * bufferA, float * bufferB, int encoding)
+{
+	int i;
+	float peak = 0.0;
+	
+	for(i = 0; i < sample_size; i++){
+		peak = fmaxf(peak, fabsf(bufferA[i]));
+		peak = fmaxf(peak, fabsf(bufferB[i]));
+	}
+	if(peak == 0.0){
+		return 1.0;
+	}
+	return peak/(encoding == ENCODE_INT24 ? 8388607.0 : 32767.0);
+}
+
+/************************************************************
+	Function:	int signal_EncodeWords (unsigned int sample_size, int encoding)
+	Argument:	unsigned int sample_size - Samples of one channel
+				int encoding - ENCODE_FLOAT32, ENCODE_INT16 or ENCODE_INT24
+	
+	Return:	Number of 32 bit words the encoded channel takes.
+	
+	Description: The last word is zero padded.
+		
+	Extra:	
+
+************************************************************/
+int signal_EncodeWords(unsigned int sample_size, int encoding)
+{
+	if(encoding == ENCODE_INT16){
+		return (sample_size+1)/2;
+	}else if(encoding == ENCODE_INT24){
+		return (3*sample_size+3)/4;
+	}
+	return sample_size;
+}
+
+/************************************************************
+	Function:	int signal_EncodeSamples (unsigned int sample_size, float * buffer, float inv_scale, int encoding)
+	Argument:	unsigned int sample_size - Samples to encode, up to ENCODE_CHUNK
+				float * buffer - Samples
+				float inv_scale - 1/signal_EncodeScale
+				int encoding - ENCODE_INT16 or ENCODE_INT24
+	
+	Return:	Number of words written to ENC_packed.
+	
+	Description: Rounds the samples to the nearest code in
+		ENC_quantized, then packs the codes into ENC_packed as a
+		little endian byte stream: two int16 or four int24 per
+		two or three words.
+		
+	Extra:	Both loops vectorize. Only the last chunk of a channel
+		may have a partial word, zero padded.
+		The peak times inv_scale can land just above the largest
+		code in float, so the values are clamped to +-32767 or
+		+-(2^23-1) before rounding: the peak never wraps.
+
+************************************************************/
+int signal_EncodeSamples(unsigned int sample_size, float * buffer, float inv_scale, int encoding)
+{
+	int i, k;
+	float x;
+	float limit = (encoding == ENCODE_INT24) ? 8388607.0 : 32767.0;
+	int * q = ENC_quantized;
+	
+	if(sample_size > ENCODE_CHUNK){
+		sample_size = ENCODE_CHUNK;
+	}
+	
+#pragma SIMD_for
+	for(i = 0; i < sample_size; i++){
+		x = fminf(fmaxf(buffer[i]*inv_scale, -limit), limit);
+		q[i] = (int)(x < 0.0 ? x - 0.5 : x + 0.5);
+	}
+	for(i = sample_size; i < ENCODE_CHUNK && (i & 3); i++){
+		q[i] = 0;
+	}
+	
+	if(encoding == ENCODE_INT16){
+#pragma SIMD_for
+		for(k = 0; k < (sample_size+1)/2; k++){
+			ENC_packed[k] = (q[2*k]&0xffff) | (q[2*k+1]<<16);
+		}
+	}else{
+#pragma SIMD_for
+		for(k = 0; k < (sample_size+3)/4; k++){
+			ENC_packed[3*k] = (q[4*k]&0xffffff) | (q[4*k+1]<<24);
+			ENC_packed[3*k+1] = ((q[4*k+1]>>8)&0xffff) | (q[4*k+2]<<16);
+			ENC_packed[3*k+2] = ((q[4*k+2]>>16)&0xff) | (q[4*k+3]<<8);
+		}
+	}
+	
+	return signal_EncodeWords(sample_size, encoding);
+}
+
+/************************************************************
+	Function:	int signal_DeltaBlock (unsigned int block_size, unsigned int * buffer, unsigned int previous)
+	Argument:	unsigned int block_size - Words, up to CODEC_BLOCK
+				unsigned int * buffer - Words to code, float bit patterns
+				unsigned int previous - Word before buffer[0]
+	
+	Return:	Bits needed by the largest code of the block, 0 to 32.
+	
+	Description: Delta and zig-zag stage of the lossless codec.
+		ENC_quantized gets the zig-zag code of the difference of
+		each word to the one before, modulo 2^32, so small steps of
+		either sign give small codes.
+		
+	Extra:	Differences of the bit patterns are exact, so decoding
+		gives back the same floats.
+
+************************************************************/
+int signal_DeltaBlock(unsigned int block_size, unsigned int * buffer, unsigned int previous)
+{
+	int i, width;
+	int delta;
+	unsigned int used = 0;
+	unsigned int * code = (unsigned int*)ENC_quantized;
+	
+	delta = (int)(buffer[0] - previous);
+	code[0] = (delta<<1) ^ (delta>>31);
+#pragma SIMD_for
+	for(i = 1; i < block_size; i++){
+		delta = (int)(buffer[i] - buffer[i-1]);
+		code[i] = (delta<<1) ^ (delta>>31);
+	}
+	for(i = 0; i < block_size; i++){
+		used |= code[i];
+	}
+	for(width = 0; used; width++){
+		used >>= 1;
+	}
+	
+	return width;
+}
+
+/************************************************************
+	Function:	int signal_ProcessRawBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	Same as signal_DemodulateBlock
+	
+	Return:	Number of values written to bufferA and bufferB.
+	
+	Description: Runs the block stage of the current mode: bank,
+		IF demodulation, sliding DFT or IQ conversion.
+		
+	Extra:	
+
+************************************************************/
+int signal_ProcessRawBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	if(BANK_active){
+		return signal_BankBlock(raw_buffer, start, block_size, bufferA, bufferB);
+	}else if(OpMode == MODE_IF){
+		return signal_DemodulateBlock(raw_buffer, start, block_size, bufferA, bufferB);
+	}else if(OpMode == MODE_DFT){
+		return signal_DFTBlock(raw_buffer, start, block_size, bufferA, bufferB);
+	}
+	return signal_ConvertBlock(raw_buffer, start, block_size, bufferA, bufferB);
+}
+
+/************************************************************
+	Function:	unsigned int signal_MaxOutputs (unsigned int block_size)
+	Argument:	unsigned int block_size - Raw samples of the next block
+	
+	Return:	Most values signal_ProcessRawBlock can write for the block,
+		outputs still held by the filter (signal_OLS_flush) included.
+	
+	Description: Lets the callers check a block fits in the output
+		buffers before it is processed.
+		
+	Extra:	
+
+************************************************************/
+unsigned int signal_MaxOutputs(unsigned int block_size)
+{
+	unsigned int first, samples;
+	
+	if(BANK_active){
+		// The next output is DSP_decimation-bank_decim_phase samples away, or 0
+		first = bank_decim_phase ? DSP_decimation - bank_decim_phase : 0;
+		return (block_size > first) ? BANK_lanes*((block_size-first+DSP_decimation-1)/DSP_decimation) : 0;
+	}else if(OpMode == MODE_IF){
+		first = block_decim_phase;
+		samples = block_size;
+		if(DSP_filterEngine == DSP_ENGINE_OLS){
+			first = ols_decim_phase;
+			samples += ols_fill;
+		}
+		return (samples > first) ? (samples-first+DSP_decimation-1)/DSP_decimation : 0;
+	}else if(OpMode == MODE_DFT){
+		return (dft_count+block_size)/DFT_outputRate;
+	}
+	return block_size;
+}
+
+/************************************************************
+	Function:	void DSP_ProcessOverflow (void)
+	Argument:	
+	
+	Return:	
+	
+	Description: Ends a block mode run whose next outputs would not
+		fit in the sample buffers. Sampling stops and the raw samples
+		not processed yet are dropped, so the run finishes on the
+		outputs already written.
+		
+	Extra:	Counted in DSP_outputOverflows.
+
+************************************************************/
+void DSP_ProcessOverflow(void)
+{
+	ADC_StopSampling();
+	AR_rawFinished = TRUE;
+	AR_rawTotal = AR_rawIndex;
+	DSP_blockIndex = AR_rawIndex;
+	DSP_outputOverflows++;
+}
+
+/************************************************************
+	Function:	int DSP_ProcessBlocks (void)
+	Argument:	
+	
+	Return:	TRUE if the acquisition run was completed by this call.
+	
+	Description: Called from the main loop in block mode (DSP_blockSize > 0).
+		Processes every full block of raw samples stored by the ADC
+		interrupt and appends the results to AR_bufferChA/AR_bufferChB.
+		Once the interrupt has stored AR_rawTotal samples the last
+		partial block is processed and the acquisition run finishes.
+		
+	Extra:	AR_bufferIndex is left on the last sample, as in the
+		point by point mode. A run that would write more than
+		MAX_SAMPLES_BUFFER_SIZE outputs ends early, see DSP_ProcessOverflow.
+
+************************************************************/
+int DSP_ProcessBlocks(void)
+{
+	unsigned int available, block;
+	int outputs;
+	
+	if(DSP_firOffloadActive){
+		return DSP_ProcessBlocksFIR();
+	}
+	
+	available = AR_rawIndex - DSP_blockIndex;
+	
+	while(available >= DSP_blockSize || (AR_rawFinished && available > 0)){
+		block = (available < DSP_blockSize) ? available : DSP_blockSize;
+		
+		// A block that could write past the sample buffers ends the run
+		if(AR_bufferIndex + signal_MaxOutputs(block) > MAX_SAMPLES_BUFFER_SIZE){
+			DSP_ProcessOverflow();
+			available = 0;
+			break;
+		}
+		
+		outputs = signal_ProcessRawBlock(SAMPLES_MEMORY, DSP_blockIndex, block,
+					&AR_bufferChA[AR_bufferIndex], &AR_bufferChB[AR_bufferIndex]);
+		AR_bufferIndex += outputs;
+		DSP_blockIndex += block;
+		available = AR_rawIndex - DSP_blockIndex;
+	}
+	
+	if(AR_rawFinished && available == 0){
+		AR_rawFinished = FALSE;
+		if(OpMode == MODE_IF && DSP_filterEngine == DSP_ENGINE_OLS && BANK_active == FALSE){
+			AR_bufferIndex += signal_OLS_flush(&AR_bufferChA[AR_bufferIndex], &AR_bufferChB[AR_bufferIndex]);
+		}
+		if(AR_bufferIndex > 0) AR_bufferIndex--;
+		ADC_FinishedAR();
+		return TRUE;
+	}
+	
+	return FALSE;
+}
+
+/************************************************************
+	Function:	int DSP_ProcessFullBuffer (void)
+	Argument:	
+	
+	Return:	TRUE if a buffer was processed.
+	
+	Description: Continuous block mode. Demodulates the ping-pong
+		buffer released by ADC_SwapBuffer, in blocks of DSP_blockSize,
+		sends the results with the buffer sequence number and hands
+		the buffer back to the ADC interrupt.
+		
+	Extra:	The filter states carry over from one buffer to the next,
+		so consecutive buffers give a gapless output. A jump in the
+		sequence number tells the host that buffers were dropped.
+		Once sampling stops, the last partial buffer is released and
+		the overlap-save filter is flushed into it. If the run stopped
+		on a buffer boundary with outputs still held by the filter, an
+		empty last buffer carries them.
+
+************************************************************/
+int DSP_ProcessFullBuffer(void)
+{
+	unsigned int start, block;
+	int outputs = 0;
+	
+	if(ADC_sampling == FALSE && adc_sample_buffer_full == 0
+			&& (samples_memory_index > 0 || signal_MaxOutputs(0) > 0)){
+		ADC_SwapBuffer();
+	}
+	if(adc_sample_buffer_full == 0){
+		return FALSE;
+	}
+	
+	for(start = 0; start < adc_sample_buffer_full_number_of_samples; start += block){
+		block = adc_sample_buffer_full_number_of_samples - start;
+		if(block > DSP_blockSize) block = DSP_blockSize;
+		outputs += signal_ProcessRawBlock(adc_sample_buffer_full_ptr, start, block,
+					&AR_bufferChA[outputs], &AR_bufferChB[outputs]);
+	}
+	
+	// Last buffer of the run: the overlap-save filter holds the last outputs
+	if(ADC_sampling == FALSE && samples_memory_index == 0
+			&& OpMode == MODE_IF && DSP_filterEngine == DSP_ENGINE_OLS){
+		outputs += signal_OLS_flush(&AR_bufferChA[outputs], &AR_bufferChB[outputs]);
+	}
+	
+	if(DSP_timestamps){
+		process_sendTimestamp(TIMESTAMP_BLOCK, adc_sample_buffer_sequence, adc_sample_buffer_time);
+	}
+	process_sendBlockData(adc_sample_buffer_sequence, outputs, AR_bufferChA, AR_bufferChB);
+	adc_sample_buffer_full = 0;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int Init_DFT (void)
+	Argument:	
+	
+	Return:	
+	
+	Description: Makes the requested window and output rate active and
+		clears the sliding DFT rings and sums before an acquisition run
+		in MODE_DFT.
+		
+	Extra:	DFT_window is limited to 1..DFT_WINDOW_MAX and
+		DFT_outputRate to at least 1.
+
+************************************************************/
+int Init_DFT(void)
+{
+	int k;
+	
+	DFT_window = DFT_windowRequest;
+	DFT_outputRate = DFT_outputRateRequest;
+	if(DFT_window < 1) DFT_window = 1;
+	if(DFT_window > DFT_WINDOW_MAX) DFT_window = DFT_WINDOW_MAX;
+	if(DFT_outputRate < 1) DFT_outputRate = 1;
+	
+	for(k = 0; k < DFT_window; k++){
+		DFT_ringI[k] = 0.0;
+		DFT_ringQ[k] = 0.0;
+	}
+	dft_sumI = 0.0;
+	dft_sumQ = 0.0;
+	dft_freshI = 0.0;
+	dft_freshQ = 0.0;
+	dft_pos = 0;
+	dft_count = 0;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int signal_DFT_sample (float sample, float * sampleA_ptr, float * sampleB_ptr)
+	Argument:	float sample - IF sample in volts
+				float * sampleA_ptr, sampleB_ptr - Real and imaginary output
+	
+	Return:	TRUE if a new output was written.
+	
+	Description: Single bin sliding DFT at the LO frequency. The sample is
+		mixed with the internal LO, as in the FIR path, and the bin is the
+		mean of the last DFT_window mixed samples, updated by adding the
+		new sample and subtracting the one leaving the window.
+		
+	Extra:	Float rounding of the running sum is bounded by replacing it,
+		every time the rings wrap, with the sum of the samples written
+		since the previous wrap, which is then the exact window sum.
+		Until the window has filled, outputs include the zero history.
+
+************************************************************/
+int signal_DFT_sample(float sample, float * sampleA_ptr, float * sampleB_ptr)
+{
+	float mixI, mixQ, lo_sin, lo_cos;
+	
+	signal_SinCos(iDDS_lut_acc, &lo_sin, &lo_cos);
+	mixQ = 4*sample*lo_sin;
+	mixI = 4*sample*lo_cos;
+	iDDS_lut_acc = iDDS_lut_acc + iDDS_lut_inc;
+	
+	dft_sumI += mixI - DFT_ringI[dft_pos];
+	dft_sumQ += mixQ - DFT_ringQ[dft_pos];
+	dft_freshI += mixI;
+	dft_freshQ += mixQ;
+	DFT_ringI[dft_pos] = mixI;
+	DFT_ringQ[dft_pos] = mixQ;
+	
+	if(++dft_pos == DFT_window){
+		dft_pos = 0;
+		dft_sumI = dft_freshI;
+		dft_sumQ = dft_freshQ;
+		dft_freshI = 0.0;
+		dft_freshQ = 0.0;
+	}
+	
+	if(++dft_count < DFT_outputRate){
+		return FALSE;
+	}
+	dft_count = 0;
+	*sampleA_ptr = dft_sumI/DFT_window;
+	*sampleB_ptr = dft_sumQ/DFT_window;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int signal_QuadratureDemodulation_DFT_PtbyPt (float* bufferA,float* bufferB,int index)
+	Argument:	float* bufferA - IF sample at index, real output
+				float* bufferB - Imaginary output
+				int index - Acquisition run position
+	
+	Return:	TRUE if a new output was written at index.
+	
+	Description: MODE_DFT counterpart of signal_QuadratureDemodulation_InternalLO_PtbyPt,
+		called from the ADC interrupt.
+		
+	Extra:	
+
+************************************************************/
+int signal_QuadratureDemodulation_DFT_PtbyPt (float* bufferA,float* bufferB,int index)
+{
+	return signal_DFT_sample(bufferA[index], &bufferA[index], &bufferB[index]);
+}
+
+/************************************************************
+	Function:	int signal_DFTBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	Same as signal_DemodulateBlock
+	
+	Return:	Number of output samples written to bufferA and bufferB.
+	
+	Description: MODE_DFT block stage.
+		
+	Extra:	
+
+************************************************************/
+int signal_DFTBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	int i;
+	int outputs = 0;
+	float sample;
+	
+	for(i = 0; i < block_size; i++){
+		sample = ADC_RAW_VOLTS_B(raw_buffer[(start+i)&(MAXSAMPLES-1)]);
+		outputs += signal_DFT_sample(sample, &bufferA[outputs], &bufferB[outputs]);
+	}
+	
+	return outputs;
+}
+
+/************************************************************
+	Function:	int Init_Bank (void)
+	Argument:	
+	
+	Return:	
+	
+	Description: Clears the demodulation bank delay line and resets the
+		lane LOs before an acquisition run.
+		
+	Extra:	The lane increments are set by processBank.
+
+************************************************************/
+int Init_Bank(void)
+{
+	int k;
+	
+	for(k = 0; k < 2*TAPS_FIR_LP*BANK_STRIDE; k++){
+		BANK_states[k] = 0.0;
+	}
+	for(k = 0; k < BANK_LANES_MAX; k++){
+		BANK_lut_inc[k] = BANK_if_inc[k]*ADC_rateFactor;
+		BANK_lut_acc[k] = 0;
+	}
+	bank_write = 0;
+	bank_decim_phase = 0;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	int signal_BankBlock (unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	Same as signal_DemodulateBlock
+	
+	Return:	Number of values written to bufferA and bufferB
+		(BANK_lanes per output sample).
+	
+	Description: Demodulates BANK_lanes IF frequencies in one pass over
+		the block. Every sample is mixed with each lane LO into the shared
+		delay line and, every DSP_decimation samples, the low pass is
+		applied to all lanes at once. Outputs go out lane by lane:
+		bufferA[n*BANK_lanes+lane].
+		
+	Extra:	The delay line is written twice, as in fir_pair, so the taps
+		of every lane are read from one contiguous block.
+
+************************************************************/
+int signal_BankBlock(unsigned int * raw_buffer, unsigned int start, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	int i, t, k;
+	int outputs = 0;
+	int width = 2*BANK_lanes;
+	float sample, c, lo_sin, lo_cos;
+	float acc[BANK_STRIDE];
+	float dm * x;
+#ifdef LO_ROTATOR
+	float rot_cos[BANK_LANES_MAX], rot_sin[BANK_LANES_MAX];
+	float rot_dcos[BANK_LANES_MAX], rot_dsin[BANK_LANES_MAX];
+	float g;
+	
+	for(k = 0; k < BANK_lanes; k++){
+		signal_RotatorSeed(BANK_lut_acc[k], BANK_lut_inc[k],
+					&rot_cos[k], &rot_sin[k], &rot_dcos[k], &rot_dsin[k]);
+		BANK_lut_acc[k] += block_size*BANK_lut_inc[k];
+	}
+#endif
+	
+	for(i = 0; i < block_size; i++){
+		sample = ADC_RAW_VOLTS_B(raw_buffer[(start+i)&(MAXSAMPLES-1)]);
+		
+		// Mix with every lane LO
+		x = &BANK_states[bank_write*BANK_STRIDE];
+#ifdef LO_ROTATOR
+		for(k = 0; k < BANK_lanes; k++){
+			x[2*k] = x[TAPS_FIR_LP*BANK_STRIDE+2*k] = 4*sample*rot_cos[k];
+			x[2*k+1] = x[TAPS_FIR_LP*BANK_STRIDE+2*k+1] = 4*sample*rot_sin[k];
+			g = rot_cos[k]*rot_dcos[k] - rot_sin[k]*rot_dsin[k];
+			rot_sin[k] = rot_sin[k]*rot_dcos[k] + rot_cos[k]*rot_dsin[k];
+			rot_cos[k] = g;
+		}
+		if((i&(LO_RENORM-1)) == LO_RENORM-1){
+			for(k = 0; k < BANK_lanes; k++){
+				g = 1.5 - 0.5*(rot_cos[k]*rot_cos[k] + rot_sin[k]*rot_sin[k]);
+				rot_cos[k] *= g;
+				rot_sin[k] *= g;
+			}
+		}
+#else
+		for(k = 0; k < BANK_lanes; k++){
+			signal_SinCos(BANK_lut_acc[k], &lo_sin, &lo_cos);
+			x[2*k] = x[TAPS_FIR_LP*BANK_STRIDE+2*k] = 4*sample*lo_cos;
+			x[2*k+1] = x[TAPS_FIR_LP*BANK_STRIDE+2*k+1] = 4*sample*lo_sin;
+			BANK_lut_acc[k] += BANK_lut_inc[k];
+		}
+#endif
+		
+		// Low pass of all lanes at the decimated output rate
+		if(bank_decim_phase == 0){
+			for(k = 0; k < width; k++){
+				acc[k] = 0.0;
+			}
+			for(t = 0; t < TAPS_FIR_LP; t++){
+				c = LP_FIR_coeffs[t];
+#pragma SIMD_for
+				for(k = 0; k < width; k++){
+					acc[k] += c*x[t*BANK_STRIDE+k];
+				}
+			}
+			for(k = 0; k < BANK_lanes; k++){
+				bufferA[outputs+k] = acc[2*k];
+				bufferB[outputs+k] = acc[2*k+1];
+			}
+			outputs += BANK_lanes;
+		}
+		if(++bank_decim_phase == DSP_decimation){
+			bank_decim_phase = 0;
+		}
+		
+		bank_write = (bank_write == 0) ? TAPS_FIR_LP - 1 : bank_write - 1;
+	}
+	
+	return outputs;
+}
+
+/************************************************************
+	Function:	void signal_FFT (float * data, int n)
+	Argument:	float * data - n complex samples, interleaved (re,im)
+				int n - FFT size, power of two up to OLS_FFT_SIZE
+	
+	Return:	
+	
+	Description: In place radix-2 decimation in time FFT.
+		
+	Extra:	The inverse FFT is done by conjugating the input and
+		the output. Uses OLS_twiddles, set by Init_OLS.
+
+************************************************************/
+void signal_FFT(float * data, int n)
+{
+	int i, j, k, span, step;
+	float wr, wi, tr, ti;
+	
+	// Bit reversed reordering
+	j = 0;
+	for(i = 0; i < n-1; i++){
+		if(i < j){
+			tr = data[2*i]; data[2*i] = data[2*j]; data[2*j] = tr;
+			ti = data[2*i+1]; data[2*i+1] = data[2*j+1]; data[2*j+1] = ti;
+		}
+		k = n>>1;
+		while(k <= j){
+			j -= k;
+			k >>= 1;
+		}
+		j += k;
+	}
+	
+	// Butterflies
+	for(span = 1; span < n; span <<= 1){
+		step = OLS_FFT_SIZE/(2*span);
+		for(k = 0; k < span; k++){
+			wr = OLS_twiddles[2*k*step];
+			wi = OLS_twiddles[2*k*step+1];
+			for(i = k; i < n; i += 2*span){
+				j = i + span;
+				tr = wr*data[2*j] - wi*data[2*j+1];
+				ti = wr*data[2*j+1] + wi*data[2*j];
+				data[2*j] = data[2*i] - tr;
+				data[2*j+1] = data[2*i+1] - ti;
+				data[2*i] += tr;
+				data[2*i+1] += ti;
+			}
+		}
+	}
+}
+
+/************************************************************
+	Function:	int Init_OLS (void)
+	Argument:	
+	
+	Return:	DSP_filterEngine
+	
+	Description: Prepares the overlap-save engine (twiddles, filter
+		spectrum, zero history) and selects the cheaper of the direct
+		and overlap-save low pass for the current DSP_decimation.
+		
+	Extra:	Cost per input sample, in MACs:
+			direct			2*TAPS_FIR_LP/DSP_decimation
+			overlap-save	(2 FFTs + spectrum product)/OLS_VALID
+		A butterfly counts as 5 and a complex product as 4.
+		At a decimation of 1 the crossover is about 37 taps.
+
+************************************************************/
+int Init_OLS(void)
+{
+	int k;
+	float angle;
+	unsigned int cost_direct, cost_ols;
+	
+	// Twiddles W^k = exp(-j*2*pi*k/N)
+	for(k = 0; k < OLS_FFT_SIZE/2; k++){
+		angle = 2*DSP_PI*k/OLS_FFT_SIZE;
+		OLS_twiddles[2*k] = cosf(angle);
+		OLS_twiddles[2*k+1] = -sinf(angle);
+	}
+	
+	// Filter spectrum, including the 1/N of the inverse FFT
+	for(k = 0; k < 2*OLS_FFT_SIZE; k++){
+		OLS_H[k] = 0.0;
+	}
+	for(k = 0; k < TAPS_FIR_LP; k++){
+		OLS_H[2*k] = LP_FIR_coeffs[k]/OLS_FFT_SIZE;
+	}
+	signal_FFT(OLS_H, OLS_FFT_SIZE);
+	
+	for(k = 0; k < 2*(TAPS_FIR_LP-1); k++){
+		OLS_in[k] = 0.0;
+	}
+	ols_fill = 0;
+	ols_decim_phase = 0;
+	
+	cost_direct = 2*TAPS_FIR_LP/DSP_decimation;
+	cost_ols = (OLS_FFT_SIZE*OLS_FFT_LOG2*5 + OLS_FFT_SIZE*4)/OLS_VALID;
+	DSP_filterEngine = (cost_direct > cost_ols) ? DSP_ENGINE_OLS : DSP_ENGINE_DIRECT;
+	
+	return DSP_filterEngine;
+}
+
+/************************************************************
+	Function:	int signal_OLS_segment (int valid, float * bufferA, float * bufferB)
+	Argument:	int valid - Number of new samples in OLS_in (up to OLS_VALID)
+				float * bufferA, bufferB - Real and imaginary outputs
+	
+	Return:	Number of decimated outputs written.
+	
+	Description: Filters one overlap-save segment: FFT of the TAPS_FIR_LP-1
+		history samples and the new samples, product with the filter
+		spectrum and inverse FFT. The first TAPS_FIR_LP-1 outputs are
+		circular wrap-around and are discarded.
+		
+	Extra:	
+
+************************************************************/
+int signal_OLS_segment(int valid, float * bufferA, float * bufferB)
+{
+	int i, k;
+	int outputs = 0;
+	float re, im;
+	
+	for(k = 0; k < 2*OLS_FFT_SIZE; k++){
+		OLS_work[k] = OLS_in[k];
+	}
+	signal_FFT(OLS_work, OLS_FFT_SIZE);
+	
+	// Product with the filter spectrum, conjugated for the inverse FFT
+	for(k = 0; k < OLS_FFT_SIZE; k++){
+		re = OLS_work[2*k]*OLS_H[2*k] - OLS_work[2*k+1]*OLS_H[2*k+1];
+		im = OLS_work[2*k]*OLS_H[2*k+1] + OLS_work[2*k+1]*OLS_H[2*k];
+		OLS_work[2*k] = re;
+		OLS_work[2*k+1] = -im;
+	}
+	signal_FFT(OLS_work, OLS_FFT_SIZE);
+	
+	for(i = ols_decim_phase; i < valid; i += DSP_decimation){
+		bufferA[outputs] = OLS_work[2*(TAPS_FIR_LP-1+i)];
+		bufferB[outputs] = -OLS_work[2*(TAPS_FIR_LP-1+i)+1];
+		outputs++;
+	}
+	ols_decim_phase = i - valid;
+	
+	// History for the next segment
+	for(k = 0; k < 2*(TAPS_FIR_LP-1); k++){
+		OLS_in[k] = OLS_in[2*valid+k];
+	}
+	ols_fill = 0;
+	
+	return outputs;
+}
+
+/************************************************************
+	Function:	int signal_OLS_filter (float * bufferI, float * bufferQ, unsigned int block_size,
+						float * bufferA, float * bufferB)
+	Argument:	float * bufferI, bufferQ - Mixed samples
+				unsigned int block_size - Number of mixed samples
+				float * bufferA, bufferB - Real and imaginary outputs
+	
+	Return:	Number of decimated outputs written.
+	
+	Description: Overlap-save replacement of the direct low pass in
+		signal_DemodulateBlock. I and Q form one complex signal so both
+		channels are filtered by the same FFTs. A segment is filtered
+		every OLS_VALID samples.
+		
+	Extra:	Outputs are delayed until their segment is complete.
+		signal_OLS_flush filters the last partial segment.
+
+************************************************************/
+int signal_OLS_filter(float * bufferI, float * bufferQ, unsigned int block_size,
+						float * bufferA, float * bufferB)
+{
+	int i;
+	int outputs = 0;
+	float dm * in;
+	
+	for(i = 0; i < block_size; i++){
+		in = &OLS_in[2*(TAPS_FIR_LP-1+ols_fill)];
+		in[0] = bufferI[i];
+		in[1] = bufferQ[i];
+		ols_fill++;
+		if(ols_fill == OLS_VALID){
+			outputs += signal_OLS_segment(OLS_VALID, &bufferA[outputs], &bufferB[outputs]);
+		}
+	}
+	
+	return outputs;
 }
 
-
 /************************************************************
-	Function:	int signal_QuadratureDemodulation_InternalLO_PtbyPt (float* bufferA,float* bufferB, int total_samples)
-	Argument:	
+	Function:	int signal_OLS_flush (float * bufferA, float * bufferB)
+	Argument:	float * bufferA, bufferB - Real and imaginary outputs
 	
-	Return:	
+	Return:	Number of decimated outputs written.
 	
-	Description: Processes the quadrature demodulation of the IF mode using an internal local oscillator
-		and the samples from channel A corresponding to the probe response data.
-		This demodulation occurs in run time during acquisition
-		It assumes iDDS_lut_inc and iDDS_lut_acc were set.
+	Description: Filters the samples waiting in the last, partial
+		overlap-save segment at the end of an acquisition run.
+		
 	Extra:	
 
 ************************************************************/
-int signal_QuadratureDemodulation_InternalLO_PtbyPt (float* bufferA,float* bufferB,int index)
+int signal_OLS_flush(float * bufferA, float * bufferB)
 {
-
-	//int index = 0;
-	float sampleA;
-	float sampleB;
-	float sampleC;
-//	static float aux[MAX_SAMPLES_BUFFER_SIZE];
-
-
-//	unsigned int inc_ilo_accB = SINE_VALUES_SIZE/4;
-	
-		sampleA = bufferA[index];
-
-		// Sample * Sine
-		//Imaginary
-		bufferB[index] = 4*sampleA*sine_values_lut[((iDDS_lut_acc>>20))];
-
-//		bufferB[index] = 1*sine_values_lut[((inc_ilo_accA>>20)%SINE_VALUES_SIZE)];
-
-
-		// Sample * CoSine
-		// Real values
-		bufferA[index] = 4*sampleA*sine_values_lut[((iDDS_lut_acc>>20)+SINE_VALUES_90_DELAY)%SINE_VALUES_SIZE];
-
-		iDDS_lut_acc = iDDS_lut_acc + iDDS_lut_inc;
-
-		//inc_ilo_accB = ((inc_ilo_accA + inc_ilo))+SINE_VALUES_SIZE/4)%SINE_VALUES_SIZE;
-	//	printf("inc: %d\n", inc_ilo_accA>>20);	
-		signalIIR_lowpassfilter(&bufferA[index], &bufferB[index]);
-
-	
-	return 0;	
+	if(ols_fill == 0){
+		return 0;
+	}
+	return signal_OLS_segment(ols_fill, bufferA, bufferB);
 }
 
-
-
 /************************************************************
 	Function:	int signal_QuadratureDemodulation (float* bufferA,float* bufferB, int total_samples)
 	Argument:	
@@ -302,42 +1700,19 @@ int Init_FIR_BPsoft(){
 	}
 }
 
-/*Adding the TCB for FIR channels
-int FIR_TCB_CH2[13]={
-				0,
-				51,
-				1,
-				memFIRcoeff,
-				memProcessedBufferChB,
-				MAX_SAMPLES_BUFFER_SIZE,
-				1,
-				memProcessedBufferChB+0,
-				memSamplesBufferChB,
-				MAX_SAMPLES_BUFFER_SIZE,
-				1,
-				memSamplesBufferChB+0,
-				(MAX_SAMPLES_BUFFER_SIZE-1)|((MAX_SAMPLES_BUFFER_SIZE-1)<<14)
-			};
-
-
-
-int FIR_TCB_CH1[13]={
-				FIR_TCB_CH2+12,
-				51,
-				1,
-				memFIRcoeff,
-				memProcessedBufferChA,
-				MAX_SAMPLES_BUFFER_SIZE,
-				1,
-				memProcessedBufferChA+0,
-				memSamplesBufferChA,
-				MAX_SAMPLES_BUFFER_SIZE,
-				1,
-				memSamplesBufferChA+0,
-				(MAX_SAMPLES_BUFFER_SIZE-1)|((MAX_SAMPLES_BUFFER_SIZE-1)<<14)
-			};
-
+/* FIR accelerator TCBs for the block low pass offload.
+	One pair of TCBs per window set: CH1 filters I and chains to CH2 (Q),
+	which ends the chain. Filled by FIR_ACC_start.
+	
+	[0]  Chain pointer			[7]  Output index
+	[1]  Coefficient count		[8]  Input base
+	[2]  Coefficient modifier	[9]  Input length
+	[3]  Coefficient index		[10] Input modifier
+	[4]  Output base			[11] Input index
+	[5]  Output length			[12] FIRCTL2 (taps-1 | window-1 <<14)
+	[6]  Output modifier
 */
+int FIR_TCB[FIR_ACC_SETS][2][13];
 
 /*Adding the TCB for IIR channels
 int IIR_TCB_CH2[13]={
@@ -509,27 +1884,230 @@ void Init_IIR(int window_size)
 
 
 /************************************************************
-	Function:		IRQ_FIRConversion(int sig_int)
-	Argument:		sig_int
-	Description:	Called at FIR Accelerator completed
+	Function:	int Init_FIR_offload (void)
+	Argument:	
+	
+	Return:	TRUE
+	
+	Description: Prepares the FIR accelerator for the block low pass
+		offload. Maps the accelerator interrupt to IRQ_FIR, selects the
+		FIR accelerator and returns every window set to the core.
+		
+	Extra:	The first window is preceded by a zero history, taken
+		from the last set with an empty window.
+
+************************************************************/
+int Init_FIR_offload(void)
+{
+	int temp, k;
+	
+	// Stops any previous accelerator run
+	*pFIRCTL1 = 0;
+	
+	//Mapping the FIR DMA interrupt
+	temp=*pPICR0;
+	temp&=~(P5I0|P5I1|P5I2|P5I3|P5I4);
+	temp|=P5I0|P5I1|P5I3|P5I4;
+	*pPICR0=temp;
+
+	interrupt(SIG_P5,IRQ_FIR);
+	
+	//Selecting the FIR Accelerator
+	temp=*pPMCTL1;
+	temp&=~(BIT_17|BIT_18);
+	temp|=FIRACCSEL;
+	*pPMCTL1=temp;
+	
+	//PMCTL1 effect latency
+		asm("nop;nop;nop;nop;");
+	
+	for(k = 0; k < FIR_ACC_SETS; k++){
+		FIR_ACCstate[k] = FIR_ACC_IDLE;
+		FIR_ACCwindow[k] = 0;
+	}
+	for(k = 0; k < TAPS_FIR_LP-1; k++){
+		FIR_ACCinI[FIR_ACC_SETS-1][k] = 0.0;
+		FIR_ACCinQ[FIR_ACC_SETS-1][k] = 0.0;
+	}
+	fir_acc_fill = 0;
+	fir_acc_read = 0;
+	fir_acc_pending = 0;
+	block_decim_phase = 0;
+	DSP_processingFIR = FALSE;
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	void FIR_ACC_start (int set)
+	Argument:	int set - Window set to filter
+	
+	Return:	
+	
+	Description: Fills the TCB pair of a window set and starts the
+		accelerator on it. The set must be FIR_ACC_QUEUED.
+		
+	Extra:	Called from the main loop when the accelerator is idle
+		and from IRQ_FIR to chain the next queued set.
+
+************************************************************/
+void FIR_ACC_start(int set)
+{
+	int ch;
+	int window = FIR_ACCwindow[set];
+	float * input;
+	float * output;
+	
+	for(ch = 0; ch < 2; ch++){
+		input = ch ? FIR_ACCinQ[set] : FIR_ACCinI[set];
+		output = ch ? FIR_ACCoutQ[set] : FIR_ACCoutI[set];
 		
+		FIR_TCB[set][ch][0] = ch ? 0 : (int)(FIR_TCB[set][1]+12);
+		FIR_TCB[set][ch][1] = TAPS_FIR_LP;
+		FIR_TCB[set][ch][2] = 1;
+		FIR_TCB[set][ch][3] = (int)LP_FIR_coeffs;
+		FIR_TCB[set][ch][4] = (int)output;
+		FIR_TCB[set][ch][5] = window;
+		FIR_TCB[set][ch][6] = 1;
+		FIR_TCB[set][ch][7] = (int)output;
+		FIR_TCB[set][ch][8] = (int)input;
+		FIR_TCB[set][ch][9] = TAPS_FIR_LP-1+window;
+		FIR_TCB[set][ch][10] = 1;
+		FIR_TCB[set][ch][11] = (int)input;
+		FIR_TCB[set][ch][12] = (TAPS_FIR_LP-1)|((window-1)<<14);
+	}
+	
+	FIR_ACCstate[set] = FIR_ACC_BUSY;
+	DSP_processingFIR = TRUE;
+	
+	// Must clear DMAEN to reload new data on the buffers to the DMA
+	*pFIRCTL1&=~(FIR_DMAEN);
+	
+		//Initializing the chain pointer register
+	*pCPFIR=(int)(FIR_TCB[set][0]+12)-0x80000;
+
+	//Now Enabling the FIR Accelerator
+	*pFIRCTL1=FIR_EN|FIR_DMAEN|FIR_CH2|FIR_RND0;
+}
+
+/************************************************************
+	Function:		IRQ_FIR(int sig_int)
+	Argument:		sig_int
+	Description:	Called at FIR Accelerator completed.
+		Hands the filtered set back to the core and starts the
+		next queued set, if there is one.
 			
 ************************************************************/
 void IRQ_FIR()
 {
+	int k, next;
 	
-
+	*pFIRCTL1 = 0;
+	
+	for(k = 0; k < FIR_ACC_SETS; k++){
+		if(FIR_ACCstate[k] == FIR_ACC_BUSY){
+			FIR_ACCstate[k] = FIR_ACC_DONE;
+			next = (k+1)%FIR_ACC_SETS;
+			if(FIR_ACCstate[next] == FIR_ACC_QUEUED){
+				FIR_ACC_start(next);
+				return;
+			}
+			break;
+		}
+	}
 	
-//	USB_sendADCData(AR_totalSamples,(unsigned int*)memProcessedBufferChA);
-//	adc_buffer_to_send = (unsigned int*)memProcessedBufferChA;
-//	adc_number_of_samples_to_send = AR_totalSamples;
-//	adc_send_continuous_samples = 1;
-//	SIG_LED2_OFF;
-//	adc_sample_buffer_full = 1;
-//	adc_send_continuous_samples = 1;
 	DSP_processingFIR = FALSE;
 }
 
+/************************************************************
+	Function:	int DSP_ProcessBlocksFIR (void)
+	Argument:	
+	
+	Return:	TRUE if the acquisition run was completed by this call.
+	
+	Description: FIR accelerator version of DSP_ProcessBlocks.
+		Window sets rotate between three owners:
+			core (IDLE)	- mixes a block into the set input buffers
+			queued/accelerator (QUEUED, BUSY) - filters the set
+			core (DONE)	- copies the decimated outputs to AR_bufferChA/B
+		While the accelerator filters one set the core mixes the next,
+		keeps acquiring and serves the USB.
+		
+	Extra:	Each set input holds the TAPS_FIR_LP-1 samples preceding the
+		window, copied from the previous set, followed by the window.
+		Windows are only handed over while all their outputs fit in
+		the sample buffers, as in DSP_ProcessBlocks.
+
+************************************************************/
+int DSP_ProcessBlocksFIR(void)
+{
+	unsigned int available, block, prev, outputs;
+	int i, set;
+	int window_max = (DSP_blockSize < FIR_ACC_WINDOW) ? DSP_blockSize : FIR_ACC_WINDOW;
+	
+	// Outputs of the filtered sets, in order
+	while(FIR_ACCstate[fir_acc_read] == FIR_ACC_DONE){
+		set = fir_acc_read;
+		for(i = FIR_ACCphase[set]; i < FIR_ACCwindow[set]; i += DSP_decimation){
+			AR_bufferChA[AR_bufferIndex] = FIR_ACCoutI[set][i];
+			AR_bufferChB[AR_bufferIndex] = FIR_ACCoutQ[set][i];
+			AR_bufferIndex++;
+			fir_acc_pending--;
+		}
+		FIR_ACCstate[set] = FIR_ACC_IDLE;
+		fir_acc_read = (set+1)%FIR_ACC_SETS;
+	}
+	
+	// New windows for the free sets
+	available = AR_rawIndex - DSP_blockIndex;
+	while(FIR_ACCstate[fir_acc_fill] == FIR_ACC_IDLE
+			&& (available >= window_max || (AR_rawFinished && available > 0))){
+		set = fir_acc_fill;
+		prev = (set+FIR_ACC_SETS-1)%FIR_ACC_SETS;
+		block = (available < window_max) ? available : window_max;
+		
+		// A window that could write past the sample buffers ends the run
+		outputs = (block > block_decim_phase) ? (block-block_decim_phase+DSP_decimation-1)/DSP_decimation : 0;
+		if(AR_bufferIndex + fir_acc_pending + outputs > MAX_SAMPLES_BUFFER_SIZE){
+			DSP_ProcessOverflow();
+			available = 0;
+			break;
+		}
+		fir_acc_pending += outputs;
+		
+		for(i = 0; i < TAPS_FIR_LP-1; i++){
+			FIR_ACCinI[set][i] = FIR_ACCinI[prev][FIR_ACCwindow[prev]+i];
+			FIR_ACCinQ[set][i] = FIR_ACCinQ[prev][FIR_ACCwindow[prev]+i];
+		}
+		signal_MixBlock(SAMPLES_MEMORY, DSP_blockIndex, block,
+					&FIR_ACCinI[set][TAPS_FIR_LP-1], &FIR_ACCinQ[set][TAPS_FIR_LP-1]);
+		
+		FIR_ACCwindow[set] = block;
+		FIR_ACCphase[set] = block_decim_phase;
+		for(i = block_decim_phase; i < block; i += DSP_decimation);
+		block_decim_phase = i - block;
+		
+		DSP_blockIndex += block;
+		available = AR_rawIndex - DSP_blockIndex;
+		fir_acc_fill = (set+1)%FIR_ACC_SETS;
+		
+		FIR_ACCstate[set] = FIR_ACC_QUEUED;
+		if(DSP_processingFIR == FALSE){
+			FIR_ACC_start(set);
+		}
+	}
+	
+	if(AR_rawFinished && available == 0 && DSP_processingFIR == FALSE
+			&& FIR_ACCstate[fir_acc_read] == FIR_ACC_IDLE){
+		AR_rawFinished = FALSE;
+		if(AR_bufferIndex > 0) AR_bufferIndex--;
+		ADC_FinishedAR();
+		return TRUE;
+	}
+	
+	return FALSE;
+}
+
 
 
 /************************************************************
@@ -548,49 +2126,305 @@ void IRQ_FIR()
 		1. Separate ChA samples from ChB
 		2. Convert to float
 		3. Subtract corresponding calibration
-		4. Calculate Amplitude
-		5. Calculate Phase
+		4. Calculate Amplitude and Phase with DSP_MagnitudePhase
 	
 		Amplitude = sqrt(I^2+Q^2)
-		Phase = arctan(Q/I)
+		Phase = atan2(Q,I), full quadrant
 		
 ************************************************************/
 int DSP_ModeIQ_AmplitudePhase(unsigned int buffer_size, unsigned int * samples_buffer,
 								 float * buffer_amplitude, float * buffer_phase)
 {
 	int index;
-	float sample_chA, sample_chB;
 	
-	float amplitude, phase;
 	//unsigned short * samples_buffer16 = (unsigned short *) samples_buffer;
 //	a1 = ((k>>16)&0xffff)*2.5/65536;
 //	a2 = (k&0xffff)*2.5/65536;	
 	for(index = 0; index < buffer_size; index++)
 	{
-		// 1 and 2
-		sample_chA = (float) ((samples_buffer[index]&0xffff)-CAL_chA_calibration)*2.5/65536;
-		sample_chB = (float) (((samples_buffer[index]>>16)&0xffff)- CAL_chB_calibration)*2.5/65536;
-		
-		// 3.
-	//	sample_chA = sample_chA - CAL_chA_calibration;
-	//	sample_chB = sample_chB - CAL_chB_calibration;
+		// 1, 2 and 3. I and Q are kept in the output buffers
+		buffer_amplitude[index] = (float) ((samples_buffer[index]&0xffff)-CAL_chA_calibration)*2.5/65536;
+		buffer_phase[index] = (float) (((samples_buffer[index]>>16)&0xffff)- CAL_chB_calibration)*2.5/65536;
+	}
+	
+	// 4.
+	DSP_MagnitudePhase(buffer_size, buffer_amplitude, buffer_phase,
+						buffer_amplitude, buffer_phase, PHASE_PRECISE);
+	
+	return TRUE;
+	
+	
+}
+
+
+
+/************************************************************
+	Function:	int DSP_MagnitudePhase (unsigned int buffer_size, float * bufferI, float * bufferQ,
+						float * buffer_amplitude, float * buffer_phase, int accuracy)
+	Argument:	unsigned int buffer_size - Number of samples
+				float * bufferI, bufferQ - Real and imaginary samples
+				float * buffer_amplitude, buffer_phase - Outputs, may be the inputs
+				int accuracy - PHASE_FAST or PHASE_PRECISE
+	
+	Return:	TRUE
+	
+	Description: Full quadrant magnitude and phase (-pi to pi) of a block.
+		With a = min(|I|,|Q|)/max(|I|,|Q|) in [0,1]:
+			phase = atan(a), then folded into the quadrant of (I,Q)
+			magnitude = max(|I|,|Q|)*sqrt(1+a^2)
+		I = Q = 0 gives 0 for both.
 		
-		// 4.
-		amplitude = sample_chA*sample_chA+sample_chB*sample_chB;
-		amplitude = sqrtf(amplitude);
+	Extra:	The loops have no branches, the foldings are selects (min/max
+		and conditional moves on the SHARC), so they can be vectorized.
+		PHASE_FAST: minimax polynomials of 3 terms, errors 6.1e-4 rad
+			and 7.6e-4 relative.
+		PHASE_PRECISE: Abramowitz & Stegun 4.4.49 (error 2e-8 rad) and
+			sqrtf for the magnitude.
+
+************************************************************/
+int DSP_MagnitudePhase(unsigned int buffer_size, float * bufferI, float * bufferQ,
+						float * buffer_amplitude, float * buffer_phase, int accuracy)
+{
+	int k;
+	float x, y, ax, ay, mn, mx, a, t, r;
+	
+	if(accuracy == PHASE_FAST){
+		for(k = 0; k < buffer_size; k++){
+			x = bufferI[k];
+			y = bufferQ[k];
+			ax = fabsf(x);
+			ay = fabsf(y);
+			mx = (ax > ay) ? ax : ay;
+			mn = (ax > ay) ? ay : ax;
+			a = mn/(mx + 1.0e-30);
+			t = a*a;
+			r = a*(0.99535606 + t*(-0.28867943 + t*0.07932777));
+			buffer_amplitude[k] = mx*(1.00076164 + t*(0.48388993 - t*0.07119988));
+			r = (ay > ax) ? DSP_PI/2 - r : r;
+			r = (x < 0) ? DSP_PI - r : r;
+			buffer_phase[k] = (y < 0) ? -r : r;
+		}
+	}else{
+		for(k = 0; k < buffer_size; k++){
+			x = bufferI[k];
+			y = bufferQ[k];
+			ax = fabsf(x);
+			ay = fabsf(y);
+			mx = (ax > ay) ? ax : ay;
+			mn = (ax > ay) ? ay : ax;
+			a = mn/(mx + 1.0e-30);
+			t = a*a;
+			r = a*(1.0 + t*(-0.3333314528 + t*(0.1999355085 + t*(-0.1420889944
+				+ t*(0.1065626393 + t*(-0.0752896400 + t*(0.0429096138
+				+ t*(-0.0161657367 + t*0.0028662257))))))));
+			buffer_amplitude[k] = mx*sqrtf(1.0 + t);
+			r = (ay > ax) ? DSP_PI/2 - r : r;
+			r = (x < 0) ? DSP_PI - r : r;
+			buffer_phase[k] = (y < 0) ? -r : r;
+		}
+	}
+	
+	return TRUE;
+}
+
+/************************************************************
+	Function:	unsigned long long DSP_timestamp (void)
+	Argument:	
+	
+	Return:	Core cycles since reset.
+	
+	Description: Reads the 64 bit core cycle counter, EMUCLK2:EMUCLK.
+		The high word is read again to catch a carry between the
+		two reads.
 		
-		//5. 
-		phase = sample_chB/sample_chA;
-		phase = atanf(phase);
+	Extra:	Safe from interrupts and from the main loop.
+
+************************************************************/
+unsigned long long DSP_timestamp(void)
+{
+#ifdef __ADSP21000__
+	unsigned int high, low, check;
+	
+	do{
+		asm volatile("%0 = emuclk2;" : "=d"(high));
+		asm volatile("%0 = emuclk;" : "=d"(low));
+		asm volatile("%0 = emuclk2;" : "=d"(check));
+	}while(high != check);
+	
+	return ((unsigned long long)high<<32) | low;
+#else
+	// Host build: nanoseconds
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec*1000000000 + now.tv_nsec;
+#endif
+}
+
+/************************************************************
+	Function:	unsigned int DSP_cycles (void)
+	Argument:	
+	
+	Return:	Low word of the core cycle counter.
+	
+	Description: Time base of the profiler (PROF_ENTER, PROF_EXIT).
+		Differences are valid up to 2^32 cycles.
 		
-		buffer_amplitude[index] = amplitude;
-		buffer_phase[index] = phase;
+	Extra:	The host build counts nanoseconds, so host kernel
+		benchmarks use the same macros.
+
+************************************************************/
+unsigned int DSP_cycles(void)
+{
+#ifdef __ADSP21000__
+	unsigned int low;
+	
+	asm volatile("%0 = emuclk;" : "=d"(low));
+	return low;
+#else
+	return (unsigned int)DSP_timestamp();
+#endif
+}
+
+/************************************************************
+	Function:	void DSP_profile (int isr, unsigned int entry, unsigned int exit)
+	Argument:	int isr - PROF_ADC_SAMPLE, PROF_ADC_BLOCK, PROF_STEPPER or PROF_ALIVE
+				unsigned int entry, exit - DSP_cycles at ISR entry and exit
+	
+	Return:	
+	
+	Description: Adds one ISR run to the profiler statistics: count,
+		min/max duration, duration histogram, longest time between
+		entries and missed deadlines.
 		
+	Extra:	Called by PROF_EXIT, from the ISR itself.
+
+************************************************************/
+void DSP_profile(int isr, unsigned int entry, unsigned int exit)
+{
+	unsigned int cycles = exit - entry;
+	unsigned int gap = entry - PROF_lastEntry[isr];
+	unsigned int deadline = PROF_deadline[isr];
+	int bucket;
+	
+	if(PROF_gapValid[isr]){
+		if(gap > PROF_maxGap[isr]) PROF_maxGap[isr] = gap;
+		if(deadline && gap > deadline + deadline/2) PROF_missed[isr]++;
+	}
+	if(deadline && cycles > deadline) PROF_missed[isr]++;
+	PROF_lastEntry[isr] = entry;
+	PROF_gapValid[isr] = TRUE;
+	
+	if(PROF_count[isr] == 0 || cycles < PROF_min[isr]) PROF_min[isr] = cycles;
+	if(cycles > PROF_max[isr]) PROF_max[isr] = cycles;
+	PROF_count[isr]++;
+	
+	cycles >>= PROF_BUCKET_LOG2;
+	for(bucket = 0; cycles && bucket < PROF_BUCKETS-1; bucket++){
+		cycles >>= 1;
+	}
+	PROF_hist[isr][bucket]++;
+}
+
+/************************************************************
+	Function:	void DSP_profileRestart (int isr, unsigned int deadline)
+	Argument:	int isr - ISR to restart
+				unsigned int deadline - Deadline in core cycles, 0 for none
+	
+	Return:	
+	
+	Description: Sets the deadline of an ISR and forgets its last
+		entry, so the pause between two runs is not taken as a
+		missed deadline. The statistics are kept.
 		
+	Extra:	
+
+************************************************************/
+void DSP_profileRestart(int isr, unsigned int deadline)
+{
+	PROF_deadline[isr] = deadline;
+	PROF_gapValid[isr] = FALSE;
+}
+
+/************************************************************
+	Function:	void DSP_profileClear (void)
+	Argument:	
+	
+	Return:	
+	
+	Description: Clears the statistics of every ISR. Deadlines are kept.
 		
+	Extra:	
+
+************************************************************/
+void DSP_profileClear(void)
+{
+	int isr, k;
+	
+	for(isr = 0; isr < PROF_ISRS; isr++){
+		PROF_count[isr] = 0;
+		PROF_min[isr] = 0;
+		PROF_max[isr] = 0;
+		PROF_maxGap[isr] = 0;
+		PROF_missed[isr] = 0;
+		PROF_gapValid[isr] = FALSE;
+		for(k = 0; k < PROF_BUCKETS; k++){
+			PROF_hist[isr][k] = 0;
+		}
 	}
+}
+
+/************************************************************
+	Function:	int DSP_MagnitudePhaseCORDIC (unsigned int buffer_size, int * bufferI, int * bufferQ,
+						int * buffer_amplitude, unsigned int * buffer_phase)
+	Argument:	unsigned int buffer_size - Number of samples
+				int * bufferI, bufferQ - 16 bit signed real and imaginary samples
+				int * buffer_amplitude - Magnitude, same scale as the inputs
+				unsigned int * buffer_phase - Phase, 2^32 = 360 degrees
 	
-	return TRUE;
+	Return:	TRUE
+	
+	Description: Fixed point magnitude and phase by CORDIC vectoring, for
+		builds without floating point. Samples in the left half plane are
+		first rotated by 180 degrees, then CORDIC_ITERATIONS shift and add
+		micro rotations drive Q to 0. The rotated I is the magnitude times
+		the CORDIC gain and the accumulated angle is the phase.
+		
+	Extra:	The rotation direction is applied as a sign mask (v^m)-m, so
+		the loops have no branches.
+		Magnitude error within 1 LSB, phase error set by the inputs.
+
+************************************************************/
+int DSP_MagnitudePhaseCORDIC(unsigned int buffer_size, int * bufferI, int * bufferQ,
+						int * buffer_amplitude, unsigned int * buffer_phase)
+{
+	int k, i, m, x, y, dx, dy;
+	unsigned int z;
 	
+	for(k = 0; k < buffer_size; k++){
+		x = bufferI[k]<<CORDIC_SHIFT;
+		y = bufferQ[k]<<CORDIC_SHIFT;
+		
+		// Left half plane rotated by 180 degrees
+		m = x>>31;
+		x = (x^m)-m;
+		y = (y^m)-m;
+		z = m & 0x80000000;
+		
+		for(i = 0; i < CORDIC_ITERATIONS; i++){
+			m = y>>31;
+			dx = ((y>>i)^m)-m;
+			dy = ((x>>i)^m)-m;
+			x += dx;
+			y -= dy;
+			z += (CORDIC_atan[i]^m)-m;
+		}
+		
+		// x*CORDIC_GAIN_Q16/65536 in two halves to stay within 32 bits
+		x = (x>>16)*CORDIC_GAIN_Q16 + (((unsigned int)(x&0xffff)*CORDIC_GAIN_Q16)>>16);
+		buffer_amplitude[k] = (x + (1<<(CORDIC_SHIFT-1)))>>CORDIC_SHIFT;
+		buffer_phase[k] = z;
+	}
 	
+	return TRUE;
 }